@@ -0,0 +1,132 @@
+#include "bench_report.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "err.h"
+
+void samples_init(BenchSamples* samples, size_t capacity)
+{
+    samples->values = malloc(capacity * sizeof(double));
+    if (!samples->values)
+        fatal("Out of memory for %zu samples", capacity);
+    samples->count = 0;
+    samples->capacity = capacity;
+}
+
+void samples_destroy(BenchSamples* samples)
+{
+    free(samples->values);
+    samples->values = NULL;
+}
+
+void samples_add(BenchSamples* samples, double value)
+{
+    if (samples->count < samples->capacity)
+        samples->values[samples->count++] = value;
+}
+
+static int compare_doubles(const void* a, const void* b)
+{
+    double const x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of sorted values. */
+static double percentile(double const* sorted, size_t count, double p)
+{
+    size_t rank = (size_t)(p / 100.0 * count + 0.999999);
+    if (rank < 1)
+        rank = 1;
+    if (rank > count)
+        rank = count;
+    return sorted[rank - 1];
+}
+
+void report_open(BenchReport* report, int argc, char** argv)
+{
+    report->out = stdout;
+    report->format = REPORT_TEXT;
+    report->n_results = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format=text") == 0) {
+            report->format = REPORT_TEXT;
+        } else if (strcmp(argv[i], "--format=csv") == 0) {
+            report->format = REPORT_CSV;
+        } else if (strcmp(argv[i], "--format=json") == 0) {
+            report->format = REPORT_JSON;
+        } else if (strncmp(argv[i], "--output=", 9) == 0) {
+            report->out = fopen(argv[i] + 9, "w");
+            if (!report->out)
+                syserr("Cannot open %s", argv[i] + 9);
+        } else {
+            fprintf(stderr, "Usage: %s [--format=text|csv|json] [--output=PATH]\n", argv[0]);
+            exit(2);
+        }
+    }
+
+    if (report->format == REPORT_CSV)
+        fprintf(report->out, "benchmark,params,unit,count,min,mean,p50,p90,p99,p999,max\n");
+    else if (report->format == REPORT_JSON)
+        fprintf(report->out, "[");
+}
+
+void report_add(BenchReport* report, const char* benchmark, const char* params, const char* unit,
+    BenchSamples const* samples)
+{
+    size_t const n = samples->count;
+    double* sorted = malloc((n ? n : 1) * sizeof(double));
+    if (!sorted)
+        fatal("Out of memory");
+    memcpy(sorted, samples->values, n * sizeof(double));
+    qsort(sorted, n, sizeof(double), compare_doubles);
+
+    double sum = 0;
+    for (size_t i = 0; i < n; i++)
+        sum += sorted[i];
+    double const min = n ? sorted[0] : 0, max = n ? sorted[n - 1] : 0, mean = n ? sum / n : 0;
+    double const p50 = n ? percentile(sorted, n, 50) : 0, p90 = n ? percentile(sorted, n, 90) : 0;
+    double const p99 = n ? percentile(sorted, n, 99) : 0, p999 = n ? percentile(sorted, n, 99.9) : 0;
+    free(sorted);
+
+    switch (report->format) {
+    case REPORT_TEXT:
+        fprintf(report->out,
+            "%-16s %-20s n=%-7zu mean %10.1f  p50 %10.1f  p90 %10.1f  p99 %10.1f  max %10.1f %s\n",
+            benchmark, params, n, mean, p50, p90, p99, max, unit);
+        break;
+    case REPORT_CSV:
+        fprintf(report->out, "%s,%s,%s,%zu,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n", benchmark, params,
+            unit, n, min, mean, p50, p90, p99, p999, max);
+        break;
+    case REPORT_JSON:
+        fprintf(report->out,
+            "%s\n  {\"benchmark\": \"%s\", \"params\": \"%s\", \"unit\": \"%s\", \"count\": %zu, "
+            "\"min\": %.1f, \"mean\": %.1f, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, "
+            "\"p999\": %.1f, \"max\": %.1f}",
+            report->n_results ? "," : "", benchmark, params, unit, n, min, mean, p50, p90, p99,
+            p999, max);
+        break;
+    }
+    fflush(report->out);
+    report->n_results++;
+}
+
+void report_close(BenchReport* report)
+{
+    if (report->format == REPORT_JSON)
+        fprintf(report->out, "\n]\n");
+    if (report->out != stdout)
+        fclose(report->out);
+    else
+        fflush(report->out);
+}
+
+uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
@@ -0,0 +1,56 @@
+#ifndef BENCH_REPORT_H
+#define BENCH_REPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/** Measurements of one benchmark, e.g., one latency per round trip. */
+typedef struct BenchSamples {
+    double* values;
+    size_t count;
+    size_t capacity;
+} BenchSamples;
+
+void samples_init(BenchSamples* samples, size_t capacity);
+void samples_destroy(BenchSamples* samples);
+
+/** Records a measurement (beyond the capacity, measurements are ignored). */
+void samples_add(BenchSamples* samples, double value);
+
+/** Output format of a report, chosen with `--format=text|csv|json`. */
+typedef enum ReportFormat {
+    REPORT_TEXT,
+    REPORT_CSV,
+    REPORT_JSON,
+} ReportFormat;
+
+/** Where (and how) benchmark results are written. */
+typedef struct BenchReport {
+    FILE* out;
+    ReportFormat format;
+    size_t n_results;
+} BenchReport;
+
+/**
+ * Opens a report as requested on the command line: `--format=text|csv|json` (text by default)
+ * and `--output=PATH` (stdout by default). Exits with a usage message on bad arguments.
+ */
+void report_open(BenchReport* report, int argc, char** argv);
+
+/**
+ * Adds the summary of a benchmark: count, min, mean, p50, p90, p99, p99.9 and max.
+ *
+ * `params` describes the configuration (e.g., "threads=2"), `unit` the unit of the samples.
+ * Percentiles use the nearest-rank method.
+ */
+void report_add(BenchReport* report, const char* benchmark, const char* params, const char* unit,
+    BenchSamples const* samples);
+
+/** Finishes the report (closes the JSON array, and the output file if any). */
+void report_close(BenchReport* report);
+
+/** Monotonic time in nanoseconds. */
+uint64_t bench_now_ns(void);
+
+#endif // BENCH_REPORT_H
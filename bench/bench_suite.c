@@ -0,0 +1,1281 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench_report.h"
+#include "err.h"
+#include "executor.h"
+#include "future.h"
+#include "future_combinators.h"
+#include "future_examples.h"
+#include "future_sockets.h"
+#include "mio.h"
+
+// The benchmark suite: spawn throughput (also of futures allocated from the executor's arena,
+// against malloc/free), ping-pong latency over pipes, N-way join fan-out and the latency of a
+// wake through Mio (when idle, with and without a spin phase before blocking, and while other
+// futures keep the executor busy, for several poll intervals), and wakes and spawns coming from
+// another thread, the latency of a light future next to one reading a firehose (with and without a
+// task budget), gather writes of small segments against copying them into one buffer first, the
+// throughput of forwarding a pipe to another with splice() against reading then writing, and a TCP
+// echo server over loopback (requests and connections handled per second and per core), and UDP
+// datagrams over loopback moved with recvmmsg()/sendmmsg() in batches against one at a time. Each
+// benchmark reports the distribution of its samples (see bench_report.h for the output formats):
+//   bench_suite [--format=text|csv|json] [--output=PATH]
+
+#define SPAWN_BATCH 1000
+#define SPAWN_SAMPLES 200
+#define CHURN_BATCH 100
+#define CHURN_ROUNDS 100
+#define CHURN_SAMPLES 100
+#define PING_PONG_ROUNDS 20000
+#define FAN_OUT_SAMPLES 50
+#define WAKE_ROUNDS 2000
+#define BUSY_FUTURES 4
+#define BUSY_SLICE_NS 2000
+#define REMOTE_WAKE_ROUNDS 2000
+#define REMOTE_SPAWNS 10000
+#define REMOTE_SPAWN_SAMPLES 20
+#define FAIRNESS_ROUNDS 2000
+#define FIREHOSE_READ (4 << 20)
+#define MAX_SEGMENTS 16
+#define MAX_FRAME_BYTES (64 * 1024)
+#define FRAMES 2000
+#define FRAME_SAMPLES 20
+#define FORWARD_BYTES (64 << 20)
+#define FORWARD_CHUNK (256 * 1024)
+#define FORWARD_SAMPLES 10
+#define ECHO_CLIENTS 64 // Concurrent client connections.
+#define ECHO_MESSAGE 64
+#define ECHO_ACCEPT_BATCH 64
+#define ECHO_SAMPLES 5
+#define UDP_PACKETS 100000 // Datagrams per sample.
+#define UDP_PAYLOAD 64
+#define UDP_MAX_BATCH 64
+#define UDP_WINDOW 128 // Datagrams in flight at most (fits the receive buffer: none dropped).
+#define UDP_SAMPLES 5
+
+static BenchReport report;
+
+/** Completes on its first progress. */
+static FutureState ready_progress(Future* base, Mio* mio, Waker waker)
+{
+    return FUTURE_COMPLETED;
+}
+
+/** Pending once (waking itself), then complete: one trip through the run queue. */
+typedef struct YieldFuture {
+    Future base;
+    bool yielded;
+} YieldFuture;
+
+static FutureState yield_progress(Future* base, Mio* mio, Waker waker)
+{
+    YieldFuture* self = (YieldFuture*)base;
+    if (self->yielded)
+        return FUTURE_COMPLETED;
+    self->yielded = true;
+    waker_wake(&waker);
+    return FUTURE_PENDING;
+}
+
+static void make_nonblocking_pipe(int fds[2])
+{
+    ASSERT_SYS_OK(pipe2(fds, O_NONBLOCK));
+}
+
+/* Reads one byte, returning false if there was none. */
+static bool read_byte(int fd)
+{
+    char byte;
+    ssize_t n = read(fd, &byte, 1);
+    if (n == 1)
+        return true;
+    if (n < 0 && errno != EAGAIN)
+        syserr("read");
+    return false;
+}
+
+static void write_byte(int fd)
+{
+    char byte = 'x';
+    ASSERT_SYS_OK(write(fd, &byte, 1));
+}
+
+/* Spawn and run batches of futures that complete right away: cost per future. */
+static void bench_spawn(void)
+{
+    static Future futs[SPAWN_BATCH];
+    BenchSamples samples;
+    samples_init(&samples, SPAWN_SAMPLES);
+
+    Executor* executor = executor_create(0);
+    for (int s = 0; s < SPAWN_SAMPLES; s++) {
+        uint64_t start = bench_now_ns();
+        for (int i = 0; i < SPAWN_BATCH; i++) {
+            futs[i] = future_create(ready_progress);
+            executor_spawn(executor, &futs[i]);
+        }
+        executor_run(executor);
+        samples_add(&samples, (double)(bench_now_ns() - start) / SPAWN_BATCH);
+    }
+    executor_destroy(executor);
+
+    char params[64];
+    snprintf(params, sizeof(params), "batch=%d", SPAWN_BATCH);
+    report_add(&report, "spawn_run", params, "ns/future", &samples);
+    samples_destroy(&samples);
+}
+
+/** Spawns CHURN_BATCH futures that complete right away per progress, CHURN_ROUNDS times,
+ * allocating them from the executor's arena, or with malloc (freeing the previous batch, which
+ * has completed by then). */
+typedef struct ChurnFuture {
+    Future base;
+    bool use_arena;
+    int rounds_left;
+    Future* batch[CHURN_BATCH]; // The malloc()ed ones.
+} ChurnFuture;
+
+static FutureState churn_progress(Future* base, Mio* mio, Waker waker)
+{
+    ChurnFuture* self = (ChurnFuture*)base;
+    Executor* executor = (Executor*)waker.executor;
+    for (int i = 0; i < CHURN_BATCH && !self->use_arena; i++) {
+        free(self->batch[i]);
+        self->batch[i] = NULL;
+    }
+    if (self->rounds_left-- == 0)
+        return FUTURE_COMPLETED;
+    for (int i = 0; i < CHURN_BATCH; i++) {
+        Future* fut = self->use_arena ? executor_alloc_future(executor, sizeof(Future))
+                                      : malloc(sizeof(Future));
+        if (!fut)
+            fatal("Out of memory");
+        *fut = future_create(ready_progress);
+        executor_spawn(executor, fut);
+        if (!self->use_arena)
+            self->batch[i] = fut;
+    }
+    waker_wake(&waker);
+    return FUTURE_PENDING;
+}
+
+/* Spawn and complete heap-allocated futures: cost per future, arena against malloc/free. */
+static void bench_spawn_churn(bool use_arena)
+{
+    static ChurnFuture churn;
+    BenchSamples samples;
+    samples_init(&samples, CHURN_SAMPLES);
+
+    Executor* executor = executor_create(0);
+    for (int s = 0; s < CHURN_SAMPLES; s++) {
+        churn = (ChurnFuture) {
+            .base = future_create(churn_progress),
+            .use_arena = use_arena,
+            .rounds_left = CHURN_ROUNDS,
+        };
+        uint64_t start = bench_now_ns();
+        executor_spawn(executor, (Future*)&churn);
+        executor_run(executor);
+        samples_add(&samples, (double)(bench_now_ns() - start) / (CHURN_ROUNDS * CHURN_BATCH));
+    }
+    executor_destroy(executor);
+
+    char params[64];
+    snprintf(params, sizeof(params), "alloc=%s,batch=%d", use_arena ? "arena" : "malloc",
+        CHURN_BATCH);
+    report_add(&report, "spawn_churn", params, "ns/future", &samples);
+    samples_destroy(&samples);
+}
+
+/** Sends a byte to the ponger and waits for the answer, PING_PONG_ROUNDS times. */
+typedef struct PingFuture {
+    Future base;
+    int out_fd, in_fd;
+    bool sent;
+    uint64_t sent_at;
+    int rounds;
+    BenchSamples* samples;
+} PingFuture;
+
+static FutureState ping_progress(Future* base, Mio* mio, Waker waker)
+{
+    PingFuture* self = (PingFuture*)base;
+    for (;;) {
+        if (!self->sent) {
+            self->sent_at = bench_now_ns();
+            write_byte(self->out_fd);
+            self->sent = true;
+        }
+        if (!read_byte(self->in_fd)) {
+            // Registering again is free with epoll, and re-arms the one-shot io_uring poll.
+            ASSERT_SYS_OK(mio_register(mio, self->in_fd, EPOLLIN, waker));
+            return FUTURE_PENDING;
+        }
+        samples_add(self->samples, (double)(bench_now_ns() - self->sent_at));
+        self->sent = false;
+        if (++self->rounds == PING_PONG_ROUNDS) {
+            ASSERT_SYS_OK(mio_unregister(mio, self->in_fd));
+            return FUTURE_COMPLETED;
+        }
+    }
+}
+
+/** Answers every byte from the pinger. */
+typedef struct PongFuture {
+    Future base;
+    int out_fd, in_fd;
+    int rounds;
+} PongFuture;
+
+static FutureState pong_progress(Future* base, Mio* mio, Waker waker)
+{
+    PongFuture* self = (PongFuture*)base;
+    while (read_byte(self->in_fd)) {
+        write_byte(self->out_fd);
+        if (++self->rounds == PING_PONG_ROUNDS) {
+            ASSERT_SYS_OK(mio_unregister(mio, self->in_fd));
+            return FUTURE_COMPLETED;
+        }
+    }
+    ASSERT_SYS_OK(mio_register(mio, self->in_fd, EPOLLIN, waker));
+    return FUTURE_PENDING;
+}
+
+/* Round trips between two futures over a pair of pipes, each hop woken by Mio. */
+static void bench_ping_pong(size_t n_threads)
+{
+    int ping_to_pong[2], pong_to_ping[2];
+    make_nonblocking_pipe(ping_to_pong);
+    make_nonblocking_pipe(pong_to_ping);
+    BenchSamples samples;
+    samples_init(&samples, PING_PONG_ROUNDS);
+
+    PingFuture ping = {
+        .base = future_create(ping_progress),
+        .out_fd = ping_to_pong[1],
+        .in_fd = pong_to_ping[0],
+        .samples = &samples,
+    };
+    PongFuture pong = {
+        .base = future_create(pong_progress),
+        .out_fd = pong_to_ping[1],
+        .in_fd = ping_to_pong[0],
+    };
+
+    ExecutorConfig config = executor_config_default();
+    config.n_threads = n_threads;
+    Executor* executor = executor_create_with_config(&config);
+    executor_spawn(executor, (Future*)&pong);
+    executor_spawn(executor, (Future*)&ping);
+    executor_run(executor);
+    executor_destroy(executor);
+
+    char params[64];
+    snprintf(params, sizeof(params), "threads=%zu", n_threads);
+    report_add(&report, "ping_pong", params, "ns/round_trip", &samples);
+    samples_destroy(&samples);
+    for (int i = 0; i < 2; i++) {
+        ASSERT_SYS_OK(close(ping_to_pong[i]));
+        ASSERT_SYS_OK(close(pong_to_ping[i]));
+    }
+}
+
+/* Joins N futures that each yield once: time from spawning the join to its completion. */
+static void bench_fan_out(size_t n)
+{
+    YieldFuture* children = malloc(n * sizeof(YieldFuture));
+    Future** futs = malloc(n * sizeof(Future*));
+    ChildResult* results = malloc(n * sizeof(ChildResult));
+    if (!children || !futs || !results)
+        fatal("Out of memory");
+    BenchSamples samples;
+    samples_init(&samples, FAN_OUT_SAMPLES);
+
+    Executor* executor = executor_create(0);
+    for (int s = 0; s < FAN_OUT_SAMPLES; s++) {
+        for (size_t i = 0; i < n; i++) {
+            children[i] = (YieldFuture) { .base = future_create(yield_progress) };
+            futs[i] = (Future*)&children[i];
+        }
+        JoinAllFuture join = future_join_all(futs, n, results);
+        uint64_t start = bench_now_ns();
+        executor_spawn(executor, (Future*)&join);
+        executor_run(executor);
+        samples_add(&samples, (double)(bench_now_ns() - start) / 1000);
+        if (join.base.errcode != FUTURE_SUCCESS)
+            fatal("join_all failed");
+    }
+    executor_destroy(executor);
+
+    char params[64];
+    snprintf(params, sizeof(params), "n=%zu", n);
+    report_add(&report, "join_all_fan_out", params, "us/join", &samples);
+    samples_destroy(&samples);
+    free(children);
+    free(futs);
+    free(results);
+}
+
+/** State shared by the wake latency writer thread and the future it wakes. */
+typedef struct WakeShared {
+    int fds[2];
+    _Atomic uint64_t written_at;
+    atomic_bool armed; // The future is ready for the next byte.
+    atomic_bool done; // The future got every byte.
+} WakeShared;
+
+/* Writes a byte whenever the future is ready for it, after a short pause (so it is parked). */
+static void* wake_writer_main(void* arg)
+{
+    WakeShared* shared = arg;
+    struct timespec pause = { .tv_sec = 0, .tv_nsec = 50000 };
+    for (int i = 0; i < WAKE_ROUNDS; i++) {
+        while (!atomic_exchange(&shared->armed, false))
+            nanosleep(&pause, NULL);
+        nanosleep(&pause, NULL);
+        atomic_store(&shared->written_at, bench_now_ns());
+        write_byte(shared->fds[1]);
+    }
+    return NULL;
+}
+
+/** Records the time from each write of the writer thread to the progress it causes. */
+typedef struct WakeFuture {
+    Future base;
+    WakeShared* shared;
+    bool started;
+    int rounds;
+    BenchSamples* samples;
+} WakeFuture;
+
+static FutureState wake_progress(Future* base, Mio* mio, Waker waker)
+{
+    WakeFuture* self = (WakeFuture*)base;
+    int const fd = self->shared->fds[0];
+    if (!self->started) {
+        self->started = true;
+    } else if (read_byte(fd)) {
+        uint64_t now = bench_now_ns();
+        samples_add(self->samples, (double)(now - atomic_load(&self->shared->written_at)));
+        if (++self->rounds == WAKE_ROUNDS) {
+            ASSERT_SYS_OK(mio_unregister(mio, fd));
+            atomic_store(&self->shared->done, true);
+            return FUTURE_COMPLETED;
+        }
+    } else {
+        ASSERT_SYS_OK(mio_register(mio, fd, EPOLLIN, waker)); // Spurious wake: wait again.
+        return FUTURE_PENDING;
+    }
+    ASSERT_SYS_OK(mio_register(mio, fd, EPOLLIN, waker));
+    atomic_store(&self->shared->armed, true);
+    return FUTURE_PENDING;
+}
+
+/** Computes for BUSY_SLICE_NS per progress, yielding in between, until the wakes are done. */
+typedef struct BusyFuture {
+    Future base;
+    WakeShared* shared;
+} BusyFuture;
+
+static FutureState busy_progress(Future* base, Mio* mio, Waker waker)
+{
+    BusyFuture* self = (BusyFuture*)base;
+    if (atomic_load(&self->shared->done))
+        return FUTURE_COMPLETED;
+    uint64_t const until = bench_now_ns() + BUSY_SLICE_NS;
+    while (bench_now_ns() < until) { }
+    waker_wake(&waker);
+    return FUTURE_PENDING;
+}
+
+/* Latency from a write by another thread to the progress of the future waiting on the pipe,
+ * with the executor otherwise idle, or `busy` running BUSY_FUTURES always-ready futures. */
+static void bench_wake_latency(const char* params, ExecutorConfig const* config, bool busy)
+{
+    WakeShared shared = { 0 };
+    make_nonblocking_pipe(shared.fds);
+    BenchSamples samples;
+    samples_init(&samples, WAKE_ROUNDS);
+
+    Executor* executor = executor_create_with_config(config);
+    WakeFuture fut = { .base = future_create(wake_progress), .shared = &shared, .samples = &samples };
+    BusyFuture busy_futs[BUSY_FUTURES];
+    pthread_t writer;
+    if (pthread_create(&writer, NULL, wake_writer_main, &shared) != 0)
+        fatal("pthread_create");
+    executor_spawn(executor, (Future*)&fut);
+    for (int i = 0; busy && i < BUSY_FUTURES; i++) {
+        busy_futs[i] = (BusyFuture) { .base = future_create(busy_progress), .shared = &shared };
+        executor_spawn(executor, (Future*)&busy_futs[i]);
+    }
+    executor_run(executor);
+    pthread_join(writer, NULL);
+    executor_destroy(executor);
+
+    report_add(&report, busy ? "wake_latency_busy" : "wake_latency", params, "ns/wake", &samples);
+    samples_destroy(&samples);
+    ASSERT_SYS_OK(close(shared.fds[0]));
+    ASSERT_SYS_OK(close(shared.fds[1]));
+}
+
+/** State shared by the remote waking thread and the future it wakes. */
+typedef struct RemoteShared {
+    Waker waker;
+    atomic_bool armed; // `waker` is set and the future waits for it.
+    _Atomic uint64_t woken_at;
+} RemoteShared;
+
+static void* remote_waker_main(void* arg)
+{
+    RemoteShared* shared = arg;
+    struct timespec pause = { .tv_sec = 0, .tv_nsec = 50000 };
+    for (int i = 0; i < REMOTE_WAKE_ROUNDS; i++) {
+        while (!atomic_exchange(&shared->armed, false))
+            nanosleep(&pause, NULL);
+        nanosleep(&pause, NULL);
+        atomic_store(&shared->woken_at, bench_now_ns());
+        waker_wake(&shared->waker);
+    }
+    return NULL;
+}
+
+/** Records the time from each waker_wake() of the remote thread to the progress it causes. */
+typedef struct RemoteWokenFuture {
+    Future base;
+    RemoteShared* shared;
+    int rounds;
+    BenchSamples* samples;
+} RemoteWokenFuture;
+
+static FutureState remote_woken_progress(Future* base, Mio* mio, Waker waker)
+{
+    RemoteWokenFuture* self = (RemoteWokenFuture*)base;
+    uint64_t const woken_at = atomic_exchange(&self->shared->woken_at, 0);
+    if (woken_at != 0) {
+        samples_add(self->samples, (double)(bench_now_ns() - woken_at));
+        if (++self->rounds == REMOTE_WAKE_ROUNDS)
+            return FUTURE_COMPLETED;
+    }
+    self->shared->waker = waker;
+    atomic_store(&self->shared->armed, true);
+    return FUTURE_PENDING;
+}
+
+/* Latency from waker_wake() on another thread to the progress of the (parked) future. */
+static void bench_remote_wake(size_t n_threads)
+{
+    RemoteShared shared = { 0 };
+    BenchSamples samples;
+    samples_init(&samples, REMOTE_WAKE_ROUNDS);
+    ExecutorConfig config = executor_config_default();
+    config.n_threads = n_threads;
+    Executor* executor = executor_create_with_config(&config);
+    RemoteWokenFuture fut = {
+        .base = future_create(remote_woken_progress),
+        .shared = &shared,
+        .samples = &samples,
+    };
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, remote_waker_main, &shared) != 0)
+        fatal("pthread_create");
+    executor_spawn(executor, (Future*)&fut);
+    executor_run(executor);
+    pthread_join(thread, NULL);
+    executor_destroy(executor);
+
+    char params[64];
+    snprintf(params, sizeof(params), "threads=%zu", n_threads);
+    report_add(&report, "remote_wake", params, "ns/wake", &samples);
+    samples_destroy(&samples);
+}
+
+/** Pending until the spawning thread is done (it then wakes it), keeping executor_run() going. */
+typedef struct GateFuture {
+    Future base;
+    RemoteShared* shared;
+    atomic_bool* spawned_all;
+} GateFuture;
+
+static FutureState gate_progress(Future* base, Mio* mio, Waker waker)
+{
+    GateFuture* self = (GateFuture*)base;
+    if (atomic_load(self->spawned_all))
+        return FUTURE_COMPLETED;
+    self->shared->waker = waker;
+    atomic_store(&self->shared->armed, true);
+    return FUTURE_PENDING;
+}
+
+typedef struct RemoteSpawner {
+    Executor* executor;
+    RemoteShared* shared;
+    atomic_bool* spawned_all;
+    Future* futs;
+} RemoteSpawner;
+
+static void* remote_spawner_main(void* arg)
+{
+    RemoteSpawner* spawner = arg;
+    struct timespec pause = { .tv_sec = 0, .tv_nsec = 10000 };
+    while (!atomic_load(&spawner->shared->armed))
+        nanosleep(&pause, NULL);
+    for (int i = 0; i < REMOTE_SPAWNS; i++) {
+        spawner->futs[i] = future_create(ready_progress);
+        ASSERT_SYS_OK(executor_spawn(spawner->executor, &spawner->futs[i]));
+    }
+    atomic_store(spawner->spawned_all, true);
+    waker_wake(&spawner->shared->waker);
+    return NULL;
+}
+
+/* Throughput of spawns from another thread into a running executor, until all have run. */
+static void bench_remote_spawn(size_t n_threads)
+{
+    static Future futs[REMOTE_SPAWNS];
+    BenchSamples samples;
+    samples_init(&samples, REMOTE_SPAWN_SAMPLES);
+    ExecutorConfig config = executor_config_default();
+    config.n_threads = n_threads;
+    Executor* executor = executor_create_with_config(&config);
+
+    for (int s = 0; s < REMOTE_SPAWN_SAMPLES; s++) {
+        RemoteShared shared = { 0 };
+        atomic_bool spawned_all = false;
+        GateFuture gate = {
+            .base = future_create(gate_progress),
+            .shared = &shared,
+            .spawned_all = &spawned_all,
+        };
+        RemoteSpawner spawner = {
+            .executor = executor,
+            .shared = &shared,
+            .spawned_all = &spawned_all,
+            .futs = futs,
+        };
+        pthread_t thread;
+        executor_spawn(executor, (Future*)&gate);
+        if (pthread_create(&thread, NULL, remote_spawner_main, &spawner) != 0)
+            fatal("pthread_create");
+        uint64_t const start = bench_now_ns();
+        executor_run(executor);
+        samples_add(&samples, (double)(bench_now_ns() - start) / REMOTE_SPAWNS);
+        pthread_join(thread, NULL);
+    }
+    executor_destroy(executor);
+
+    char params[64];
+    snprintf(params, sizeof(params), "threads=%zu", n_threads);
+    report_add(&report, "remote_spawn", params, "ns/future", &samples);
+    samples_destroy(&samples);
+}
+
+/** Yields FAIRNESS_ROUNDS times, sampling how long each trip through the run queue took. */
+typedef struct ProbeFuture {
+    Future base;
+    BenchSamples* samples;
+    uint64_t woken_at;
+    int rounds;
+} ProbeFuture;
+
+static FutureState probe_progress(Future* base, Mio* mio, Waker waker)
+{
+    ProbeFuture* self = (ProbeFuture*)base;
+    if (self->rounds > 0)
+        samples_add(self->samples, (double)(bench_now_ns() - self->woken_at));
+    if (self->rounds++ == FAIRNESS_ROUNDS)
+        return FUTURE_COMPLETED;
+    self->woken_at = bench_now_ns();
+    waker_wake(&waker);
+    return FUTURE_PENDING;
+}
+
+/** Reads /dev/zero, FIREHOSE_READ bytes per PipeReadFuture, as long as the probe runs. Between
+ * two reads it yields, but each read runs until done unless the pipe future yields itself. */
+typedef struct FirehoseFuture {
+    Future base;
+    Future const* probe;
+    int fd;
+    uint8_t* buffer;
+    PipeReadFuture read;
+} FirehoseFuture;
+
+static FutureState firehose_progress(Future* base, Mio* mio, Waker waker)
+{
+    FirehoseFuture* self = (FirehoseFuture*)base;
+    if (self->read.base.progress((Future*)&self->read, mio, waker) == FUTURE_PENDING)
+        return FUTURE_PENDING;
+    if (!self->probe->is_active)
+        return FUTURE_COMPLETED;
+    self->read = pipe_read_future_create(self->fd, self->buffer, FIREHOSE_READ);
+    waker_wake(&waker);
+    return FUTURE_PENDING;
+}
+
+/* Queueing latency of a light future while another one reads a source that never runs dry. */
+static void bench_fairness(size_t task_budget)
+{
+    BenchSamples samples;
+    samples_init(&samples, FAIRNESS_ROUNDS);
+    int fd = open("/dev/zero", O_RDONLY | O_NONBLOCK);
+    uint8_t* buffer = malloc(FIREHOSE_READ);
+    if (fd == -1 || !buffer)
+        fatal("Cannot set up the firehose");
+    ExecutorConfig config = executor_config_default();
+    config.task_budget = task_budget;
+    Executor* executor = executor_create_with_config(&config);
+
+    ProbeFuture probe = { .base = future_create(probe_progress), .samples = &samples };
+    FirehoseFuture firehose = {
+        .base = future_create(firehose_progress),
+        .probe = &probe.base,
+        .fd = fd,
+        .buffer = buffer,
+        .read = pipe_read_future_create(fd, buffer, FIREHOSE_READ),
+    };
+    executor_spawn(executor, (Future*)&firehose);
+    executor_spawn(executor, (Future*)&probe);
+    executor_run(executor);
+    executor_destroy(executor);
+    free(buffer);
+    close(fd);
+
+    char params[64];
+    snprintf(params, sizeof(params), "task_budget=%zu", task_budget);
+    report_add(&report, "fairness_light_task", params, "ns/turn", &samples);
+    samples_destroy(&samples);
+}
+
+/** Writes FRAMES frames of `n_segments` segments: with one writev() each, or copied into one
+ * buffer and written with write(). */
+typedef struct FrameWriterFuture {
+    Future base;
+    int fd;
+    bool vectored;
+    struct iovec* segments;
+    int n_segments;
+    size_t frame_bytes;
+    int frames_left;
+    bool writing;
+    PipeWritevFuture writev;
+    PipeWriteFuture write;
+    uint8_t frame[MAX_FRAME_BYTES];
+} FrameWriterFuture;
+
+static FutureState frame_writer_progress(Future* base, Mio* mio, Waker waker)
+{
+    FrameWriterFuture* self = (FrameWriterFuture*)base;
+    while (self->frames_left > 0) {
+        if (!self->writing) {
+            if (self->vectored) {
+                self->writev
+                    = pipe_writev_future_create(self->fd, self->segments, self->n_segments);
+            } else {
+                size_t offset = 0;
+                for (int i = 0; i < self->n_segments; i++) {
+                    memcpy(self->frame + offset, self->segments[i].iov_base,
+                        self->segments[i].iov_len);
+                    offset += self->segments[i].iov_len;
+                }
+                self->write = pipe_write_future_create(self->fd, self->frame_bytes, false);
+                self->write.base.arg = self->frame;
+            }
+            self->writing = true;
+        }
+        Future* write = self->vectored ? (Future*)&self->writev : (Future*)&self->write;
+        if (write->progress(write, mio, waker) == FUTURE_PENDING)
+            return FUTURE_PENDING;
+        self->writing = false;
+        self->frames_left--;
+    }
+    return FUTURE_COMPLETED;
+}
+
+/** Reads and discards `left` bytes. */
+typedef struct DrainFuture {
+    Future base;
+    int fd;
+    size_t left;
+    uint8_t buffer[64 * 1024];
+} DrainFuture;
+
+static FutureState drain_progress(Future* base, Mio* mio, Waker waker)
+{
+    DrainFuture* self = (DrainFuture*)base;
+    while (self->left > 0) {
+        ssize_t n = read(self->fd, self->buffer, sizeof(self->buffer));
+        if (n > 0) {
+            self->left -= n;
+        } else if (n == -1 && errno == EAGAIN) {
+            mio_register(mio, self->fd, EPOLLIN, waker);
+            return FUTURE_PENDING;
+        } else {
+            fatal("Drain read failed");
+        }
+    }
+    mio_unregister(mio, self->fd);
+    return FUTURE_COMPLETED;
+}
+
+/* Framing cost: small segments written with writev(), against copying them and using write(). */
+static void bench_gather_write(bool vectored, int n_segments, size_t segment_bytes)
+{
+    static uint8_t segment_data[MAX_FRAME_BYTES];
+    static struct iovec segments[MAX_SEGMENTS];
+    static FrameWriterFuture writer;
+    static DrainFuture drain;
+    for (int i = 0; i < n_segments; i++)
+        segments[i] = (struct iovec) {
+            .iov_base = segment_data + i * segment_bytes,
+            .iov_len = segment_bytes,
+        };
+    BenchSamples samples;
+    samples_init(&samples, FRAME_SAMPLES);
+    int fds[2];
+    make_nonblocking_pipe(fds);
+
+    Executor* executor = executor_create(0);
+    for (int s = 0; s < FRAME_SAMPLES; s++) {
+        writer = (FrameWriterFuture) {
+            .base = future_create(frame_writer_progress),
+            .fd = fds[1],
+            .vectored = vectored,
+            .segments = segments,
+            .n_segments = n_segments,
+            .frame_bytes = n_segments * segment_bytes,
+            .frames_left = FRAMES,
+        };
+        drain = (DrainFuture) {
+            .base = future_create(drain_progress),
+            .fd = fds[0],
+            .left = FRAMES * n_segments * segment_bytes,
+        };
+        uint64_t const start = bench_now_ns();
+        executor_spawn(executor, (Future*)&drain);
+        executor_spawn(executor, (Future*)&writer);
+        executor_run(executor);
+        samples_add(&samples, (double)(bench_now_ns() - start) / FRAMES);
+    }
+    executor_destroy(executor);
+    close(fds[0]);
+    close(fds[1]);
+
+    char params[64];
+    snprintf(params, sizeof(params), "mode=%s,segments=%d,segment_bytes=%zu",
+        vectored ? "writev" : "copy_write", n_segments, segment_bytes);
+    report_add(&report, "gather_write", params, "ns/frame", &samples);
+    samples_destroy(&samples);
+}
+
+/** Forwards FORWARD_BYTES from one pipe to another as a chain of a PipeReadFuture then a
+ * PipeWriteFuture (through user space, one FORWARD_CHUNK at a time). */
+typedef struct ChainForwardFuture {
+    Future base;
+    int in_fd;
+    int out_fd;
+    size_t left;
+    bool chained;
+    PipeReadFuture read;
+    PipeWriteFuture write;
+    ThenFuture then;
+    uint8_t* buffer;
+} ChainForwardFuture;
+
+static FutureState chain_forward_progress(Future* base, Mio* mio, Waker waker)
+{
+    ChainForwardFuture* self = (ChainForwardFuture*)base;
+    while (self->left > 0) {
+        size_t const n = self->left < FORWARD_CHUNK ? self->left : FORWARD_CHUNK;
+        if (!self->chained) {
+            self->read = pipe_read_future_create(self->in_fd, self->buffer, n);
+            self->write = pipe_write_future_create(self->out_fd, n, false);
+            self->then = future_then((Future*)&self->read, (Future*)&self->write);
+            self->chained = true;
+        }
+        FutureState state = self->then.base.progress((Future*)&self->then, mio, waker);
+        if (state == FUTURE_PENDING)
+            return FUTURE_PENDING;
+        if (state == FUTURE_FAILURE)
+            fatal("Forwarding failed");
+        self->chained = false;
+        self->left -= n;
+    }
+    return FUTURE_COMPLETED;
+}
+
+/* Forwarding throughput between pipes, fed and drained by other futures on the same executor. */
+static void bench_forward(bool use_splice)
+{
+    static uint8_t zeros[FORWARD_CHUNK];
+    static uint8_t chunk[FORWARD_CHUNK];
+    static DrainFuture drain;
+    BenchSamples samples;
+    samples_init(&samples, FORWARD_SAMPLES);
+    int in[2], out[2];
+    make_nonblocking_pipe(in);
+    make_nonblocking_pipe(out);
+
+    // The source: the same chunk of zeros, written over and over.
+    static struct iovec feeds[FORWARD_BYTES / FORWARD_CHUNK];
+    for (size_t i = 0; i < FORWARD_BYTES / FORWARD_CHUNK; i++)
+        feeds[i] = (struct iovec) { .iov_base = zeros, .iov_len = FORWARD_CHUNK };
+
+    Executor* executor = executor_create(0);
+    for (int s = 0; s < FORWARD_SAMPLES; s++) {
+        PipeWritevFuture producer
+            = pipe_writev_future_create(in[1], feeds, FORWARD_BYTES / FORWARD_CHUNK);
+        SpliceFuture splice = splice_future_create(in[0], out[1], FORWARD_BYTES);
+        ChainForwardFuture chain = {
+            .base = future_create(chain_forward_progress),
+            .in_fd = in[0],
+            .out_fd = out[1],
+            .left = FORWARD_BYTES,
+            .buffer = chunk,
+        };
+        drain = (DrainFuture) {
+            .base = future_create(drain_progress),
+            .fd = out[0],
+            .left = FORWARD_BYTES,
+        };
+        uint64_t const start = bench_now_ns();
+        executor_spawn(executor, (Future*)&producer);
+        executor_spawn(executor, use_splice ? (Future*)&splice : (Future*)&chain);
+        executor_spawn(executor, (Future*)&drain);
+        executor_run(executor);
+        samples_add(&samples, (double)FORWARD_BYTES / (double)(bench_now_ns() - start));
+    }
+    executor_destroy(executor);
+    for (int i = 0; i < 2; i++) {
+        close(in[i]);
+        close(out[i]);
+    }
+
+    report_add(&report, "pipe_forward", use_splice ? "mode=splice" : "mode=read_then_write",
+        "GB/s", &samples);
+    samples_destroy(&samples);
+}
+
+/* Echoes what it receives on an accepted connection until the client closes it. */
+typedef struct EchoFuture {
+    Future base;
+    int fd;
+    bool sending;
+    SocketRecvFuture recv;
+    SocketSendFuture send;
+    uint8_t buffer[ECHO_MESSAGE * 4];
+} EchoFuture;
+
+static FutureState echo_progress(Future* base, Mio* mio, Waker waker)
+{
+    EchoFuture* self = (EchoFuture*)base;
+    for (;;) {
+        FutureState state;
+        if (!self->sending) {
+            state = self->recv.base.progress(&self->recv.base, mio, waker);
+            if (state == FUTURE_PENDING)
+                return FUTURE_PENDING;
+            if (state == FUTURE_FAILURE) {
+                if (self->recv.base.errcode != SOCKET_FUTURE_ERR_EOF)
+                    fatal("Echo: recv failed: %s", strerror(self->recv.error));
+                return FUTURE_COMPLETED;
+            }
+            self->send = socket_send_future_create(self->fd, self->buffer, self->recv.received);
+            self->sending = true;
+        }
+        state = self->send.base.progress(&self->send.base, mio, waker);
+        if (state == FUTURE_PENDING)
+            return FUTURE_PENDING;
+        if (state == FUTURE_FAILURE)
+            fatal("Echo: send failed: %s", strerror(self->send.error));
+        self->recv = socket_recv_future_create(self->fd, self->buffer, sizeof(self->buffer));
+        self->sending = false;
+    }
+}
+
+static void echo_destroy(Future* fut, void* ctx)
+{
+    socket_close(executor_mio(ctx), ((EchoFuture*)fut)->fd);
+}
+
+/* Accepts `to_accept` connections, spawning a detached EchoFuture (from the arena) for each. */
+typedef struct EchoServerFuture {
+    Future base;
+    Executor* executor;
+    int listen_fd;
+    size_t to_accept;
+    bool accepting;
+    SocketAcceptFuture accept;
+    int fds[ECHO_ACCEPT_BATCH];
+} EchoServerFuture;
+
+static FutureState echo_server_progress(Future* base, Mio* mio, Waker waker)
+{
+    EchoServerFuture* self = (EchoServerFuture*)base;
+    while (self->to_accept > 0) {
+        if (!self->accepting) {
+            self->accept
+                = socket_accept_future_create(self->listen_fd, self->fds, ECHO_ACCEPT_BATCH);
+            self->accepting = true;
+        }
+        FutureState state = self->accept.base.progress(&self->accept.base, mio, waker);
+        if (state == FUTURE_PENDING)
+            return FUTURE_PENDING;
+        if (state == FUTURE_FAILURE)
+            fatal("Echo: accept failed: %s", strerror(self->accept.error));
+        for (size_t i = 0; i < self->accept.accepted; i++) {
+            EchoFuture* echo = executor_alloc_future(self->executor, sizeof(EchoFuture));
+            if (!echo)
+                fatal("Echo: out of future memory");
+            *echo = (EchoFuture) { .base = future_create(echo_progress), .fd = self->fds[i] };
+            echo->recv = socket_recv_future_create(echo->fd, echo->buffer, sizeof(echo->buffer));
+            ASSERT_SYS_OK(executor_spawn_detached(
+                self->executor, &echo->base, NULL, echo_destroy, self->executor));
+        }
+        self->to_accept -= self->accept.accepted;
+        self->accepting = false;
+    }
+    return FUTURE_COMPLETED;
+}
+
+/* One client: connection after connection (while any are left to make), each sending
+ * `requests` messages and waiting for the echo of each before the next. */
+typedef struct EchoClientFuture {
+    Future base;
+    struct sockaddr_in const* addr;
+    atomic_int* connections_left;
+    int requests;
+    enum { CLIENT_IDLE, CLIENT_CONNECTING, CLIENT_SENDING, CLIENT_RECEIVING } step;
+    int fd;
+    int done; // Requests done on the current connection.
+    SocketConnectFuture connect;
+    SocketSendFuture send;
+    SocketRecvFuture recv;
+    uint8_t request[ECHO_MESSAGE];
+    uint8_t reply[ECHO_MESSAGE];
+} EchoClientFuture;
+
+static FutureState echo_client_progress(Future* base, Mio* mio, Waker waker)
+{
+    EchoClientFuture* self = (EchoClientFuture*)base;
+    for (;;) {
+        FutureState state = FUTURE_COMPLETED;
+        switch (self->step) {
+        case CLIENT_IDLE:
+            if (atomic_fetch_sub(self->connections_left, 1) <= 0)
+                return FUTURE_COMPLETED;
+            self->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            ASSERT_SYS_OK(self->fd);
+            self->connect = socket_connect_future_create(
+                self->fd, (struct sockaddr const*)self->addr, sizeof(*self->addr));
+            self->done = 0;
+            self->step = CLIENT_CONNECTING;
+            break;
+        case CLIENT_CONNECTING:
+            state = self->connect.base.progress(&self->connect.base, mio, waker);
+            if (state == FUTURE_COMPLETED) {
+                self->send = socket_send_future_create(self->fd, self->request, ECHO_MESSAGE);
+                self->step = CLIENT_SENDING;
+            }
+            break;
+        case CLIENT_SENDING:
+            state = self->send.base.progress(&self->send.base, mio, waker);
+            if (state == FUTURE_COMPLETED) {
+                self->recv = socket_recv_future_create(self->fd, self->reply, ECHO_MESSAGE);
+                self->recv.min = ECHO_MESSAGE;
+                self->step = CLIENT_RECEIVING;
+            }
+            break;
+        case CLIENT_RECEIVING:
+            state = self->recv.base.progress(&self->recv.base, mio, waker);
+            if (state != FUTURE_COMPLETED)
+                break;
+            if (++self->done < self->requests) {
+                self->send = socket_send_future_create(self->fd, self->request, ECHO_MESSAGE);
+                self->step = CLIENT_SENDING;
+            } else {
+                socket_close(mio, self->fd);
+                self->step = CLIENT_IDLE;
+            }
+            break;
+        }
+        if (state == FUTURE_PENDING)
+            return FUTURE_PENDING;
+        if (state == FUTURE_FAILURE)
+            fatal("Echo client failed at step %d", (int)self->step);
+    }
+}
+
+/* A TCP echo server and ECHO_CLIENTS clients over loopback, all futures of one executor: requests
+ * (or, with one request per connection, connections) handled per second, divided by the number
+ * of threads running futures. */
+static void bench_echo(size_t n_threads, int requests_per_conn, int n_connections)
+{
+    static EchoClientFuture clients[ECHO_CLIENTS];
+    static EchoServerFuture server;
+    BenchSamples samples;
+    samples_init(&samples, ECHO_SAMPLES);
+
+    int const listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    ASSERT_SYS_OK(listen_fd);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t addrlen = sizeof(addr);
+    ASSERT_SYS_OK(bind(listen_fd, (struct sockaddr*)&addr, addrlen));
+    ASSERT_SYS_OK(listen(listen_fd, 1024));
+    ASSERT_SYS_OK(getsockname(listen_fd, (struct sockaddr*)&addr, &addrlen));
+
+    ExecutorConfig config = executor_config_default();
+    config.n_threads = n_threads;
+    Executor* executor = executor_create_with_config(&config);
+    double const cores = n_threads > 0 ? (double)n_threads : 1.0;
+    for (int s = 0; s < ECHO_SAMPLES; s++) {
+        atomic_int connections_left = n_connections;
+        server = (EchoServerFuture) {
+            .base = future_create(echo_server_progress),
+            .executor = executor,
+            .listen_fd = listen_fd,
+            .to_accept = n_connections,
+        };
+        uint64_t const start = bench_now_ns();
+        executor_spawn(executor, (Future*)&server);
+        for (int i = 0; i < ECHO_CLIENTS; i++) {
+            clients[i] = (EchoClientFuture) {
+                .base = future_create(echo_client_progress),
+                .addr = &addr,
+                .connections_left = &connections_left,
+                .requests = requests_per_conn,
+                .step = CLIENT_IDLE,
+            };
+            executor_spawn(executor, (Future*)&clients[i]);
+        }
+        executor_run(executor);
+        double const seconds = (double)(bench_now_ns() - start) / 1e9;
+        double const handled = requests_per_conn > 1 ? (double)n_connections * requests_per_conn
+                                                      : (double)n_connections;
+        samples_add(&samples, handled / seconds / cores);
+    }
+    socket_close(executor_mio(executor), listen_fd);
+    executor_destroy(executor);
+
+    char params[64];
+    snprintf(params, sizeof(params), "threads=%zu,requests_per_conn=%d", n_threads,
+        requests_per_conn);
+    report_add(&report, "echo_server", params, requests_per_conn > 1 ? "req/s/core" : "conn/s/core",
+        &samples);
+    samples_destroy(&samples);
+}
+
+// ========================= UDP datagram batches =========================
+
+/** Receives UDP_PACKETS datagrams in batches, waking the source when it waits for the window. */
+typedef struct UdpSinkFuture {
+    Future base;
+    int fd;
+    unsigned batch;
+    size_t received;
+    bool receiving;
+    UdpRecvBatchFuture recv;
+    struct mmsghdr msgs[UDP_MAX_BATCH];
+    struct iovec iov[UDP_MAX_BATCH];
+    uint8_t buffers[UDP_MAX_BATCH][UDP_PAYLOAD];
+    struct UdpSourceFuture* source;
+} UdpSinkFuture;
+
+/** Sends UDP_PACKETS datagrams in batches, keeping at most UDP_WINDOW of them unreceived. */
+typedef struct UdpSourceFuture {
+    Future base;
+    int fd; // Connected to the sink's socket.
+    unsigned batch;
+    size_t sent;
+    bool sending;
+    bool blocked; // Waiting for the sink to catch up, with `waker`.
+    Waker waker;
+    UdpSendBatchFuture send;
+    struct mmsghdr msgs[UDP_MAX_BATCH];
+    struct iovec iov[UDP_MAX_BATCH];
+    uint8_t payload[UDP_PAYLOAD];
+    UdpSinkFuture* sink;
+} UdpSourceFuture;
+
+static FutureState udp_sink_progress(Future* base, Mio* mio, Waker waker)
+{
+    UdpSinkFuture* self = (UdpSinkFuture*)base;
+    while (self->received < UDP_PACKETS) {
+        if (!self->receiving) {
+            self->recv = udp_recv_batch_future_create(self->fd, self->msgs, self->batch);
+            self->receiving = true;
+        }
+        FutureState const state = self->recv.base.progress(&self->recv.base, mio, waker);
+        if (state == FUTURE_PENDING)
+            return FUTURE_PENDING;
+        if (state == FUTURE_FAILURE)
+            fatal("UDP: recvmmsg failed: %s", strerror(self->recv.error));
+        self->receiving = false;
+        self->received += self->recv.done;
+        if (self->source->blocked) {
+            self->source->blocked = false;
+            waker_wake(&self->source->waker);
+        }
+    }
+    return FUTURE_COMPLETED;
+}
+
+static FutureState udp_source_progress(Future* base, Mio* mio, Waker waker)
+{
+    UdpSourceFuture* self = (UdpSourceFuture*)base;
+    while (self->sent < UDP_PACKETS) {
+        if (!self->sending) {
+            size_t const left = UDP_PACKETS - self->sent;
+            unsigned const n = left < self->batch ? (unsigned)left : self->batch;
+            if (self->sent + n - self->sink->received > UDP_WINDOW) {
+                self->blocked = true;
+                self->waker = waker;
+                return FUTURE_PENDING;
+            }
+            self->send = udp_send_batch_future_create(self->fd, self->msgs, n);
+            self->sending = true;
+        }
+        FutureState const state = self->send.base.progress(&self->send.base, mio, waker);
+        if (state == FUTURE_PENDING)
+            return FUTURE_PENDING;
+        if (state == FUTURE_FAILURE)
+            fatal("UDP: sendmmsg failed: %s", strerror(self->send.error));
+        self->sending = false;
+        self->sent += self->send.done;
+    }
+    return FUTURE_COMPLETED;
+}
+
+static int udp_bench_socket(struct sockaddr_in* addr)
+{
+    int const fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    ASSERT_SYS_OK(fd);
+    *addr = (struct sockaddr_in) {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t addrlen = sizeof(*addr);
+    ASSERT_SYS_OK(bind(fd, (struct sockaddr*)addr, addrlen));
+    ASSERT_SYS_OK(getsockname(fd, (struct sockaddr*)addr, &addrlen));
+    return fd;
+}
+
+/* Small datagrams over loopback between two futures of one executor, `batch` per recvmmsg() and
+ * sendmmsg() call (batch=1 is the cost of one recvfrom()/sendto() per datagram). */
+static void bench_udp_batch(unsigned batch)
+{
+    static UdpSinkFuture sink;
+    static UdpSourceFuture source;
+    BenchSamples samples;
+    samples_init(&samples, UDP_SAMPLES);
+
+    struct sockaddr_in sink_addr, source_addr;
+    int const sink_fd = udp_bench_socket(&sink_addr);
+    int const source_fd = udp_bench_socket(&source_addr);
+    ASSERT_SYS_OK(connect(source_fd, (struct sockaddr*)&sink_addr, sizeof(sink_addr)));
+
+    Executor* executor = executor_create(0);
+    for (int s = 0; s < UDP_SAMPLES; s++) {
+        sink = (UdpSinkFuture) {
+            .base = future_create(udp_sink_progress),
+            .fd = sink_fd,
+            .batch = batch,
+            .source = &source,
+        };
+        source = (UdpSourceFuture) {
+            .base = future_create(udp_source_progress),
+            .fd = source_fd,
+            .batch = batch,
+            .sink = &sink,
+        };
+        memset(source.payload, s, UDP_PAYLOAD);
+        for (unsigned i = 0; i < batch; i++) {
+            sink.iov[i] = (struct iovec) { .iov_base = sink.buffers[i], .iov_len = UDP_PAYLOAD };
+            sink.msgs[i]
+                = (struct mmsghdr) { .msg_hdr = { .msg_iov = &sink.iov[i], .msg_iovlen = 1 } };
+            source.iov[i] = (struct iovec) { .iov_base = source.payload, .iov_len = UDP_PAYLOAD };
+            source.msgs[i]
+                = (struct mmsghdr) { .msg_hdr = { .msg_iov = &source.iov[i], .msg_iovlen = 1 } };
+        }
+
+        uint64_t const start = bench_now_ns();
+        executor_spawn(executor, &sink.base);
+        executor_spawn(executor, &source.base);
+        executor_run(executor);
+        double const seconds = (double)(bench_now_ns() - start) / 1e9;
+        samples_add(&samples, UDP_PACKETS / seconds);
+    }
+    socket_close(executor_mio(executor), sink_fd);
+    socket_close(executor_mio(executor), source_fd);
+    executor_destroy(executor);
+
+    char params[32];
+    snprintf(params, sizeof(params), "batch=%u", batch);
+    report_add(&report, "udp_batch", params, "pkt/s", &samples);
+    samples_destroy(&samples);
+}
+
+int main(int argc, char** argv)
+{
+    report_open(&report, argc, argv);
+
+    bench_spawn();
+    bench_spawn_churn(true);
+    bench_spawn_churn(false);
+    bench_ping_pong(0);
+    bench_ping_pong(2);
+    bench_fan_out(10);
+    bench_fan_out(100);
+    bench_fan_out(1000);
+
+    // Idle executor: block in mio_poll() right away, or spin a while first.
+    ExecutorConfig config = executor_config_default();
+    bench_wake_latency("backend=epoll", &config, false);
+    config.poll_spin_us = 50;
+    bench_wake_latency("backend=epoll,spin_us=50", &config, false);
+    config = executor_config_default();
+    config.mio.backend = MIO_BACKEND_IO_URING;
+    bench_wake_latency("backend=io_uring", &config, false);
+    config.poll_spin_us = 50;
+    bench_wake_latency("backend=io_uring,spin_us=50", &config, false);
+
+    // Busy executor: readiness is only seen by the checks every poll_interval futures (with
+    // poll_interval=0 the queue never runs dry, and the wakes would never be seen at all).
+    config = executor_config_default();
+    bench_wake_latency("poll_interval=61", &config, true);
+    config.poll_interval = 8;
+    bench_wake_latency("poll_interval=8", &config, true);
+
+    bench_remote_wake(0);
+    bench_remote_wake(2);
+    bench_remote_spawn(0);
+    bench_remote_spawn(2);
+
+    bench_fairness(128);
+    bench_fairness(0);
+    bench_gather_write(true, 16, 64);
+    bench_gather_write(false, 16, 64);
+    bench_gather_write(true, 4, 8192);
+    bench_gather_write(false, 4, 8192);
+    bench_forward(true);
+    bench_forward(false);
+    bench_echo(0, 100, 256);
+    bench_echo(2, 100, 256);
+    bench_echo(0, 1, 2000);
+    bench_echo(2, 1, 2000);
+    bench_udp_batch(1);
+    bench_udp_batch(UDP_MAX_BATCH);
+
+    report_close(&report);
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "err.h"
+#include "executor.h"
+#include "future_combinators.h"
+
+// Waits for N children released one at a time, joined either by a tree of binary JoinFutures
+// (where a wake goes down the log2(N) joins above the woken child) or by a single JoinAllFuture,
+// and reports the progress() calls and time per wake. Both only re-progress the woken child.
+
+#define N_CHILDREN 2000
+
+typedef struct ManualFuture {
+    Future base;
+    Waker waker;
+    bool released;
+} ManualFuture;
+
+static long long child_progress_calls;
+
+static FutureState manual_progress(Future* base, Mio* mio, Waker waker)
+{
+    ManualFuture* self = (ManualFuture*)base;
+    child_progress_calls++;
+    self->waker = waker;
+    return self->released ? FUTURE_COMPLETED : FUTURE_PENDING;
+}
+
+/** Releases one child per progress, in order, yielding in between. */
+typedef struct DriverFuture {
+    Future base;
+    ManualFuture* children;
+    size_t next;
+} DriverFuture;
+
+static FutureState driver_progress(Future* base, Mio* mio, Waker waker)
+{
+    DriverFuture* self = (DriverFuture*)base;
+    if (self->next == N_CHILDREN)
+        return FUTURE_COMPLETED;
+    ManualFuture* child = &self->children[self->next++];
+    child->released = true;
+    waker_wake(&child->waker);
+    waker_wake(&waker);
+    return FUTURE_PENDING;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void run(const char* name, bool nary)
+{
+    static ManualFuture children[N_CHILDREN];
+    static Future* futs[N_CHILDREN];
+    static ChildResult results[N_CHILDREN];
+    static JoinFuture joins[N_CHILDREN];
+    for (int i = 0; i < N_CHILDREN; i++) {
+        children[i] = (ManualFuture) { .base = future_create(manual_progress) };
+        futs[i] = (Future*)&children[i];
+    }
+
+    Future* root;
+    JoinAllFuture join_all;
+    if (nary) {
+        join_all = future_join_all(futs, N_CHILDREN, results);
+        root = (Future*)&join_all;
+    } else {
+        // Balanced tree: joins[i] joins the pair of nodes 2i and 2i+1 of the level below.
+        Future* level[N_CHILDREN];
+        size_t width = N_CHILDREN, used = 0;
+        for (size_t i = 0; i < width; i++)
+            level[i] = futs[i];
+        while (width > 1) {
+            size_t next_width = 0;
+            for (size_t i = 0; i + 1 < width; i += 2) {
+                joins[used] = future_join(level[i], level[i + 1]);
+                level[next_width++] = (Future*)&joins[used++];
+            }
+            if (width % 2)
+                level[next_width++] = level[width - 1];
+            width = next_width;
+        }
+        root = level[0];
+    }
+
+    Executor* executor = executor_create(0);
+    DriverFuture driver = { .base = future_create(driver_progress), .children = children };
+    child_progress_calls = 0;
+    double start = now();
+    executor_spawn(executor, root);
+    executor_spawn(executor, (Future*)&driver);
+    executor_run(executor);
+    double elapsed = now() - start;
+
+    printf("%-18s %d children: %10lld child progress calls, %8.1f us/wake\n", name, N_CHILDREN,
+        child_progress_calls, elapsed * 1e6 / N_CHILDREN);
+    executor_destroy(executor);
+}
+
+int main()
+{
+    run("binary join tree", false);
+    run("future_join_all", true);
+    return 0;
+}
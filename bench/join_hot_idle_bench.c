@@ -0,0 +1,100 @@
+// Required for `unistd.h` include to contain `pipe2`.
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "err.h"
+#include "executor.h"
+#include "future_combinators.h"
+#include "future_examples.h"
+
+// Joins a read of a busy pipe (fed in many small writes) with a read of a pipe that stays idle
+// until the end, and counts how often each read is progressed. With per-child wakers the idle
+// read is only progressed when first started and when its byte finally arrives.
+
+#define N_WRITES 20000
+
+/** Counts the progress calls of the wrapped future. */
+typedef struct CountingFuture {
+    Future base;
+    Future* inner;
+    long long progressed;
+} CountingFuture;
+
+static FutureState counting_progress(Future* base, Mio* mio, Waker waker)
+{
+    CountingFuture* self = (CountingFuture*)base;
+    self->progressed++;
+    FutureState state = self->inner->progress(self->inner, mio, waker);
+    base->ok = self->inner->ok;
+    base->errcode = self->inner->errcode;
+    return state;
+}
+
+static CountingFuture counting_future_create(Future* inner)
+{
+    return (CountingFuture) { .base = future_create(counting_progress), .inner = inner };
+}
+
+static int hot_fds[2];
+static int idle_fds[2];
+
+static void* writer(void* arg)
+{
+    struct timespec delay = { .tv_sec = 0, .tv_nsec = 10000 };
+    uint8_t byte = 'x';
+    for (int i = 0; i < N_WRITES; i++) {
+        ASSERT_SYS_OK(write(hot_fds[1], &byte, 1));
+        if (i % 16 == 0)
+            nanosleep(&delay, NULL);
+    }
+    ASSERT_SYS_OK(write(idle_fds[1], &byte, 1));
+    return NULL;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main()
+{
+    ASSERT_SYS_OK(pipe2(hot_fds, O_NONBLOCK));
+    ASSERT_SYS_OK(pipe2(idle_fds, O_NONBLOCK));
+    ASSERT_SYS_OK(fcntl(hot_fds[1], F_SETFL, 0)); // The writer may block.
+    ASSERT_SYS_OK(fcntl(idle_fds[1], F_SETFL, 0));
+
+    static uint8_t hot_buffer[N_WRITES];
+    uint8_t idle_buffer[1];
+    PipeReadFuture hot_read = pipe_read_future_create(hot_fds[0], hot_buffer, sizeof(hot_buffer));
+    PipeReadFuture idle_read = pipe_read_future_create(idle_fds[0], idle_buffer, 1);
+    CountingFuture hot = counting_future_create((Future*)&hot_read);
+    CountingFuture idle = counting_future_create((Future*)&idle_read);
+    JoinFuture join = future_join((Future*)&hot, (Future*)&idle);
+
+    Executor* executor = executor_create(0);
+    executor_spawn(executor, (Future*)&join);
+    pthread_t thread;
+    double start = now();
+    ASSERT_ZERO(pthread_create(&thread, NULL, writer, NULL));
+    executor_run(executor);
+    double elapsed = now() - start;
+    ASSERT_ZERO(pthread_join(thread, NULL));
+
+    printf("hot read progressed %lld times, idle read progressed %lld times, %.3f s\n",
+        hot.progressed, idle.progressed, elapsed);
+
+    executor_destroy(executor);
+    ASSERT_SYS_OK(close(hot_fds[0]));
+    ASSERT_SYS_OK(close(hot_fds[1]));
+    ASSERT_SYS_OK(close(idle_fds[0]));
+    ASSERT_SYS_OK(close(idle_fds[1]));
+    return 0;
+}
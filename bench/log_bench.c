@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "executor.h"
+#include "future.h"
+
+// Runs futures that yield many times (each yield is a waker_wake(), which logs a debug message)
+// and reports the cost per yield. Built once per DEBUG_LOG mode, as log_bench_off,
+// log_bench_ring and log_bench_stderr; run the latter with stderr redirected to /dev/null.
+
+#define N_FUTURES 100
+#define N_YIELDS 10000
+
+typedef struct YieldFuture {
+    Future base;
+    int yields;
+} YieldFuture;
+
+static FutureState yield_progress(Future* base, Mio* mio, Waker waker)
+{
+    YieldFuture* self = (YieldFuture*)base;
+    if (++self->yields == N_YIELDS)
+        return FUTURE_COMPLETED;
+    waker_wake(&waker);
+    return FUTURE_PENDING;
+}
+
+static const char* mode(void)
+{
+#if defined(DEBUG_TRACE_RING)
+    return "ring";
+#elif defined(DEBUG_PRINTS)
+    return "stderr";
+#else
+    return "off";
+#endif
+}
+
+int main()
+{
+    static YieldFuture futures[N_FUTURES];
+    Executor* executor = executor_create(0);
+    for (int i = 0; i < N_FUTURES; i++) {
+        futures[i] = (YieldFuture) { .base = future_create(yield_progress) };
+        executor_spawn(executor, (Future*)&futures[i]);
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    executor_run(executor);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("logging %-6s: %6.1f ns/yield\n", mode(), elapsed * 1e9 / (N_FUTURES * N_YIELDS));
+    executor_destroy(executor);
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Required for `unistd.h` include to contain `pipe2`.
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "err.h"
+#include "executor.h"
+#include "future_examples.h"
+#include "mio.h"
+
+// Moves data through many pipes at once with each Mio backend, and reports the time taken and
+// how many polls (epoll_wait / io_uring_enter), epoll_ctl calls and io_uring submissions it cost.
+// With epoll, every chunk also costs a read() or write() syscall; with io_uring, those are
+// submissions batched into the next poll (or consumed by the kernel thread with SQPOLL).
+
+#define N_PIPES 64
+#define MESSAGE_SIZE (1 << 18)
+#define N_ROUNDS 4
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void run(const char* name, MioBackend backend, size_t n_threads)
+{
+    ExecutorConfig config = executor_config_default();
+    config.n_threads = n_threads;
+    config.mio.backend = backend;
+    Executor* executor = executor_create_with_config(&config);
+    if (mio_backend(executor_mio(executor)) != backend) {
+        printf("%-16s unavailable\n", name);
+        executor_destroy(executor);
+        return;
+    }
+
+    static char message[MESSAGE_SIZE];
+    static uint8_t buffers[N_PIPES][MESSAGE_SIZE];
+    static PipeWriteFuture writers[N_PIPES];
+    static PipeReadFuture readers[N_PIPES];
+    int fds[N_PIPES][2];
+    for (int i = 0; i < N_PIPES; i++)
+        ASSERT_SYS_OK(pipe2(fds[i], O_NONBLOCK | O_CLOEXEC));
+
+    double start = now();
+    for (int round = 0; round < N_ROUNDS; round++) {
+        for (int i = 0; i < N_PIPES; i++) {
+            writers[i] = pipe_write_future_create(fds[i][1], MESSAGE_SIZE, false);
+            writers[i].base.arg = message;
+            readers[i] = pipe_read_future_create(fds[i][0], buffers[i], MESSAGE_SIZE);
+            executor_spawn(executor, (Future*)&writers[i]);
+            executor_spawn(executor, (Future*)&readers[i]);
+        }
+        executor_run(executor);
+    }
+    double elapsed = now() - start;
+
+    MioStats stats;
+    mio_stats(executor_mio(executor), &stats);
+    double mib = (double)N_PIPES * MESSAGE_SIZE * N_ROUNDS / (1 << 20);
+    printf("%-16s %zu thread(s): %8.1f MiB/s, polls %7llu, epoll_ctl %7llu, submissions %7llu\n",
+        name, n_threads, mib / elapsed, (unsigned long long)stats.polls,
+        (unsigned long long)stats.ctl_syscalls, (unsigned long long)stats.submissions);
+
+    executor_destroy(executor);
+    for (int i = 0; i < N_PIPES; i++) {
+        ASSERT_SYS_OK(close(fds[i][0]));
+        ASSERT_SYS_OK(close(fds[i][1]));
+    }
+}
+
+int main()
+{
+    size_t const threads[] = { 0, 2 };
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        run("epoll", MIO_BACKEND_EPOLL, threads[t]);
+        run("io_uring", MIO_BACKEND_IO_URING, threads[t]);
+        run("io_uring+sqpoll", MIO_BACKEND_IO_URING_SQPOLL, threads[t]);
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+// Required for `unistd.h` include to contain `pipe2`.
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "err.h"
+#include "executor.h"
+#include "future_examples.h"
+#include "mio.h"
+
+// Counts epoll_ctl syscalls while a PipeReadFuture reads a pipe fed one byte at a time,
+// so that (almost) every byte costs an EAGAIN and a re-registration.
+
+#define N_BYTES 2000
+
+static void* slow_writer(void* arg)
+{
+    int fd = *(int*)arg;
+    struct timespec delay = { .tv_sec = 0, .tv_nsec = 20000 };
+    for (int i = 0; i < N_BYTES; i++) {
+        uint8_t byte = (uint8_t)i;
+        ASSERT_SYS_OK(write(fd, &byte, 1));
+        nanosleep(&delay, NULL);
+    }
+    return NULL;
+}
+
+int main()
+{
+    int fds[2];
+    ASSERT_SYS_OK(pipe2(fds, O_NONBLOCK));
+    ASSERT_SYS_OK(fcntl(fds[1], F_SETFL, 0)); // The writer may block.
+
+    Executor* executor = executor_create(0);
+    static uint8_t buffer[N_BYTES];
+    PipeReadFuture reader = pipe_read_future_create(fds[0], buffer, N_BYTES);
+    executor_spawn(executor, (Future*)&reader);
+
+    pthread_t writer;
+    ASSERT_ZERO(pthread_create(&writer, NULL, slow_writer, &fds[1]));
+    executor_run(executor);
+    ASSERT_ZERO(pthread_join(writer, NULL));
+
+    MioStats stats;
+    mio_stats(executor_mio(executor), &stats);
+    printf("bytes read:          %d\n", N_BYTES);
+    printf("mio_register calls:  %llu (each one an EPOLL_CTL_ADD before)\n",
+        (unsigned long long)stats.registers);
+    printf("epoll_ctl syscalls:  %llu\n", (unsigned long long)stats.ctl_syscalls);
+    printf("epoll_wait syscalls: %llu\n", (unsigned long long)stats.polls);
+
+    executor_destroy(executor);
+    ASSERT_SYS_OK(close(fds[0]));
+    ASSERT_SYS_OK(close(fds[1]));
+    return 0;
+}
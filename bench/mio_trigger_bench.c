@@ -0,0 +1,78 @@
+// Required for `unistd.h` include to contain `pipe2`.
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "err.h"
+#include "executor.h"
+#include "future_examples.h"
+#include "mio.h"
+
+// Reads a pipe fed in bursts with each registration mode, on a 2-worker executor (so the poller
+// may look at the fd again while another worker is still draining it), and reports how many
+// wakes and progress() calls each mode costs.
+
+#define N_BURSTS 2000
+#define BURST_SIZE 4096
+
+static void* bursty_writer(void* arg)
+{
+    int fd = *(int*)arg;
+    static uint8_t burst[BURST_SIZE];
+    struct timespec delay = { .tv_sec = 0, .tv_nsec = 50000 };
+    for (int i = 0; i < N_BURSTS; i++) {
+        for (size_t done = 0; done < BURST_SIZE;) {
+            ssize_t n = write(fd, burst + done, BURST_SIZE - done);
+            ASSERT_SYS_OK(n);
+            done += n;
+        }
+        nanosleep(&delay, NULL);
+    }
+    return NULL;
+}
+
+static void run(const char* name, uint32_t trigger)
+{
+    int fds[2];
+    ASSERT_SYS_OK(pipe2(fds, O_NONBLOCK));
+    ASSERT_SYS_OK(fcntl(fds[1], F_SETFL, 0)); // The writer may block.
+
+    Executor* executor = executor_create_multi(2, 0);
+    static uint8_t buffer[N_BURSTS * BURST_SIZE];
+    PipeReadFuture reader = pipe_read_future_create(fds[0], buffer, sizeof(buffer));
+    reader.trigger = trigger;
+    executor_spawn(executor, (Future*)&reader);
+
+    pthread_t writer;
+    ASSERT_ZERO(pthread_create(&writer, NULL, bursty_writer, &fds[1]));
+    executor_run(executor);
+    ASSERT_ZERO(pthread_join(writer, NULL));
+
+    ExecutorStats stats;
+    executor_stats(executor, &stats);
+    MioStats mio_stats_;
+    mio_stats(executor_mio(executor), &mio_stats_);
+    printf("%-16s bursts %d: epoll_wait %6llu, events %6llu, wakes %6zu (coalesced %6zu), "
+           "progress %6zu\n",
+        name, N_BURSTS, (unsigned long long)mio_stats_.polls, (unsigned long long)mio_stats_.events,
+        stats.wakes, stats.wakes_coalesced, stats.progressed);
+
+    executor_destroy(executor);
+    ASSERT_SYS_OK(close(fds[0]));
+    ASSERT_SYS_OK(close(fds[1]));
+}
+
+int main()
+{
+    run("level-triggered", 0);
+    run("EPOLLET", EPOLLET);
+    run("EPOLLONESHOT", EPOLLONESHOT);
+    return 0;
+}
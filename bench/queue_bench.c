@@ -0,0 +1,121 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "executor.h"
+#include "future.h"
+#include "futque.h"
+
+// Compares the growable, mask-indexed FutQue with the fixed-size `%`-indexed ring it replaced,
+// and measures end-to-end spawn + progress throughput of the executor.
+
+#define N_OPS 10000000
+#define BATCH 1000
+#define N_SPAWNS 1000000
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* The previous run queue: fixed capacity, modulo indexing, drops futures when full. */
+typedef struct LegacyQue {
+    Future** futs;
+    size_t size;
+    size_t max_size;
+    int front;
+    int back;
+} LegacyQue;
+
+static void legacy_push(LegacyQue* que, Future* fut)
+{
+    if (que->size == que->max_size)
+        return;
+    que->back = (que->back + 1) % que->max_size;
+    que->futs[que->back] = fut;
+    que->size++;
+}
+
+static Future* legacy_pop(LegacyQue* que)
+{
+    if (que->size == 0)
+        return NULL;
+    Future* fut = que->futs[que->front];
+    que->front = (que->front + 1) % que->max_size;
+    que->size--;
+    return fut;
+}
+
+static void bench_legacy(size_t max_size)
+{
+    LegacyQue que = { malloc(max_size * sizeof(Future*)), 0, max_size, 0, -1 };
+    Future fut;
+    uintptr_t sink = 0;
+
+    double start = now();
+    for (size_t i = 0; i < N_OPS; i += BATCH) {
+        for (size_t j = 0; j < BATCH; j++)
+            legacy_push(&que, &fut);
+        for (size_t j = 0; j < BATCH; j++)
+            sink += (uintptr_t)legacy_pop(&que);
+    }
+    double elapsed = now() - start;
+    printf("legacy ring (cap %5zu):   %6.2f Mops/s (push+pop)%s\n", max_size,
+        N_OPS / elapsed / 1e6, sink == 0 ? " [dropped]" : "");
+    free(que.futs);
+}
+
+static void bench_futque(size_t initial)
+{
+    FutQue que;
+    if (futque_init(&que, initial) != 0)
+        exit(1);
+    Future fut;
+    uintptr_t sink = 0;
+
+    double start = now();
+    for (size_t i = 0; i < N_OPS; i += BATCH) {
+        for (size_t j = 0; j < BATCH; j++)
+            futque_push(&que, &fut);
+        for (size_t j = 0; j < BATCH; j++)
+            sink += (uintptr_t)futque_pop(&que);
+    }
+    double elapsed = now() - start;
+    printf("futque     (init %5zu):   %6.2f Mops/s (push+pop), grew to %zu%s\n", initial,
+        N_OPS / elapsed / 1e6, que.mask + 1, sink == 0 ? " [dropped]" : "");
+    futque_destroy(&que);
+}
+
+static FutureState nop_progress(Future* fut, Mio* mio, Waker waker) { return FUTURE_COMPLETED; }
+
+static void bench_executor(void)
+{
+    Future* futs = malloc(N_SPAWNS * sizeof(Future));
+    for (size_t i = 0; i < N_SPAWNS; i++)
+        futs[i] = future_create(nop_progress);
+
+    Executor* executor = executor_create(0);
+    double start = now();
+    for (size_t i = 0; i < N_SPAWNS; i++)
+        executor_spawn(executor, &futs[i]);
+    double spawned = now();
+    executor_run(executor);
+    double end = now();
+    executor_destroy(executor);
+
+    printf("executor: spawn %6.2f Mfut/s, run %6.2f Mfut/s (%d futures)\n",
+        N_SPAWNS / (spawned - start) / 1e6, N_SPAWNS / (end - spawned) / 1e6, N_SPAWNS);
+    free(futs);
+}
+
+int main()
+{
+    bench_legacy(BATCH);
+    bench_futque(BATCH);
+    bench_futque(FUTQUE_DEFAULT_CAPACITY);
+    bench_executor();
+    return 0;
+}
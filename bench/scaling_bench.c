@@ -0,0 +1,73 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "executor.h"
+#include "future.h"
+
+// Runs CPU-bound futures (each yielding between stages) on 1..N worker threads.
+// Usage: scaling_bench [max_threads]   (defaults to the number of online CPUs)
+
+#define N_TASKS 256
+#define N_STAGES 20
+#define STAGE_ITERS 200000
+
+typedef struct CpuFuture {
+    Future base;
+    int stage;
+    uint64_t acc;
+} CpuFuture;
+
+static FutureState cpu_progress(Future* base, Mio* mio, Waker waker)
+{
+    CpuFuture* self = (CpuFuture*)base;
+    uint64_t x = self->acc + 1;
+    for (int i = 0; i < STAGE_ITERS; i++)
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    self->acc = x;
+
+    if (++self->stage < N_STAGES) {
+        waker_wake(&waker);
+        return FUTURE_PENDING;
+    }
+    return FUTURE_COMPLETED;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double run(size_t n_threads)
+{
+    static CpuFuture futs[N_TASKS];
+    Executor* executor = n_threads == 0 ? executor_create(0) : executor_create_multi(n_threads, 0);
+    for (int i = 0; i < N_TASKS; i++) {
+        futs[i] = (CpuFuture) { .base = future_create(cpu_progress), .acc = i };
+        executor_spawn(executor, (Future*)&futs[i]);
+    }
+    double start = now();
+    executor_run(executor);
+    double elapsed = now() - start;
+    executor_destroy(executor);
+    return elapsed;
+}
+
+int main(int argc, char** argv)
+{
+    long max_threads = argc > 1 ? atol(argv[1]) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads < 1)
+        max_threads = 1;
+
+    double base = run(0);
+    printf("current-thread: %.3f s\n", base);
+    for (long n = 1; n <= max_threads; n++) {
+        double elapsed = run(n);
+        printf("%2ld workers:     %.3f s  (speedup %.2fx)\n", n, elapsed, base / elapsed);
+    }
+    return 0;
+}
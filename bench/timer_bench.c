@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "err.h"
+#include "executor.h"
+#include "future_examples.h"
+#include "mio.h"
+
+// Arms and cancels a million Mio timers, then runs a million SleepFutures to completion, and
+// reports the cost per timer and how many polls the executor needed to fire them all.
+
+#define N_TIMERS 1000000
+#define MAX_SLEEP_MS 1000
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench_register_cancel(void)
+{
+    Executor* executor = executor_create(0);
+    Mio* mio = executor_mio(executor);
+    MioTimer* timers = malloc(N_TIMERS * sizeof(MioTimer));
+    if (!timers)
+        fatal("malloc");
+    Waker waker = { .executor = executor, .future = NULL };
+    uint64_t const base = mio_now_ms();
+
+    double start = now();
+    for (int i = 0; i < N_TIMERS; i++) {
+        timers[i] = mio_timer_create();
+        // Deadlines spread from a millisecond to a day ahead.
+        mio_register_timer(mio, &timers[i], base + 1 + (uint64_t)rand() % (24 * 3600 * 1000), waker);
+    }
+    double registered = now();
+    for (int i = 0; i < N_TIMERS; i++)
+        mio_cancel_timer(mio, &timers[i]);
+    double cancelled = now();
+
+    printf("register: %6.1f ns/timer, cancel: %6.1f ns/timer\n",
+        (registered - start) * 1e9 / N_TIMERS, (cancelled - registered) * 1e9 / N_TIMERS);
+    free(timers);
+    executor_destroy(executor);
+}
+
+static void bench_sleeps(size_t n_threads)
+{
+    ExecutorConfig config = executor_config_default();
+    config.n_threads = n_threads;
+    Executor* executor = executor_create_with_config(&config);
+    SleepFuture* sleeps = malloc(N_TIMERS * sizeof(SleepFuture));
+    if (!sleeps)
+        fatal("malloc");
+    for (int i = 0; i < N_TIMERS; i++) {
+        sleeps[i] = sleep_future_create(rand() % MAX_SLEEP_MS);
+        executor_spawn(executor, (Future*)&sleeps[i]);
+    }
+
+    double start = now();
+    executor_run(executor);
+    double elapsed = now() - start;
+
+    MioStats stats;
+    mio_stats(executor_mio(executor), &stats);
+    printf("%zu thread(s): %d sleeps of up to %d ms in %.3f s, %llu polls, %llu fired\n",
+        n_threads, N_TIMERS, MAX_SLEEP_MS, elapsed, (unsigned long long)stats.polls,
+        (unsigned long long)stats.timers_fired);
+    free(sleeps);
+    executor_destroy(executor);
+}
+
+int main()
+{
+    bench_register_cancel();
+    bench_sleeps(0);
+    bench_sleeps(4);
+    return 0;
+}
@@ -1,14 +1,41 @@
 #ifndef DEBUG_H
 #define DEBUG_H
 
-// TODO: comment this to disable debug prints
-#define DEBUG_PRINTS
+// Debug prints are chosen at compile time, with the DEBUG_LOG CMake option:
+// - OFF: `debug()` compiles to nothing, its arguments are not even evaluated;
+// - STDERR (defines DEBUG_PRINTS): each message is printed to stderr right away;
+// - RING (defines DEBUG_PRINTS and DEBUG_TRACE_RING): each message is stored in an in-memory
+//   ring buffer, which a background thread writes to stderr (see `trace_ring_vwrite`).
+// Errors are reported with `perror()` regardless: only the debug prints are optional.
 
 #ifdef DEBUG_PRINTS
 
 #include <stdarg.h>
 #include <stdio.h>
 
+#ifdef DEBUG_TRACE_RING
+
+/**
+ * Formats a message into the trace ring buffer, without locks or syscalls.
+ *
+ * Messages longer than a ring record are truncated. When the ring is full (the flushing thread
+ * is behind), the message is dropped and counted; the count is reported with the next flush.
+ */
+void trace_ring_vwrite(const char* fmt, va_list args);
+
+/** Writes out every message still in the ring buffer (done at exit, too). */
+void trace_ring_flush(void);
+
+static inline void debug(const char* fmt, ...)
+{
+    va_list fmt_args;
+    va_start(fmt_args, fmt);
+    trace_ring_vwrite(fmt, fmt_args);
+    va_end(fmt_args);
+}
+
+#else // DEBUG_TRACE_RING
+
 static inline void debug(const char* fmt, ...)
 {
     va_list fmt_args;
@@ -17,11 +44,12 @@ static inline void debug(const char* fmt, ...)
     va_end(fmt_args);
 }
 
+#endif // DEBUG_TRACE_RING
+
 #else // DEBUG_PRINTS
 
-#define perror(ARGS...)
-#define debug(ARGS...)
+#define debug(ARGS...) ((void)0)
 
 #endif // DEBUG_PRINTS
 
-#endif // DEBUG_H
\ No newline at end of file
+#endif // DEBUG_H
@@ -1,12 +1,13 @@
 #ifndef EXECUTOR_H
 #define EXECUTOR_H
 
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stddef.h>
 
+#include "future.h"
 #include "mio.h"
 
-typedef struct Future Future;
-
 /**
  * Represents an executor that drives futures to completion.
  *
@@ -16,24 +17,225 @@ typedef struct Future Future;
 
 typedef struct Executor Executor;
 
-/** Creates a new executor (with a specified queue size). */
+/**
+ * Creates a new executor.
+ *
+ * The run queue grows on demand; `max_queue_size` is a hard cap on the number of spawned but not
+ * yet finished futures (0 means unbounded). Spawning beyond the cap fails, see `executor_spawn`.
+ *
+ * Futures run on the thread calling `executor_run()`, but `executor_spawn` and `waker_wake` may
+ * be called from any thread: such futures go through a lock-free injection queue, and the
+ * executor is woken up (even if blocked in `mio_poll`). This is how a thread finishing a blocking
+ * computation hands its result back to a future.
+ */
 Executor* executor_create(size_t max_queue_size);
 
+/**
+ * Creates a new multi-threaded executor, running futures on `n_threads` worker threads.
+ *
+ * `executor_run()` uses the calling thread as one of the workers and starts the others. Each
+ * worker has its own queue and steals from the others when idle; all workers share one Mio.
+ * Futures spawned on such an executor may be progressed on any of the worker threads (but never
+ * on two at once), and `waker_wake` may be called from any thread.
+ * `max_queue_size` has the same meaning as for `executor_create`.
+ */
+Executor* executor_create_multi(size_t n_threads, size_t max_queue_size);
+
+/** Options for `executor_create_with_config`; start from `executor_config_default()`. */
+typedef struct ExecutorConfig {
+    size_t max_queue_size; // Cap on active futures (0 = unbounded), see `executor_create`.
+    size_t n_threads; // 0 for a current-thread executor, else see `executor_create_multi`.
+    MioConfig mio; // Options of the executor's Mio (e.g., the I/O backend).
+    /**
+     * Check Mio for ready events (without waiting) every `poll_interval` futures progressed by a
+     * thread, so that I/O readiness is noticed while there is still work queued, rather than only
+     * once the queues run dry. 0 disables it. Default: 61.
+     */
+    size_t poll_interval;
+    /**
+     * When out of work, keep checking Mio without waiting for up to this many microseconds before
+     * blocking in `mio_poll`: lower wake latency for latency-sensitive pipelines, at the cost of a
+     * busy CPU. Default: 0 (block right away).
+     */
+    unsigned poll_spin_us;
+    /** Most threads running blocking calls at once (see `executor_run_blocking`). Default: 8. */
+    size_t max_blocking_threads;
+    /** Address space reserved for `executor_alloc_future`, in bytes. Default: 64 MiB. */
+    size_t future_arena_size;
+    /**
+     * Units of work a future may do per progress call before yielding, so that one busy future
+     * (e.g., reading a pipe that never runs dry) cannot hold its thread indefinitely; see
+     * `executor_budget_spend`. 0 means unlimited. Default: 128.
+     */
+    size_t task_budget;
+} ExecutorConfig;
+
+/** Returns the configuration of `executor_create(0)`. */
+ExecutorConfig executor_config_default(void);
+
+/** Creates a new executor with the given options. */
+Executor* executor_create_with_config(ExecutorConfig const* config);
+
 /**
  * Submits a future to be managed by the executor.
  *
  * The future will be progressed (in `executor_run()`) until complete.
+ *
+ * @return 0 on success, -1 if the future was not queued: errno is EAGAIN when the executor already
+ *         holds `max_queue_size` active futures (backpressure: retry once some complete),
+ *         or ENOMEM when the queue could not grow.
+ */
+int executor_spawn(Executor* executor, Future* fut);
+
+/** Called once a detached future completed (see `executor_spawn_detached`). */
+typedef void (*CompletionFn)(Future* fut, FutureState state, void* ctx);
+
+/** Releases a completed detached future (see `executor_spawn_detached`). */
+typedef void (*DestroyFn)(Future* fut, void* ctx);
+
+/**
+ * Submits a future that the executor takes ownership of (a detached task).
+ *
+ * Once it completes, on the thread that progressed it, `on_complete(fut, state, ctx)` is called
+ * with the FutureState it returned (its result and error code still readable), then
+ * `destroy(fut, ctx)`, which releases the future (e.g., frees it, closes its descriptors). For a
+ * future from `executor_alloc_future`, the executor then also releases its memory. Either
+ * callback may be NULL, and either may spawn further futures; the future must not be accessed by
+ * anyone else once spawned.
+ *
+ * @return as for `executor_spawn` (plus EINVAL if the future is already active). On failure,
+ *         no callback is called and the caller keeps ownership of the future.
+ */
+int executor_spawn_detached(
+    Executor* executor, Future* fut, CompletionFn on_complete, DestroyFn destroy, void* ctx);
+
+/**
+ * A future that completes when a task spawned with `executor_spawn_handle` does, with its result:
+ * the same FutureState, `ok` and `errcode`.
+ *
+ * It can be awaited by any future (progressed inline, e.g., as a child of `future_join_all`) or
+ * spawned itself, on any executor. While the task runs it stays pending, and is woken by the
+ * task's completion (through the waker it was last progressed with), not by polling.
+ */
+typedef struct JoinHandle {
+    Future base;
+    Waker waker; // Of the awaiting future.
+    atomic_uint state; // JOIN_* bits, private to the executor.
+    FutureState outcome; // Of the task, once done.
+} JoinHandle;
+
+/**
+ * Spawns a task, as with `executor_spawn_detached`, and initializes `handle` to await it.
+ *
+ * The handle must stay valid (not be moved or freed) until the task completed, even if nobody
+ * awaits it anymore. The task itself may come from `executor_alloc_future`: its result is copied
+ * to the handle before the executor releases it.
+ *
+ * @return as for `executor_spawn_detached`.
  */
-void executor_spawn(Executor* executor, Future* fut);
+int executor_spawn_handle(Executor* executor, Future* task, JoinHandle* handle);
 
 /**
  * Runs the executor, driving futures to completion.
  *
  * The executor continuously calls future.progress() and processes events from the MIO layer.
- * This function blocks until all spawned futures are completed.
+ * This function blocks until all spawned futures are completed (if some only wait for a wake from
+ * another thread, it sleeps until that comes).
  */
 void executor_run(Executor* executor);
 
+/** A function call to run off the executor's threads (see `executor_run_blocking`). */
+typedef struct BlockingTask {
+    void* (*func)(void*);
+    void* arg;
+    void* result; // What func returned, once done.
+    Waker waker; // Woken once func returned.
+    atomic_bool done; // Set once the wake was delivered: the pool is done with the task.
+    atomic_bool returned; // Private to the executor: `result` is set, the wake is under way.
+    struct BlockingTask* next; // Private to the executor.
+} BlockingTask;
+
+/**
+ * Runs `task->func(task->arg)` on one of the executor's blocking threads, so that a blocking or
+ * long computation does not stall the futures. When it returns, `task->result` is set, then
+ * `task->waker` is woken (from that thread), and only then `task->done` is set: from then on, the
+ * pool touches neither the task nor the woken future, which may complete and be freed.
+ *
+ * Threads are started on demand, up to `max_blocking_threads` (further tasks wait for one to be
+ * free), and stopped by `executor_destroy`. The task must stay valid (not be moved or freed) until
+ * done; see `spawn_blocking_future_create` for a future wrapping it.
+ *
+ * @return 0 on success, -1 if no thread could run the task (errno set by pthread_create).
+ */
+int executor_run_blocking(Executor* executor, BlockingTask* task);
+
+/**
+ * Whether a task passed to `executor_run_blocking` is done, for the future its waker belongs to.
+ *
+ * Once func returned, the wake is under way and may be what this progress call comes from, so a
+ * PENDING state would lose it: then this waits (yielding the CPU) until the wake was delivered and
+ * returns true. It returns false only if the task is still running, so a wake is still to come.
+ */
+bool blocking_task_done(BlockingTask* task);
+
+/**
+ * Spends `units` of the budget of the future being progressed on the calling thread (see
+ * `ExecutorConfig.task_budget`). Futures doing an unbounded amount of work in a loop call it
+ * before each step (a syscall costs one unit; built-in futures add one per 4 KiB moved), and once
+ * it returns false, wake themselves and return FUTURE_PENDING: other futures then get their turn
+ * before the loop continues. Children progressed by a combinator share their parent's budget.
+ *
+ * @return false, spending nothing, if the budget was already exhausted; true otherwise, and
+ *         always when called outside of a progress call of this executor, or without a budget.
+ */
+bool executor_budget_spend(Executor* executor, size_t units);
+
+/** Largest future `executor_alloc_future` can allocate, in bytes. */
+#define EXECUTOR_MAX_FUTURE_SIZE 4096
+
+/**
+ * Allocates memory for a future of `size` bytes, to be spawned on this executor, from a slab
+ * allocator owned by the executor: sizes are rounded up to a power of two (64 bytes at least),
+ * and blocks are reused. The memory is uninitialized; initialize the future in it (e.g.,
+ * `*(ThenFuture*)mem = future_then(...)`), then spawn it.
+ *
+ * Such a future is released by the executor as soon as it completes (when it would be marked
+ * inactive): it must not be accessed afterwards, so its result must be consumed in its own
+ * `progress` or in an `on_complete` callback (see `executor_spawn_detached`), and it must not be
+ * embedded in, or awaited by, another future.
+ *
+ * May be called from any thread; it takes no lock on the threads of the executor in most cases.
+ *
+ * @return The memory, or NULL with errno set to EINVAL if `size` exceeds EXECUTOR_MAX_FUTURE_SIZE,
+ *         or to ENOMEM if `future_arena_size` is exhausted.
+ */
+void* executor_alloc_future(Executor* executor, size_t size);
+
+/** Releases memory from `executor_alloc_future` whose future was not (successfully) spawned. */
+void executor_free_future(Executor* executor, void* fut);
+
+/** Returns the Mio instance owned by the executor. */
+Mio* executor_mio(Executor* executor);
+
+/** Counters describing the work done by an executor so far (see `executor_stats`). */
+typedef struct ExecutorStats {
+    size_t spawned; // Futures accepted by executor_spawn().
+    size_t wakes; // Calls to waker_wake().
+    size_t wakes_coalesced; // Wakes of futures that were already queued (collapsed into that entry).
+    size_t wakes_stale; // Wakes of futures that had already completed (ignored).
+    size_t progressed; // Calls to future.progress() made by the executor.
+    size_t injected; // Futures queued from threads outside the executor (remote spawns and wakes).
+    size_t budget_exhausted; // Calls to executor_budget_spend() that found the budget exhausted.
+} ExecutorStats;
+
+/**
+ * Fills `stats` with the executor's counters.
+ *
+ * On a multi-threaded executor the counters of running workers are read without synchronization,
+ * so the result is only a snapshot.
+ */
+void executor_stats(Executor* executor, ExecutorStats* stats);
+
 /** Destroys the executor and frees its resources. */
 void executor_destroy(Executor* executor);
 
@@ -1,6 +1,7 @@
 #ifndef FUTURE_H
 #define FUTURE_H
 
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -66,6 +67,19 @@ struct Future {
      */
     bool is_active;
 
+    /**
+     * Scheduling state bits private to the executor: whether the future is queued, being
+     * progressed, or was woken while being progressed. They let the executor collapse duplicate
+     * wakes into a single queue entry. Initially zero; only the executor is allowed to modify it.
+     */
+    atomic_uchar sched_state;
+
+    /** Link in the executor's injection queue (of wakes from other threads); executor-private. */
+    _Atomic(Future*) inject_next;
+
+    /** Completion callbacks of a future spawned with `executor_spawn_detached`; executor-private. */
+    struct DetachedTask* detached;
+
     void* arg; // An optional input argument of the future.
     void* ok; // An optional result; only meaningful if `progress` returned FUTURE_COMPLETED.
     int errcode; // Only meaningful if `progress` returned FUTURE_FAILURE or FUTURE_COMPLETED.
@@ -76,6 +90,9 @@ static inline Future future_create(ProgressFn progress_fn)
     return (Future) {
         .progress = progress_fn,
         .is_active = false,
+        .sched_state = 0,
+        .inject_next = NULL,
+        .detached = NULL,
         .errcode = FUTURE_SUCCESS,
         .arg = NULL,
         .ok = NULL,
@@ -1,9 +1,12 @@
 #ifndef FUTURE_COMBINATORS_H
 #define FUTURE_COMBINATORS_H
 
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "future.h"
+#include "waker.h"
 
 #define THEN_FUTURE_ERR_FUT1_FAILED 1
 #define THEN_FUTURE_ERR_FUT2_FAILED 2
@@ -38,6 +41,8 @@ ThenFuture future_then(Future* fut1, Future* fut2);
  * futures returns FAILURE. JoinFuture shall save corresponding returns and
  * errcodes. Upon completion of both futures, JoinFuture returns FAILURE if
  * either of the futures returns FAILURE; else it returns COMPLETED.
+ * Each future gets its own waker, so that only the future(s) woken since the
+ * last progress are progressed again.
  */
 typedef struct JoinFuture {
     Future base; // Base future structure
@@ -55,6 +60,10 @@ typedef struct JoinFuture {
             void* ok;
         } fut2; // Result of the second future.
     } result;
+    bool started; // Whether both futures were progressed once already.
+    WakerSlot slot1; // Whether fut1 was woken since it was last progressed.
+    WakerSlot slot2; // Same for fut2.
+    _Atomic(WakerSlot*) ready; // The slots of the woken futures.
 } JoinFuture;
 
 /** Creates a JoinFuture that executes two futures concurrently. */
@@ -66,6 +75,7 @@ JoinFuture future_join(Future* fut1, Future* fut2);
  * The SelectFuture is considered COMPLETED when fut1 or fut2 are COMPLETED.
  * SelectFuture shall progress the other future even if one of the futures returned FAILURE.
  * SelectFuture shall only propagate error (of whichever future) if both futures fail.
+ * Like in JoinFuture, only the future(s) woken since the last progress are progressed again.
  */
 typedef struct SelectFuture {
     Future base; // Base future structure
@@ -79,9 +89,73 @@ typedef struct SelectFuture {
         SELECT_FAILED_FUT2, // Future 2 has failed and future 1 has not yet completed.
         SELECT_FAILED_BOTH, // Both futures have failed.
     } which_completed;
+    bool started; // Whether both futures were progressed once already.
+    WakerSlot slot1; // Whether fut1 was woken since it was last progressed.
+    WakerSlot slot2; // Same for fut2.
+    _Atomic(WakerSlot*) ready; // The slots of the woken futures.
 } SelectFuture;
 
 /** Creates a SelectFuture that executes two futures until one of them completes successfully. */
 SelectFuture future_select(Future* fut1, Future* fut2);
 
+/** Outcome of one child of a JoinAllFuture or SelectAnyFuture. */
+typedef struct ChildResult {
+    FutureState state; // FUTURE_PENDING until the child completed or failed.
+    int errcode; // The child's errcode, if it failed.
+    void* ok; // The child's result, if it completed.
+    WakerSlot slot; // Private: whether the child was woken since it was last progressed.
+} ChildResult;
+
+#define JOIN_ALL_FUTURE_ERR_FAILED 1 // At least one child failed (see the results).
+
+/**
+ * A combinator that executes n futures concurrently.
+ *
+ * Like JoinFuture, it is COMPLETED once all children are, progresses every child to the end even
+ * if some fail, and returns FAILURE (with JOIN_ALL_FUTURE_ERR_FAILED) if any of them failed.
+ * Each child gets its own waker: when the JoinAllFuture is progressed, only the children woken
+ * since their last progress are progressed again, so a wake costs O(woken children), not O(n).
+ */
+typedef struct JoinAllFuture {
+    Future base; // Base future structure
+    Future** futs; // The children.
+    ChildResult* results; // One per child; `ok` of the JoinAllFuture on completion.
+    size_t n; // Number of children.
+    size_t n_pending; // Children not completed or failed yet.
+    size_t n_failed; // Children that failed.
+    bool started; // Whether every child was progressed once already.
+    _Atomic(WakerSlot*) ready; // Slots of the children woken since they were last progressed.
+} JoinAllFuture;
+
+/**
+ * Creates a JoinAllFuture of the n futures in `futs`, storing their outcomes in `results`.
+ *
+ * Both arrays must stay valid until the children can no longer be woken (typically until the
+ * JoinAllFuture is done).
+ */
+JoinAllFuture future_join_all(Future** futs, size_t n, ChildResult* results);
+
+#define SELECT_ANY_FUTURE_ERR_ALL_FAILED 1 // Every child failed (see the results).
+
+/**
+ * A combinator that executes n futures until one of them completes.
+ *
+ * Like SelectFuture, it is COMPLETED (with the result of that child) as soon as one child is,
+ * keeps progressing the others when one fails, and only fails if all of them fail.
+ * Children are progressed only when woken, as in JoinAllFuture.
+ */
+typedef struct SelectAnyFuture {
+    Future base; // Base future structure
+    Future** futs; // The children.
+    ChildResult* results; // One per child.
+    size_t n; // Number of children.
+    size_t n_failed; // Children that failed.
+    size_t winner; // Index of the child that completed (n while none did).
+    bool started; // Whether every child was progressed once already.
+    _Atomic(WakerSlot*) ready; // Slots of the children woken since they were last progressed.
+} SelectAnyFuture;
+
+/** Creates a SelectAnyFuture of the n futures in `futs` (same requirements as JoinAllFuture). */
+SelectAnyFuture future_select_any(Future** futs, size_t n, ChildResult* results);
+
 #endif // FUTURE_COMBINATORS_H
@@ -4,7 +4,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <sys/uio.h>
 
+#include "executor.h"
 #include "future.h"
 #include "future_combinators.h"
 #include "waker.h"
@@ -22,6 +24,25 @@ typedef struct ApplyFuture {
  */
 ApplyFuture apply_future_create(void* (*func)(void*));
 
+// ========================= SpawnBlockingFuture =========================
+typedef struct SpawnBlockingFuture {
+    Future base;
+    BlockingTask task;
+    bool submitted;
+} SpawnBlockingFuture;
+
+/** errcode of a SpawnBlockingFuture that no thread could be started for. */
+#define SPAWN_BLOCKING_FUTURE_ERR_NO_THREAD 1
+
+/**
+ * Creates a future that calls `func(arg)` on the executor's blocking thread pool (see
+ * `executor_run_blocking`) and completes with its result, without stalling the other futures
+ * meanwhile: for blocking system calls or long computations.
+ *
+ * Once progressed, the future must not be abandoned (nor moved) until it completes.
+ */
+SpawnBlockingFuture spawn_blocking_future_create(void* (*func)(void*), void* arg);
+
 // ========================= PipeReadFuture =========================
 typedef struct PipeReadFuture {
     Future base; // Base future structure
@@ -29,9 +50,12 @@ typedef struct PipeReadFuture {
     uint8_t* buffer; // Buffer to store the result
     size_t n; // Size of the buffer = number of bytes to be read
     size_t read_so_far; // Number of bytes read so far
+    uint32_t trigger; // Registration mode: 0 (level-triggered), EPOLLET or EPOLLONESHOT.
+    MioOp op; // The read in flight, with a completion-based (io_uring) Mio.
 } PipeReadFuture;
 
 #define PIPE_FUTURE_ERR_EOF 1
+#define PIPE_FUTURE_ERR_IO 2 // The read or write failed (other than with EAGAIN or EINTR).
 
 /**
  * Creates a future that reads a fixed number of bytes from a pipe.
@@ -39,6 +63,19 @@ typedef struct PipeReadFuture {
  * The future will call read() from the specified file descriptor
  * until exactly n bytes are read or EOF is reached (write-end of pipe is closed).
  * In the latter case, resolves to FUTURE_FAILURE with errcode set to PIPE_FUTURE_ERR_EOF.
+ *
+ * The fd is registered level-triggered; set `trigger` to EPOLLET or EPOLLONESHOT (see
+ * `mio_register`) before spawning to opt in to another mode. In every mode the future only waits
+ * after read() returned EAGAIN, i.e. after draining the pipe, so edge-triggered wakes are not lost.
+ *
+ * If Mio supports completion-based I/O (io_uring backends), each chunk is instead a read submitted
+ * to the kernel, batched with the executor's next poll. The future (and buffer) must then not be
+ * abandoned while a read is in flight.
+ *
+ * Each read moves at most 64 KiB and spends the task budget (see `executor_budget_spend`): once it
+ * runs out, the future wakes itself and returns FUTURE_PENDING even if more data is ready, so
+ * a pipe that never runs dry does not starve the other futures. The same holds for the other pipe
+ * futures.
  */
 PipeReadFuture pipe_read_future_create(int fd, uint8_t* buffer, size_t n);
 
@@ -49,6 +86,8 @@ typedef struct PipeWriteFuture {
     size_t n; // Number of bytes to be write (input must be at least that size).
     bool stop_on_zero_byte; // Whether to stop writing after a zero byte is written.
     size_t written_so_far; // Number of bytes written so far.
+    uint32_t trigger; // Registration mode: 0 (level-triggered), EPOLLET or EPOLLONESHOT.
+    MioOp op; // The write in flight, with a completion-based (io_uring) Mio.
 } PipeWriteFuture;
 
 /**
@@ -57,7 +96,111 @@ typedef struct PipeWriteFuture {
  * The future will call write() to the specified file descriptor
  * until exactly n bytes are written or a zero byte is written (if stop_on_zero_byte is true).
  * Bytes to be written are taken from the argument of the future `(const char*)future->base.arg`.
+ * Like for PipeReadFuture, `trigger` selects the registration mode, and writes are submitted to the
+ * kernel if Mio supports completion-based I/O.
  */
 PipeWriteFuture pipe_write_future_create(int fd, size_t n, bool stop_on_zero_byte);
 
+// ========================= PipeReadvFuture / PipeWritevFuture =========================
+typedef struct PipeVectoredFuture {
+    Future base;
+    int fd;
+    struct iovec const* iov; // The buffers, in order.
+    int iovcnt;
+    int iov_index; // First buffer not done yet.
+    size_t iov_offset; // Bytes of that buffer done already.
+    size_t transferred; // Bytes done so far, over all buffers.
+    uint32_t trigger; // Registration mode: 0 (level-triggered), EPOLLET or EPOLLONESHOT.
+} PipeVectoredFuture;
+
+typedef PipeVectoredFuture PipeReadvFuture;
+typedef PipeVectoredFuture PipeWritevFuture;
+
+#define PIPE_IOV_BATCH 64 // Most buffers passed to one readv()/writev().
+
+/**
+ * Creates a future that fills the `iovcnt` buffers of `iov`, in order, from a pipe (scatter
+ * read), e.g., a frame header and its payload, without reading into one buffer and splitting it.
+ *
+ * Each step is one readv() over all the buffers left (or the first PIPE_IOV_BATCH of them), so a
+ * short read may end in the middle of a buffer: the next one starts there. It completes (with `ok`
+ * set to `iov`) once all buffers are full, and fails with PIPE_FUTURE_ERR_EOF if the write-end is
+ * closed first (`transferred` tells how far it got), or PIPE_FUTURE_ERR_IO. The buffers (and the
+ * iovec array) must stay valid until it is done. Registration works as for PipeReadFuture; it
+ * always uses readiness, even if Mio supports completion-based I/O.
+ */
+PipeReadvFuture pipe_readv_future_create(int fd, struct iovec const* iov, int iovcnt);
+
+/** Like `pipe_readv_future_create`, writing the buffers to a pipe in order with writev() (gather
+ *  write). */
+PipeWritevFuture pipe_writev_future_create(int fd, struct iovec const* iov, int iovcnt);
+
+// ========================= SpliceFuture =========================
+typedef struct SpliceFuture {
+    Future base;
+    int in_fd; // Source.
+    int out_fd; // Sink.
+    int tee_fd; // Second sink, receiving a copy of the data (-1 if none).
+    size_t n; // Bytes to forward, or SPLICE_UNTIL_EOF.
+    size_t moved; // Bytes forwarded to `out_fd` so far.
+    size_t teed; // Bytes copied to `tee_fd` and not yet forwarded to `out_fd`.
+    uint32_t trigger; // Registration mode: 0 (level-triggered), EPOLLET or EPOLLONESHOT.
+    uint8_t waiting; // Which fds are registered with Mio (private).
+    // The fallback copy when splice() is not supported by the fds (private).
+    uint8_t* ring; // SPLICE_RING_SIZE bytes, allocated on first use.
+    size_t ring_head; // Offset of the oldest byte not written yet.
+    size_t ring_len; // Bytes read and not written yet.
+    size_t ring_read; // Bytes read from `in_fd` so far.
+} SpliceFuture;
+
+#define SPLICE_UNTIL_EOF SIZE_MAX // Forward until the source is closed (EOF then completes).
+#define SPLICE_RING_SIZE (128 * 1024) // Bounded buffer of the fallback copy (two 64 KiB halves).
+
+/**
+ * Creates a future that forwards `n` bytes from `in_fd` to `out_fd` with splice(): the data moves
+ * within the kernel, never copied to user space, and each chunk is written as soon as it is read.
+ *
+ * When the source is empty, it waits for EPOLLIN on `in_fd`; when the sink is full, for EPOLLOUT
+ * on `out_fd` (only one of them is registered at a time, so a ready side that cannot be acted on
+ * does not keep waking it). If splice() does not support the fds (neither end is a pipe), it falls
+ * back to read() and write() through a bounded buffer (SPLICE_RING_SIZE, malloc()ed on first use),
+ * reading ahead while the sink is busy.
+ *
+ * It completes (with `moved` = n, `ok` NULL) once all bytes are forwarded, or at EOF if n is
+ * SPLICE_UNTIL_EOF; it fails with PIPE_FUTURE_ERR_EOF on an earlier EOF, PIPE_FUTURE_ERR_IO
+ * otherwise. Like the pipe futures, it spends the task budget.
+ */
+SpliceFuture splice_future_create(int in_fd, int out_fd, size_t n);
+
+/**
+ * Like `splice_future_create`, also copying the data to `tee_fd` (fan-out): each chunk is first
+ * duplicated with tee(), then moved with splice(). `in_fd` and `tee_fd` must be pipes (there is no
+ * fallback); the sinks then advance in lockstep, at the pace of the slower one.
+ */
+SpliceFuture splice_tee_future_create(int in_fd, int out_fd, int tee_fd, size_t n);
+
+// ========================= SleepFuture =========================
+typedef struct SleepFuture {
+    Future base;
+    uint64_t duration_ms; // How long to sleep, counted from the first progress.
+    bool started; // Whether the timer was armed.
+    MioTimer timer;
+} SleepFuture;
+
+/**
+ * Creates a future that completes (with a NULL result) `duration_ms` milliseconds after it is
+ * first progressed, using a Mio timer: no thread, fd or syscall per sleep.
+ *
+ * Its timer stays linked in Mio until it fires: a sleep dropped while pending (e.g., the loser of
+ * a `future_select` deadline) must first be cancelled with `sleep_future_cancel`.
+ */
+SleepFuture sleep_future_create(uint64_t duration_ms);
+
+/**
+ * Cancels a sleep that will not be progressed again, so that it may be dropped: unlinks its
+ * timer and waits for a wake of it that may be under way. Does nothing if it did not start or
+ * already fired.
+ */
+void sleep_future_cancel(Mio* mio, SleepFuture* fut);
+
 #endif // FUTURE_EXAMPLES_H
@@ -0,0 +1,149 @@
+#ifndef FUTURE_SOCKETS_H
+#define FUTURE_SOCKETS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#include "future.h"
+#include "mio.h"
+
+/*
+ * Futures over nonblocking sockets (TCP, Unix-domain, UDP), built on Mio readiness.
+ *
+ * Unlike the pipe futures, they leave their socket registered with Mio (edge-triggered) once
+ * done, so that the next operation on the socket costs no epoll_ctl(): the readiness Mio keeps
+ * (see `mio_readiness`) tells it whether to try its syscall right away or wait. Only their waker
+ * is dropped (see `mio_detach_waker`), so a finished future may be freed right away. Close such a
+ * socket with `socket_close`, which unregisters it first. The futures always use readiness, even
+ * if Mio supports completion-based I/O, and spend the task budget like the pipe futures.
+ *
+ * On failure, errcode is SOCKET_FUTURE_ERR_EOF or SOCKET_FUTURE_ERR_IO, with the errno of the
+ * failed syscall in `error` for the latter.
+ */
+
+#define SOCKET_FUTURE_ERR_EOF 1 // The peer closed the connection first.
+#define SOCKET_FUTURE_ERR_IO 2 // A syscall failed (other than with EAGAIN or EINTR), see `error`.
+
+/** Unregisters `fd` from Mio (if it is registered) and closes it. Returns what close() does. */
+int socket_close(Mio* mio, int fd);
+
+// ========================= SocketAcceptFuture =========================
+typedef struct SocketAcceptFuture {
+    Future base;
+    int listen_fd; // A nonblocking listening socket.
+    int* fds; // Where accepted connections are stored.
+    size_t max; // Capacity of `fds`.
+    size_t accepted; // Connections stored so far.
+    int error; // errno of a failure.
+} SocketAcceptFuture;
+
+/**
+ * Creates a future that accepts connections on `listen_fd`, batching them: once one is pending,
+ * it keeps calling accept4() until EAGAIN (or `max` connections), and completes with all of them
+ * in `fds` (`ok` set to `fds`, their number in `accepted`). Accepted sockets are nonblocking and
+ * close-on-exec.
+ *
+ * Connections aborted before being accepted (ECONNABORTED, EPROTO) are skipped. Other errors
+ * (e.g., EMFILE) complete the batch if it is not empty, and fail the future otherwise. To keep
+ * accepting, create a new future over the same listener once this one completes.
+ */
+SocketAcceptFuture socket_accept_future_create(int listen_fd, int* fds, size_t max);
+
+// ========================= SocketConnectFuture =========================
+typedef struct SocketConnectFuture {
+    Future base;
+    int fd; // A nonblocking socket, not connected yet.
+    struct sockaddr_storage addr;
+    socklen_t addrlen;
+    bool started; // Whether connect() was called.
+    int error; // errno of a failure.
+} SocketConnectFuture;
+
+/**
+ * Creates a future that connects `fd` to the address `addr` (copied into the future). An
+ * `addrlen` larger than `struct sockaddr_storage` makes it fail on the first progress, with EINVAL.
+ *
+ * connect() is called on the first progress; if the connection cannot be made right away
+ * (EINPROGRESS), the future waits for EPOLLOUT and then reads the outcome from SO_ERROR. It fails
+ * with SOCKET_FUTURE_ERR_IO and `error` set, e.g., to ECONNREFUSED, or to EAGAIN when the backlog
+ * of a Unix-domain listener is full.
+ */
+SocketConnectFuture socket_connect_future_create(
+    int fd, struct sockaddr const* addr, socklen_t addrlen);
+
+// ========================= SocketRecvFuture =========================
+typedef struct SocketRecvFuture {
+    Future base;
+    int fd;
+    uint8_t* buffer;
+    size_t n; // Capacity of `buffer`.
+    size_t min; // Bytes to receive at least before completing (1 to n).
+    size_t received; // Bytes received so far.
+    int error; // errno of a failure.
+} SocketRecvFuture;
+
+/**
+ * Creates a future that receives up to `n` bytes from a connected socket into `buffer`.
+ *
+ * Like recv(), it completes as soon as something was received: it calls recv() until `n` bytes
+ * are in or it gets EAGAIN, waiting for more only while fewer than `min` bytes are (1 by default;
+ * set `min` to `n` before spawning to receive exactly `n` bytes). It completes with `ok` set to
+ * `buffer` and `received` bytes in it, and fails with SOCKET_FUTURE_ERR_EOF if the peer closes the
+ * connection before `min` bytes (a hang-up reported by Mio is noticed without a recv() call).
+ */
+SocketRecvFuture socket_recv_future_create(int fd, uint8_t* buffer, size_t n);
+
+// ========================= SocketSendFuture =========================
+typedef struct SocketSendFuture {
+    Future base;
+    int fd;
+    uint8_t const* buffer;
+    size_t n; // Bytes to send.
+    size_t sent; // Bytes sent so far.
+    int error; // errno of a failure.
+} SocketSendFuture;
+
+/**
+ * Creates a future that sends the `n` bytes of `buffer` to a connected socket, resuming after
+ * partial sends (when the socket buffer is full, it waits for EPOLLOUT). It completes with `ok` set
+ * to `buffer`. It sends with MSG_NOSIGNAL: a peer that closed the connection fails the future (with
+ * EPIPE or ECONNRESET in `error`) rather than raising SIGPIPE.
+ */
+SocketSendFuture socket_send_future_create(int fd, uint8_t const* buffer, size_t n);
+
+// ========================= UdpRecvBatchFuture / UdpSendBatchFuture =========================
+typedef struct UdpBatchFuture {
+    Future base;
+    int fd; // A nonblocking datagram socket.
+    struct mmsghdr* msgs; // The datagrams (see recvmmsg(2)).
+    unsigned vlen; // Number of entries of `msgs`.
+    unsigned done; // Datagrams received or sent so far (in `msgs`, in order).
+    int error; // errno of a failure.
+} UdpBatchFuture;
+
+typedef UdpBatchFuture UdpRecvBatchFuture;
+typedef UdpBatchFuture UdpSendBatchFuture;
+
+/**
+ * Creates a future that receives up to `vlen` datagrams from `fd` into `msgs` with recvmmsg(): as
+ * many as are queued per syscall, so one readiness event (and one progress) takes a whole burst.
+ *
+ * Like SocketRecvFuture, it completes as soon as something was received: once one datagram is
+ * queued, it calls recvmmsg() until `vlen` datagrams are in or it gets EAGAIN. It completes with
+ * `ok` set to `msgs` and `done` datagrams received, each with its length in `msg_len` (and, if
+ * `msg_name` is set, its source address, with `msg_hdr.msg_namelen` updated: reset it before
+ * reusing `msgs`). The buffers must stay valid until it is done.
+ */
+UdpRecvBatchFuture udp_recv_batch_future_create(int fd, struct mmsghdr* msgs, unsigned vlen);
+
+/**
+ * Creates a future that sends the `vlen` datagrams of `msgs` to `fd` with sendmmsg(), as many per
+ * syscall as the socket takes, waiting for EPOLLOUT when its buffer is full. It completes with
+ * `ok` set to `msgs` once all are sent (`msg_len` set to the bytes sent of each). Note that UDP
+ * does not wait for the receiver: datagrams that find its buffer full are dropped.
+ */
+UdpSendBatchFuture udp_send_batch_future_create(int fd, struct mmsghdr* msgs, unsigned vlen);
+
+#endif // FUTURE_SOCKETS_H
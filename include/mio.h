@@ -1,19 +1,51 @@
 #ifndef MIO_H
 #define MIO_H
 
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h> // For uint32_t
 
+#include "waker.h"
+
 typedef struct Executor Executor;
 
 /** Represents the MIO event loop instance. */
 typedef struct Mio Mio;
 
-/** Represents a mechanism to wake up a task when an event occurs. */
-typedef struct Waker Waker;
+/** The kernel interface a Mio instance is built on. */
+typedef enum MioBackend {
+    MIO_BACKEND_EPOLL, // Readiness-based: epoll. The default.
+    MIO_BACKEND_IO_URING, // io_uring: readiness polls plus completion-based reads and writes.
+    MIO_BACKEND_IO_URING_SQPOLL, // Same, with a kernel thread consuming submissions (no syscall).
+} MioBackend;
+
+/** Options for `mio_create_with_config`. */
+typedef struct MioConfig {
+    /** Requested backend. io_uring ones fall back to epoll if the kernel lacks io_uring. */
+    MioBackend backend;
+    /**
+     * Initial number of events one epoll_wait() can return (0 for the default, 64).
+     *
+     * The buffer grows (doubling) whenever a poll fills it, up to `max_event_batch`, and shrinks
+     * back towards this size once polls keep returning few events. io_uring backends drain the
+     * whole completion queue on each poll and ignore both.
+     */
+    size_t event_batch;
+    /** Upper bound of the event buffer (0 for the default, 4096; at most `event_batch` disables
+     *  the growth). */
+    size_t max_event_batch;
+} MioConfig;
 
-/** Creates a new MIO event loop instance (NULL on failure). */
+/** Creates a new MIO event loop instance using epoll (NULL on failure). */
 Mio* mio_create(Executor* executor);
 
+/** Creates a new MIO event loop instance with the given options (NULL on failure). */
+Mio* mio_create_with_config(Executor* executor, MioConfig const* config);
+
+/** Returns the backend actually in use (after a possible fallback to epoll). */
+MioBackend mio_backend(Mio* mio);
+
 /** Destroys a MIO instance and releases its resources. */
 void mio_destroy(Mio* mio);
 
@@ -21,19 +53,230 @@ void mio_destroy(Mio* mio);
  * Registers a file descriptor with MIO to monitor specific events.
  *
  * When the specified events occur on the file descriptor, the associated Waker is invoked.
+ * The registration persists until `mio_unregister` (or until the fd is closed), so calling this
+ * again for an fd that is already registered is cheap: it only updates the kernel's interest list
+ * if `events` or the waker changed, and does nothing otherwise.
+ *
+ * By default registrations are level-triggered: the waker is invoked on every poll while the fd
+ * stays ready. Two opt-in modes are supported through flags added to `events`:
+ * - EPOLLET (edge-triggered): the waker is invoked only when the fd becomes ready again, so the
+ *   future must keep doing I/O until it gets EAGAIN before relying on the next wake;
+ * - EPOLLONESHOT: the waker is invoked at most once; calling `mio_register` again re-arms it.
+ * With the io_uring backends every registration behaves like EPOLLONESHOT.
+ *
+ * Reading (EPOLLIN, EPOLLPRI, EPOLLRDHUP) and writing (EPOLLOUT) are separate interests, each with
+ * its own waker: a reader and a writer may wait on the same fd (e.g., a socket) at once, and each
+ * is woken only by the readiness of its direction (or by EPOLLERR/EPOLLHUP, which concern both).
+ * Registering one direction replaces only that direction's waker; both directions share a single
+ * kernel registration, updated in place. The modes of the two directions should match: EPOLLET of
+ * either applies to the whole fd.
  *
  * @param mio Pointer to the Mio instance.
  * @param fd File descriptor to register.
- * @param events Events to monitor (EPOLLIN or EPOLLOUT for read or write availability).
+ * @param events Events to monitor (EPOLLIN or EPOLLOUT for read or write availability, or both
+ *               to wake the same waker for either), optionally with EPOLLET or EPOLLONESHOT.
  * @param waker Waker that will be notified on events.
  * @return 0 on success, -1 on failure.
  */
 int mio_register(Mio* mio, int fd, uint32_t events, Waker waker);
 
-/** Unregisters a file descriptor from MIO. Returns 0 on success, -1 on failure. */
+/**
+ * Unregisters a file descriptor from MIO (both directions). Returns 0 on success, -1 on failure
+ * (including, with errno ENOENT, when the fd was not registered).
+ *
+ * Once it returns, the wakers it dropped are not woken anymore: if another thread was about to
+ * wake them for an event of fd, it waits until that is done. So a future may unregister its fd
+ * and complete (and be freed) right away.
+ */
 int mio_unregister(Mio* mio, int fd);
 
-/** Waits for any ready event and invokes their Wakers. */
-void mio_poll(Mio* mio);
+/**
+ * Unregisters only the directions of `events` (EPOLLIN for reading, EPOLLOUT for writing) of a
+ * file descriptor, leaving the other one's waker registered: what a future sharing its fd with
+ * another one waiting in the other direction calls once done. The fd is unregistered altogether
+ * (as with `mio_unregister`) once neither direction is left.
+ * Returns 0 on success, -1 on failure (errno ENOENT if none of these directions was registered).
+ */
+int mio_unregister_events(Mio* mio, int fd, uint32_t events);
+
+/**
+ * Drops the wakers of the directions of `events` of a registered fd, but keeps the registration
+ * itself: the kernel keeps watching the fd and Mio keeps recording its readiness (see
+ * `mio_readiness`), while nobody is woken until the next `mio_register`. What a future keeping its
+ * fd registered for the next one (e.g., a socket future) calls once done, instead of
+ * `mio_unregister_events`: it costs no syscall. As with `mio_unregister`, wakes in progress are
+ * waited for, so the future may then complete and be freed.
+ * Returns 0 on success, -1 on failure (errno ENOENT if none of these directions was registered).
+ */
+int mio_detach_waker(Mio* mio, int fd, uint32_t events);
+
+/** Readiness of an fd, as returned by `mio_readiness`. */
+typedef struct MioReadiness {
+    uint32_t events; // EPOLLIN, EPOLLOUT, EPOLLHUP, EPOLLERR, EPOLLRDHUP, EPOLLPRI bits.
+    uint32_t tick; // Identifies the last report merged in (for `mio_clear_readiness`).
+} MioReadiness;
+
+/**
+ * Returns what the kernel reported about a registered fd since the bits were last cleared, so
+ * that a progressed future can skip I/O bound to fail: without EPOLLIN (or EPOLLHUP), a read
+ * would only get EAGAIN (the future was progressed for another reason); EPOLLHUP without EPOLLIN
+ * means end of file; EPOLLERR means the I/O would fail (e.g., a pipe's reader is gone).
+ *
+ * Reported bits accumulate (with any backend, including one-shot registrations) until cleared
+ * with `mio_clear_readiness`, which futures do when their I/O gets EAGAIN. A direction starts out
+ * not ready when registered. Nothing is known about a direction that is not registered, nor about
+ * an fd that is not: it is reported ready (EPOLLIN or EPOLLOUT), as its I/O has to be tried.
+ */
+MioReadiness mio_readiness(Mio* mio, int fd);
+
+/**
+ * Clears `events` from the readiness of fd, unless the kernel reported anything new since `seen`
+ * was returned by `mio_readiness` (so that a report arriving while the caller's I/O ran into
+ * EAGAIN is not lost). Does nothing for an fd that is not registered.
+ */
+void mio_clear_readiness(Mio* mio, int fd, MioReadiness seen, uint32_t events);
+
+/**
+ * A read or write handed to the kernel as a whole (completion-based I/O, io_uring backends only).
+ *
+ * Embed it in the future doing the I/O; it (and the buffer) must stay in place while `in_flight`.
+ */
+typedef struct MioOp {
+    Waker waker; // Woken once the operation completed.
+    int result; // What read()/write() would return, or -errno on failure. Valid once `done`.
+    bool in_flight; // Submitted and not yet consumed with `mio_op_consume`.
+    atomic_bool done; // Set by mio_poll() once the completion's wake was delivered.
+    atomic_bool completed; // Private to Mio: `result` is set, the wake is under way.
+} MioOp;
+
+static inline MioOp mio_op_create(void)
+{
+    return (MioOp) { .in_flight = false, .done = false, .completed = false };
+}
+
+/** Whether `mio_submit_read`/`mio_submit_write` are available (io_uring backends). */
+bool mio_supports_submission(Mio* mio);
+
+/**
+ * Submits a read of up to `len` bytes from `fd` into `buf`; `waker` is invoked on completion.
+ *
+ * The submission is batched: it reaches the kernel in the same syscall as the next `mio_poll`
+ * (or without any syscall with MIO_BACKEND_IO_URING_SQPOLL).
+ * @return 0 on success, -1 on failure (errno ENOTSUP with the epoll backend).
+ */
+int mio_submit_read(Mio* mio, MioOp* op, int fd, void* buf, size_t len, Waker waker);
+
+/** Like `mio_submit_read`, for writing `len` bytes from `buf` to `fd`. */
+int mio_submit_write(Mio* mio, MioOp* op, int fd, const void* buf, size_t len, Waker waker);
+
+/**
+ * Whether a submitted operation has completed (its result can be consumed).
+ *
+ * Mio wakes the op's waker before setting `done`, so that the future may complete (and be freed)
+ * as soon as this returns true. In between, the wake may be what this progress call comes from,
+ * so it must not be lost: this then waits (yielding the CPU) until it was delivered.
+ */
+bool mio_op_done(MioOp* op);
+
+/** Returns the result of a completed operation and marks the op as free for another one. */
+int mio_op_consume(MioOp* op);
+
+/**
+ * A timer, owned by the caller (typically embedded in a future) and linked into Mio's timer wheel
+ * while pending, so registering and cancelling it allocates nothing and takes constant time.
+ *
+ * It must stay in place while `pending` and while its wake is under way: check it with
+ * `mio_timer_pending`, and use `mio_cancel_timer` before dropping a timer that may be pending.
+ */
+typedef struct MioTimer {
+    uint64_t deadline; // In milliseconds of CLOCK_MONOTONIC, see `mio_now_ms`.
+    Waker waker; // Woken once the deadline has passed.
+    atomic_bool pending; // Registered, and neither fired nor cancelled yet.
+    atomic_uint waking; // Private to Mio: fired, and the wake not delivered yet.
+
+    // Private to Mio.
+    struct MioTimer* next;
+    struct MioTimer** prev_next;
+    uint16_t slot;
+} MioTimer;
+
+static inline MioTimer mio_timer_create(void)
+{
+    return (MioTimer) { .pending = false, .waking = 0 };
+}
+
+/** Current time in milliseconds of CLOCK_MONOTONIC, the clock of timer deadlines. */
+uint64_t mio_now_ms(void);
+
+/**
+ * Arms `timer` so that `waker` is invoked (by `mio_poll`) once `deadline_ms` has passed.
+ *
+ * A deadline in the past wakes right away. Registering a timer that is still pending moves it
+ * to the new deadline (or, for the same deadline, only replaces the waker).
+ * Deadlines have a resolution of one millisecond and are never reported early.
+ * @return 0 on success, -1 on failure.
+ */
+int mio_register_timer(Mio* mio, MioTimer* timer, uint64_t deadline_ms, Waker waker);
+
+/**
+ * Disarms a pending timer. Returns 0 on success, -1 (errno ENOENT) if it was not pending.
+ * Either way, it returns only once no wake of the timer is under way: the timer may then be dropped.
+ */
+int mio_cancel_timer(Mio* mio, MioTimer* timer);
+
+/**
+ * Whether a registered timer is still pending.
+ *
+ * Mio clears `pending` before waking the timer's waker. Once this returns false, the wake was
+ * delivered and Mio no longer touches the timer, so the future may complete (and be freed). In
+ * between, this waits (yielding the CPU) for the wake, which this progress call may come from.
+ */
+bool mio_timer_pending(MioTimer* timer);
+
+/**
+ * Waits for any ready event or expired timer and invokes their Wakers.
+ *
+ * The wait lasts at most until the earliest pending timer deadline.
+ * Returns immediately (with false) if no file descriptor is registered, no operation is submitted
+ * and no timer is pending; otherwise returns true.
+ */
+bool mio_poll(Mio* mio);
+
+/**
+ * Like `mio_poll`, but never waits: handles the events and expired timers that are ready now.
+ *
+ * Returns how many there were (possibly 0), or -1 if nothing is registered and no timer is
+ * pending (when `mio_poll` would return false). Like `mio_poll`, it must not run concurrently
+ * with another poll of the same Mio.
+ */
+int mio_poll_nonblocking(Mio* mio);
+
+/**
+ * Makes a concurrent (or the next) `mio_poll` return early, without waking any future.
+ *
+ * Unlike the other functions, this one may be called from any thread.
+ */
+void mio_interrupt(Mio* mio);
+
+/** Counters describing the work done by a Mio instance so far (see `mio_stats`). */
+typedef struct MioStats {
+    uint64_t registers; // Calls to mio_register().
+    uint64_t unregisters; // Calls to mio_unregister().
+    uint64_t ctl_syscalls; // epoll_ctl() calls those resulted in (epoll backend).
+    uint64_t submissions; // Submission queue entries used (io_uring backends).
+    uint64_t polls; // epoll_wait() or waiting io_uring_enter() calls.
+    uint64_t nonblocking_polls; // Calls to mio_poll_nonblocking() that checked for events.
+    uint64_t events; // Events or completions returned by them (so events / polls per syscall).
+    uint64_t max_events_per_poll; // Most events or completions returned by one of them.
+    uint64_t full_polls; // epoll_wait() calls that filled the event buffer.
+    uint64_t event_batch; // Current size of the event buffer (epoll backend).
+    uint64_t event_batch_grows; // Times the event buffer grew...
+    uint64_t event_batch_shrinks; // ... and shrank.
+    uint64_t timers; // Calls to mio_register_timer().
+    uint64_t timers_fired; // Timers whose waker was invoked on expiry.
+} MioStats;
+
+/** Fills `stats` with the counters of the Mio instance. */
+void mio_stats(Mio* mio, MioStats* stats);
 
 #endif // MIO_H
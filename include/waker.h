@@ -1,11 +1,29 @@
 #ifndef WAKER_H
 #define WAKER_H
 
+#include <stdatomic.h>
+#include <stdbool.h>
+
 #include "debug.h"
 
 typedef struct Executor Executor;
 typedef struct Future Future;
 
+/**
+ * Readiness tracking for one child of a combinator (see `future_join_all`).
+ *
+ * A combinator hands each child a Waker pointing to the child's slot. Waking it pushes the slot
+ * onto the combinator's ready list, and the combinator's own slot onto its parent's list, and so
+ * on up to the future the executor knows about. When progressed, a combinator then only
+ * progresses the children found on its ready list.
+ */
+typedef struct WakerSlot {
+    _Atomic(struct WakerSlot*) parent; // Slot of the combinator itself (NULL at the top).
+    _Atomic(struct WakerSlot*)* ready_list; // Head of the combinator's list of woken slots.
+    struct WakerSlot* next_ready; // Next slot in that list.
+    atomic_bool queued; // Whether the slot is on the ready list.
+} WakerSlot;
+
 /**
  * A Waker is used to notify the executor that a future is ready to make progress.
  *
@@ -15,6 +33,7 @@ typedef struct Future Future;
 typedef struct Waker {
     void* executor; // Executor to be notified about the future.
     Future* future; // Future to be requeued up by executor.
+    WakerSlot* slot; // Set by combinators: which of their children the wake is for (or NULL).
 } Waker;
 
 /** Invoked when the associated future becomes ready. */
@@ -0,0 +1,107 @@
+#include "blocking_pool.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+
+#include "debug.h"
+
+int blocking_pool_init(BlockingPool* pool, size_t max_threads)
+{
+    pool->threads = malloc(max_threads * sizeof(pthread_t));
+    if (!pool->threads)
+        return -1;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+    pool->head = pool->tail = NULL;
+    pool->n_threads = 0;
+    pool->max_threads = max_threads;
+    pool->n_idle = 0;
+    pool->shutting_down = false;
+    return 0;
+}
+
+static void* blocking_thread_main(void* arg)
+{
+    BlockingPool* pool = arg;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->head && !pool->shutting_down) {
+            pool->n_idle++;
+            pthread_cond_wait(&pool->cond, &pool->lock);
+            pool->n_idle--;
+        }
+        BlockingTask* task = pool->head;
+        if (!task)
+            break; // Shutting down, and nothing left to run.
+        pool->head = task->next;
+        if (!pool->head)
+            pool->tail = NULL;
+        pthread_mutex_unlock(&pool->lock);
+
+        debug("Blocking task %p running\n", task);
+        task->result = task->func(task->arg);
+        // Wake the future before setting `done`: once it sees `done`, it may complete and be
+        // freed (with the task). Until then, blocking_task_done() waits for the wake.
+        atomic_store_explicit(&task->returned, true, memory_order_release);
+        waker_wake(&task->waker);
+        atomic_store_explicit(&task->done, true, memory_order_release);
+
+        pthread_mutex_lock(&pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+int blocking_pool_submit(BlockingPool* pool, BlockingTask* task)
+{
+    atomic_store_explicit(&task->done, false, memory_order_relaxed);
+    atomic_store_explicit(&task->returned, false, memory_order_relaxed);
+    task->next = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->n_idle == 0 && pool->n_threads < pool->max_threads) {
+        int err = pthread_create(&pool->threads[pool->n_threads], NULL, blocking_thread_main, pool);
+        if (err == 0) {
+            pool->n_threads++;
+        } else if (pool->n_threads == 0) {
+            pthread_mutex_unlock(&pool->lock);
+            errno = err;
+            return -1; // Nobody would ever run the task.
+        }
+    }
+    if (pool->tail)
+        pool->tail->next = task;
+    else
+        pool->head = task;
+    pool->tail = task;
+    pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+bool blocking_task_done(BlockingTask* task)
+{
+    if (atomic_load_explicit(&task->done, memory_order_acquire))
+        return true;
+    if (!atomic_load_explicit(&task->returned, memory_order_acquire))
+        return false;
+    // Only as long as waker_wake() takes on the pool thread.
+    while (!atomic_load_explicit(&task->done, memory_order_acquire))
+        sched_yield();
+    return true;
+}
+
+void blocking_pool_destroy(BlockingPool* pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->shutting_down = true;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t i = 0; i < pool->n_threads; i++)
+        pthread_join(pool->threads[i], NULL);
+
+    free(pool->threads);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->cond);
+}
@@ -0,0 +1,40 @@
+#ifndef BLOCKING_POOL_H
+#define BLOCKING_POOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "executor.h"
+
+/**
+ * The threads of an executor that run blocking function calls (see `executor_run_blocking`),
+ * used internally by the executor.
+ *
+ * Threads are started on demand, when a task is submitted and no thread is idle, up to
+ * `max_threads`; beyond that, tasks wait in a FIFO queue. They are stopped by
+ * `blocking_pool_destroy`, after finishing the queued tasks.
+ */
+typedef struct BlockingPool {
+    pthread_mutex_t lock;
+    pthread_cond_t cond; // Signalled when tasks are queued, or on shutdown.
+    BlockingTask* head; // Queued tasks, oldest first.
+    BlockingTask* tail;
+    pthread_t* threads;
+    size_t n_threads;
+    size_t max_threads;
+    size_t n_idle; // Threads waiting for a task.
+    bool shutting_down;
+} BlockingPool;
+
+/** Initializes a pool with no thread yet. Returns 0 on success, -1 if out of memory. */
+int blocking_pool_init(BlockingPool* pool, size_t max_threads);
+
+/** Queues a task, starting a thread if none is idle. Returns 0, or -1 (see
+ *  `executor_run_blocking`). */
+int blocking_pool_submit(BlockingPool* pool, BlockingTask* task);
+
+/** Runs the queued tasks to completion, then stops and joins the threads. */
+void blocking_pool_destroy(BlockingPool* pool);
+
+#endif // BLOCKING_POOL_H
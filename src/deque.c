@@ -0,0 +1,123 @@
+#include "deque.h"
+
+#include <stdlib.h>
+
+struct DequeArray {
+    size_t mask; // capacity - 1, capacity being a power of two.
+    DequeArray* next_retired;
+    _Atomic(Future*) buf[];
+};
+
+static DequeArray* deque_array_create(size_t capacity)
+{
+    DequeArray* array = malloc(sizeof(DequeArray) + capacity * sizeof(_Atomic(Future*)));
+    if (!array)
+        return NULL;
+    array->mask = capacity - 1;
+    array->next_retired = NULL;
+    return array;
+}
+
+int deque_init(Deque* deque, size_t capacity)
+{
+    size_t cap = 1;
+    while (cap < capacity)
+        cap <<= 1;
+
+    DequeArray* array = deque_array_create(cap);
+    if (!array)
+        return -1;
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    atomic_init(&deque->array, array);
+    deque->retired = NULL;
+    return 0;
+}
+
+void deque_destroy(Deque* deque)
+{
+    free(atomic_load_explicit(&deque->array, memory_order_relaxed));
+    while (deque->retired) {
+        DequeArray* next = deque->retired->next_retired;
+        free(deque->retired);
+        deque->retired = next;
+    }
+}
+
+/* Replaces the buffer with one twice as big, holding the same elements at the same positions. */
+static DequeArray* deque_grow(Deque* deque, DequeArray* old, size_t top, size_t bottom)
+{
+    DequeArray* array = deque_array_create((old->mask + 1) << 1);
+    if (!array)
+        return NULL;
+    for (size_t i = top; i != bottom; i++) {
+        Future* fut = atomic_load_explicit(&old->buf[i & old->mask], memory_order_relaxed);
+        atomic_store_explicit(&array->buf[i & array->mask], fut, memory_order_relaxed);
+    }
+    atomic_store_explicit(&deque->array, array, memory_order_release);
+    old->next_retired = deque->retired;
+    deque->retired = old;
+    return array;
+}
+
+int deque_push(Deque* deque, Future* fut)
+{
+    size_t const b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    size_t const t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    DequeArray* array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+
+    if (b - t > array->mask) {
+        array = deque_grow(deque, array, t, b);
+        if (!array)
+            return -1;
+    }
+    atomic_store_explicit(&array->buf[b & array->mask], fut, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    return 0;
+}
+
+Future* deque_pop(Deque* deque)
+{
+    size_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    if (atomic_load_explicit(&deque->top, memory_order_relaxed) >= b)
+        return NULL; // Empty: top only grows, so a stale value cannot hide a future.
+
+    b--;
+    DequeArray* array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    size_t t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    Future* fut = NULL;
+    if (t <= b) {
+        fut = atomic_load_explicit(&array->buf[b & array->mask], memory_order_relaxed);
+        if (t == b) {
+            // The last one: race the thieves for it.
+            if (!atomic_compare_exchange_strong_explicit(
+                    &deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+                fut = NULL;
+            atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        }
+    } else {
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed); // A thief was faster.
+    }
+    return fut;
+}
+
+Future* deque_steal(Deque* deque)
+{
+    size_t t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    size_t const b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+    if (t >= b)
+        return NULL;
+
+    DequeArray* array = atomic_load_explicit(&deque->array, memory_order_acquire);
+    Future* fut = atomic_load_explicit(&array->buf[t & array->mask], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(
+            &deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+        return DEQUE_ABORT;
+    return fut;
+}
@@ -0,0 +1,55 @@
+#ifndef DEQUE_H
+#define DEQUE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+typedef struct Future Future;
+
+typedef struct DequeArray DequeArray;
+
+/**
+ * A Chase-Lev work-stealing deque of futures, used internally by the multi-threaded executor.
+ *
+ * Only the owning worker may push and pop at the bottom (LIFO: the newest future first); any
+ * thread, including the owner, may steal futures from the top (FIFO: the oldest first). The
+ * buffer grows when full; replaced buffers are kept until the deque is destroyed, as concurrent
+ * thieves may still be reading them.
+ *
+ * See: N. M. Lê et al., "Correct and Efficient Work-Stealing for Weak Memory Models", PPoPP 2013.
+ */
+typedef struct Deque {
+    atomic_size_t top;
+    atomic_size_t bottom;
+    _Atomic(DequeArray*) array;
+    DequeArray* retired; // Buffers replaced by a bigger one, freed in deque_destroy().
+} Deque;
+
+/** Result of `deque_steal` when it lost a race with another thief (the caller may retry). */
+#define DEQUE_ABORT ((Future*)-1)
+
+/** Initializes an empty deque. Returns 0 on success, -1 if out of memory. */
+int deque_init(Deque* deque, size_t capacity);
+
+/** Frees the deque buffers (queued futures are not touched). */
+void deque_destroy(Deque* deque);
+
+/** Pushes a future at the bottom. Owner only. Returns 0 on success, -1 if out of memory. */
+int deque_push(Deque* deque, Future* fut);
+
+/** Takes the newest future from the bottom: NULL if empty (or a thief took the last one). Owner
+ *  only. */
+Future* deque_pop(Deque* deque);
+
+/** Takes the oldest future from the top: NULL if empty, DEQUE_ABORT on a lost race. */
+Future* deque_steal(Deque* deque);
+
+/** Approximate number of queued futures. */
+static inline size_t deque_size(Deque* deque)
+{
+    size_t const b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    size_t const t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+    return b > t ? b - t : 0;
+}
+
+#endif // DEQUE_H
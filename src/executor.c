@@ -1,100 +1,694 @@
 #include "executor.h"
 
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
+#include "blocking_pool.h"
 #include "debug.h"
+#include "deque.h"
+#include "err.h"
 #include "future.h"
+#include "future_arena.h"
+#include "futque.h"
+#include "injectq.h"
 #include "mio.h"
 #include "waker.h"
 
-/**
- * @brief Structure to represent the current-thread executor.
+/* Bits of Future.sched_state.
+ * A future is in at most one run queue at a time: SCHEDULED and RUNNING are mutually exclusive,
+ * and NOTIFIED is only set together with RUNNING. Wakes that find the future already SCHEDULED
+ * (or RUNNING and NOTIFIED) are coalesced into the pending queue entry.
  */
+#define SCHED_ACTIVE 0x1 // Mirrors Future.is_active, for wakes coming from other threads.
+#define SCHED_SCHEDULED 0x2 // Sitting in a run queue.
+#define SCHED_RUNNING 0x4 // Some thread is inside fut->progress().
+#define SCHED_NOTIFIED 0x8 // Woken while running: requeue once progress() returns.
+
+/* Counters: per worker (or per executor for the current-thread one), summed by executor_stats. */
+typedef struct Counters {
+    atomic_size_t spawned;
+    atomic_size_t wakes;
+    atomic_size_t wakes_coalesced;
+    atomic_size_t wakes_stale;
+    atomic_size_t progressed;
+    atomic_size_t injected;
+    atomic_size_t budget_exhausted;
+} Counters;
+
+// Default ExecutorConfig.poll_interval (as in Tokio: a prime, so as not to resonate with the
+// patterns of the futures).
+#define DEFAULT_POLL_INTERVAL 61
+
+// A worker looks at the injection queue before its own deque every this many futures taken.
+#define INJECT_CHECK_INTERVAL 61
+
+// Most futures a worker takes from the bottom of its deque (the newest) in a row.
+#define MAX_LIFO_TAKES 3
+
+#define DEFAULT_MAX_BLOCKING_THREADS 8
+
+// Default ExecutorConfig.task_budget (as in Tokio).
+#define DEFAULT_TASK_BUDGET 128
+
+#define DEFAULT_FUTURE_ARENA_SIZE ((size_t)64 << 20)
+
+/* DetachedTask: The callbacks of a future spawned with executor_spawn_detached(), allocated from
+ * the arena along with the spawn and released on completion. */
+struct DetachedTask {
+    CompletionFn on_complete;
+    DestroyFn destroy;
+    void* ctx;
+};
 
-/* FutQue: A queue to store futures 
- * A full implementation would include functions to push and pop futures.
+#define COUNT(counters, field) atomic_fetch_add_explicit(&(counters)->field, 1, memory_order_relaxed)
+
+/* Worker: one thread of a multi-threaded executor, with its own work-stealing deque. */
+typedef struct Worker {
+    Executor* executor;
+    size_t index;
+    Deque deque;
+    pthread_t thread;
+    unsigned rng; // Seed for picking steal victims.
+    size_t since_poll; // Futures progressed since the last check of Mio.
+    size_t taken; // Futures taken from any queue (for INJECT_CHECK_INTERVAL).
+    unsigned lifo_streak; // Futures taken from the bottom of the deque in a row.
+    FutureArenaCache arena_cache;
+    Counters counters;
+} Worker;
+
+/**
+ * @brief Structure to represent the executor.
+ *
+ * With `n_workers == 0` this is the current-thread executor: everything runs in the thread that
+ * calls executor_run() (the `owner`), using the plain `que`. Otherwise futures run on the workers'
+ * deques.
+ * Futures spawned or woken from any other thread go to the lock-free `inject` queue, and the
+ * executor is notified: parked threads through `park_cond`, a thread blocked in mio_poll() through
+ * mio_interrupt(). Its consumers take turns with `inject_lock` (there is only one in
+ * current-thread mode).
  */
-typedef struct FutQue FutQue;
-
-struct FutQue {
-    Future** futs;
-    size_t size;
-    size_t max_size;
-    int front;
-    int back;
+struct Executor {
+    Mio* mio;
+    FutQue que;
+    size_t max_active; // Hard cap on spawned but unfinished futures (0 = unbounded).
+    size_t poll_interval; // See ExecutorConfig.
+    size_t task_budget;
+    unsigned poll_spin_us;
+    size_t since_poll; // Current-thread executor: futures progressed since the last check of Mio.
+    atomic_size_t active; // Number of spawned but unfinished futures.
+
+    size_t n_workers;
+    Worker* workers;
+    pthread_t owner; // Current-thread executor: the thread that runs it.
+    pthread_mutex_t inject_lock;
+    InjectQueue inject;
+    atomic_size_t inject_len; // Pushed to `inject` and not popped yet.
+    pthread_mutex_t poll_lock; // Held by the (single) worker blocked in mio_poll().
+    atomic_bool polling; // A thread is in mio_poll() (or about to be).
+    pthread_mutex_t park_lock;
+    pthread_cond_t park_cond;
+    atomic_size_t n_parked;
+    atomic_uint epoch; // Bumped whenever work is added, so idle workers don't miss it.
+    atomic_bool done;
+
+    BlockingPool blocking; // Threads for executor_run_blocking().
+    FutureArena arena; // For executor_alloc_future().
+    FutureArenaCache arena_cache; // Current-thread executor: the owner's.
+    Counters counters; // For the current-thread executor and for calls from outside the workers.
 };
 
-FutQue* futque_create(size_t max_size) {
-    FutQue* que = (FutQue*)malloc(sizeof(FutQue));
-    que->futs = (Future**)malloc(max_size * sizeof(Future*));
-    que->size = 0;
-    que->max_size = max_size;
-    que->front = 0;
-    que->back = -1;
-    return que;
-}
+/* The worker running on the current thread, if any. */
+static _Thread_local Worker* current_worker = NULL;
+
+/* The executor progressing a future on the current thread, if it has a task budget, and what is
+ * left of that budget. */
+static _Thread_local Executor* budget_executor = NULL;
+static _Thread_local size_t budget_left;
 
-bool isEmpty(FutQue* que) {
-    return que->size == 0;
+ExecutorConfig executor_config_default(void) {
+    return (ExecutorConfig) {
+        .max_queue_size = 0,
+        .n_threads = 0,
+        .mio = { .backend = MIO_BACKEND_EPOLL },
+        .poll_interval = DEFAULT_POLL_INTERVAL,
+        .poll_spin_us = 0,
+        .max_blocking_threads = DEFAULT_MAX_BLOCKING_THREADS,
+        .future_arena_size = DEFAULT_FUTURE_ARENA_SIZE,
+        .task_budget = DEFAULT_TASK_BUDGET,
+    };
 }
 
-void push(FutQue* que, Future* fut) {
-    if (que->size == que->max_size) {
-        return;
+Executor* executor_create_with_config(ExecutorConfig const* config) {
+    debug("Creating Executor with %zu threads\n", config->n_threads);
+
+    Executor* executor = (Executor*)malloc(sizeof(Executor));
+    if (!executor)
+        exit(1);
+    // Start small, the queue grows on demand up to the number of active futures.
+    size_t initial = config->max_queue_size;
+    if (initial == 0 || initial > FUTQUE_DEFAULT_CAPACITY)
+        initial = FUTQUE_DEFAULT_CAPACITY;
+    if (futque_init(&executor->que, initial) != 0)
+        exit(1);
+    executor->max_active = config->max_queue_size;
+    executor->poll_interval = config->poll_interval;
+    executor->task_budget = config->task_budget;
+    executor->poll_spin_us = config->poll_spin_us;
+    executor->since_poll = 0;
+    atomic_init(&executor->active, 0);
+    executor->n_workers = config->n_threads;
+    executor->workers = NULL;
+    executor->counters = (Counters) { 0 };
+    executor->mio = mio_create_with_config(executor, &config->mio);
+    size_t max_blocking = config->max_blocking_threads;
+    if (max_blocking == 0)
+        max_blocking = DEFAULT_MAX_BLOCKING_THREADS;
+    if (blocking_pool_init(&executor->blocking, max_blocking) != 0)
+        exit(1);
+    size_t arena_size = config->future_arena_size;
+    if (arena_size == 0)
+        arena_size = DEFAULT_FUTURE_ARENA_SIZE;
+    if (future_arena_init(&executor->arena, arena_size) != 0)
+        exit(1);
+    executor->arena_cache = (FutureArenaCache) { 0 };
+    executor->owner = pthread_self();
+    pthread_mutex_init(&executor->inject_lock, NULL);
+    injectq_init(&executor->inject);
+    atomic_init(&executor->inject_len, 0);
+    pthread_mutex_init(&executor->poll_lock, NULL);
+    atomic_init(&executor->polling, false);
+    pthread_mutex_init(&executor->park_lock, NULL);
+    pthread_cond_init(&executor->park_cond, NULL);
+    atomic_init(&executor->n_parked, 0);
+    atomic_init(&executor->epoch, 0);
+    atomic_init(&executor->done, false);
+    if (config->n_threads == 0)
+        return executor;
+
+    size_t const n_threads = config->n_threads;
+    executor->workers = calloc(n_threads, sizeof(Worker));
+    if (!executor->workers)
+        exit(1);
+    for (size_t i = 0; i < n_threads; i++) {
+        Worker* worker = &executor->workers[i];
+        worker->executor = executor;
+        worker->index = i;
+        worker->rng = (unsigned)i * 2654435761u + 1;
+        worker->arena_cache = (FutureArenaCache) { 0 };
+        worker->counters = (Counters) { 0 };
+        if (deque_init(&worker->deque, FUTQUE_DEFAULT_CAPACITY) != 0)
+            exit(1);
     }
-    que->back = (que->back + 1) % que->max_size;
-    que->futs[que->back] = fut;
-    que->size++;
+    return executor;
 }
 
-Future* pop(FutQue* que) {
-    if (isEmpty(que)) {
-        return NULL;
+Executor* executor_create(size_t max_queue_size) {
+    ExecutorConfig config = executor_config_default();
+    config.max_queue_size = max_queue_size;
+    return executor_create_with_config(&config);
+}
+
+Executor* executor_create_multi(size_t n_threads, size_t max_queue_size) {
+    ExecutorConfig config = executor_config_default();
+    config.max_queue_size = max_queue_size;
+    config.n_threads = n_threads == 0 ? 1 : n_threads;
+    return executor_create_with_config(&config);
+}
+
+/* notify_workers: Tell idle workers (or the idle current-thread executor) that new work is
+ * available. Parked threads are woken through the condition variable. A thread blocked in
+ * mio_poll() is only interrupted when asked to, i.e., when the work was added from outside.
+ */
+static void notify_workers(Executor* executor, bool interrupt_poller) {
+    atomic_fetch_add(&executor->epoch, 1);
+    if (atomic_load(&executor->n_parked) > 0) {
+        pthread_mutex_lock(&executor->park_lock);
+        pthread_cond_signal(&executor->park_cond);
+        pthread_mutex_unlock(&executor->park_lock);
     }
-    Future* fut = que->futs[que->front];
-    que->front = (que->front + 1) % que->max_size;
-    que->size--;
-    return fut;
+    if (interrupt_poller && atomic_load(&executor->polling))
+        mio_interrupt(executor->mio);
 }
 
-void futque_destroy(FutQue* que) {
-    free(que->futs);
-    free(que);
+/* counters_here: The counters to update from the calling thread. */
+static Counters* counters_here(Executor* executor) {
+    Worker* worker = current_worker;
+    if (worker && worker->executor == executor)
+        return &worker->counters;
+    return &executor->counters;
 }
 
-struct Executor {
-    Mio* mio;
-    FutQue* que;
-};
+/* arena_cache_here: The cache of arena blocks of the calling thread, or NULL for threads outside
+ * the executor. */
+static FutureArenaCache* arena_cache_here(Executor* executor) {
+    if (executor->n_workers == 0)
+        return pthread_equal(pthread_self(), executor->owner) ? &executor->arena_cache : NULL;
+    Worker* worker = current_worker;
+    if (worker && worker->executor == executor)
+        return &worker->arena_cache;
+    return NULL;
+}
 
-Executor* executor_create(size_t max_queue_size) {
-    debug("Creating Executor\n");
+/* push_ready: Put a future (already marked SCHEDULED) in a run queue.
+ * That is the local queue when called from the thread running the current-thread executor, the
+ * deque of the current worker when called from a worker, and the injection queue otherwise.
+ */
+static void push_injected(Executor* executor, Future* fut) {
+    COUNT(&executor->counters, injected);
+    atomic_fetch_add(&executor->inject_len, 1);
+    injectq_push(&executor->inject, fut);
+    notify_workers(executor, true);
+}
 
-    Executor* executor = (Executor*)malloc(sizeof(Executor));
-    executor->que = futque_create(max_queue_size);
-    executor->mio = mio_create(executor);
-    return executor;
+static int push_ready(Executor* executor, Future* fut) {
+    if (executor->n_workers == 0) {
+        if (pthread_equal(pthread_self(), executor->owner))
+            return futque_push(&executor->que, fut);
+    } else {
+        Worker* worker = current_worker;
+        if (worker && worker->executor == executor) {
+            if (deque_push(&worker->deque, fut) != 0)
+                return -1;
+            notify_workers(executor, false);
+            return 0;
+        }
+    }
+
+    push_injected(executor, fut);
+    return 0;
+}
+
+/* pop_injected: Take a future from the injection queue, if any. */
+static Future* pop_injected(Executor* executor) {
+    if (atomic_load(&executor->inject_len) == 0)
+        return NULL;
+    pthread_mutex_lock(&executor->inject_lock);
+    Future* fut = injectq_pop(&executor->inject);
+    pthread_mutex_unlock(&executor->inject_lock);
+    // NULL despite inject_len: a push is halfway done. Its notification follows, and its
+    // future will be taken then.
+    if (fut)
+        atomic_fetch_sub(&executor->inject_len, 1);
+    return fut;
+}
+
+/* schedule: Queue an active future, unless a queue entry or a notification is already pending.
+ * If the future is being progressed right now, only mark it as notified: it is requeued once
+ * progress() returns, so that no two threads ever progress it concurrently.
+ */
+static void schedule(Executor* executor, Future* fut) {
+    Counters* counters = counters_here(executor);
+    uint8_t old = atomic_load(&fut->sched_state);
+    uint8_t new;
+    do {
+        if (!(old & SCHED_ACTIVE)) {
+            // Completed already (e.g., woken by a stale Mio registration): progressing it again
+            // would be undefined behaviour.
+            COUNT(counters, wakes_stale);
+            return;
+        }
+        if ((old & SCHED_SCHEDULED) || (old & SCHED_NOTIFIED)) {
+            COUNT(counters, wakes_coalesced);
+            return;
+        }
+        new = old | ((old & SCHED_RUNNING) ? SCHED_NOTIFIED : SCHED_SCHEDULED);
+    } while (!atomic_compare_exchange_weak(&fut->sched_state, &old, new));
+
+    if ((new & SCHED_SCHEDULED) && push_ready(executor, fut) != 0)
+        fatal("Out of memory queueing future %p", fut);
 }
 
 /* waker_wake: Wake up the future
- * This function will wake up the future by spawning it.
+ * This function will wake up the future by queueing it (at most once) in its executor.
  */
 void waker_wake(Waker* waker) {
     debug("Waking up the future\n");
 
-    executor_spawn((Executor*)waker->executor, waker->future);
+    // Mark the woken child of each enclosing combinator, innermost first. A slot that is already
+    // queued was marked along with its ancestors, and will be seen when they are progressed.
+    for (WakerSlot* slot = waker->slot; slot; slot = atomic_load(&slot->parent)) {
+        if (atomic_exchange(&slot->queued, true))
+            break;
+        WakerSlot* head = atomic_load(slot->ready_list);
+        do {
+            slot->next_ready = head;
+        } while (!atomic_compare_exchange_weak(slot->ready_list, &head, slot));
+    }
+
+    Executor* executor = (Executor*)waker->executor;
+    COUNT(counters_here(executor), wakes);
+    schedule(executor, waker->future);
 }
 
 /* executor_spawn: Spawn a future
  * This function will spawn a future by pushing it to the executor's queue.
+ * Only futures that are not active yet count towards the cap: spawning an
+ * already active future is just a wake and never fails for lack of room.
  */
-void executor_spawn(Executor* executor, Future* fut) {
+int executor_spawn(Executor* executor, Future* fut) {
     debug("Spawning a future\n");
 
+    if (fut->is_active) {
+        schedule(executor, fut);
+        return 0;
+    }
+
+    if (executor->max_active != 0
+        && atomic_fetch_add(&executor->active, 1) >= executor->max_active) {
+        atomic_fetch_sub(&executor->active, 1);
+        debug("Executor full, rejecting future %p\n", fut);
+        errno = EAGAIN;
+        return -1;
+    } else if (executor->max_active == 0) {
+        atomic_fetch_add(&executor->active, 1);
+    }
     fut->is_active = true;
-    push(executor->que, fut);
+    atomic_store(&fut->sched_state, SCHED_ACTIVE | SCHED_SCHEDULED);
+    COUNT(counters_here(executor), spawned);
+
+    if (push_ready(executor, fut) != 0) {
+        atomic_store(&fut->sched_state, 0);
+        fut->is_active = false;
+        atomic_fetch_sub(&executor->active, 1);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+int executor_spawn_detached(
+    Executor* executor, Future* fut, CompletionFn on_complete, DestroyFn destroy, void* ctx) {
+    if (fut->is_active) {
+        errno = EINVAL;
+        return -1;
+    }
+    struct DetachedTask* task
+        = future_arena_alloc(&executor->arena, arena_cache_here(executor), sizeof(*task));
+    if (!task)
+        return -1;
+    *task = (struct DetachedTask) { .on_complete = on_complete, .destroy = destroy, .ctx = ctx };
+    fut->detached = task;
+    if (executor_spawn(executor, fut) != 0) {
+        fut->detached = NULL;
+        future_arena_free(&executor->arena, arena_cache_here(executor), task);
+        return -1;
+    }
+    return 0;
+}
+
+/* Bits of JoinHandle.state. LOCKED guards the waker: the awaiter holds it while storing the
+ * waker, the task while setting DONE and taking a copy of the waker (the handle may be freed as
+ * soon as the awaiter sees DONE). Both sides hold it for a few stores, so it is a spinlock.
+ */
+#define JOIN_LOCKED 0x1
+#define JOIN_WAKER_SET 0x2
+#define JOIN_DONE 0x4
+
+/* join_lock: Take JOIN_LOCKED, returning the other bits as they were. */
+static unsigned join_lock(JoinHandle* handle) {
+    unsigned old;
+    while ((old = atomic_fetch_or(&handle->state, JOIN_LOCKED)) & JOIN_LOCKED) { }
+    return old;
+}
+
+/* join_handle_complete: The on_complete callback of a task spawned with a handle. */
+static void join_handle_complete(Future* task, FutureState state, void* ctx) {
+    JoinHandle* handle = ctx;
+    handle->base.ok = task->ok;
+    handle->base.errcode = task->errcode;
+    handle->outcome = state;
+    unsigned const old = join_lock(handle);
+    Waker waker = handle->waker;
+    atomic_store(&handle->state, (old | JOIN_DONE) & ~JOIN_LOCKED);
+    if (old & JOIN_WAKER_SET)
+        waker_wake(&waker);
+}
+
+/* join_handle_progress: Pending until the task is done, then its outcome. */
+static FutureState join_handle_progress(Future* base, Mio* mio, Waker waker) {
+    JoinHandle* handle = (JoinHandle*)base;
+    if (atomic_load(&handle->state) & JOIN_DONE)
+        return handle->outcome;
+    unsigned const old = join_lock(handle);
+    if (old & JOIN_DONE) {
+        atomic_store(&handle->state, old);
+        return handle->outcome;
+    }
+    handle->waker = waker;
+    atomic_store(&handle->state, old | JOIN_WAKER_SET);
+    return FUTURE_PENDING;
+}
+
+int executor_spawn_handle(Executor* executor, Future* task, JoinHandle* handle) {
+    *handle = (JoinHandle) { .base = future_create(join_handle_progress) };
+    atomic_init(&handle->state, 0);
+    return executor_spawn_detached(executor, task, join_handle_complete, NULL, handle);
+}
+
+/* complete_future: Bookkeeping once progress() returned COMPLETED or FAILURE: run the callbacks of
+ * a detached future, and release it if it came from the arena.
+ * All of it happens before `active` drops, as executor_run() may return (and the executor be
+ * destroyed) then; futures spawned by the callbacks keep it running.
+ */
+static void complete_future(Executor* executor, Future* fut, FutureState state) {
+    atomic_store(&fut->sched_state, 0);
+    fut->is_active = false;
+    struct DetachedTask* detached = fut->detached;
+    if (detached) {
+        struct DetachedTask const task = *detached;
+        fut->detached = NULL;
+        future_arena_free(&executor->arena, arena_cache_here(executor), detached);
+        if (task.on_complete)
+            task.on_complete(fut, state, task.ctx);
+        if (task.destroy)
+            task.destroy(fut, task.ctx);
+    }
+    // The block's link overwrites `progress` only: stale wakes still see it inactive.
+    if (future_arena_owns(&executor->arena, fut))
+        future_arena_free(&executor->arena, arena_cache_here(executor), fut);
+    if (atomic_fetch_sub(&executor->active, 1) == 1 && executor->n_workers > 0) {
+        // That was the last one: let every worker return from executor_run().
+        atomic_store(&executor->done, true);
+        pthread_mutex_lock(&executor->park_lock);
+        pthread_cond_broadcast(&executor->park_cond);
+        pthread_mutex_unlock(&executor->park_lock);
+        mio_interrupt(executor->mio);
+    }
+}
+
+/* run_one: Progress a future popped from a run queue. */
+static void run_one(Executor* executor, Future* fut) {
+    // SCHEDULED is set and RUNNING is not: flip both at once.
+    atomic_fetch_xor(&fut->sched_state, SCHED_SCHEDULED | SCHED_RUNNING);
+    COUNT(counters_here(executor), progressed);
+
+    Waker waker = {executor, fut, NULL};
+    budget_executor = executor->task_budget ? executor : NULL;
+    budget_left = executor->task_budget;
+    FutureState state = fut->progress(fut, executor->mio, waker);
+    budget_executor = NULL;
+    if (state == FUTURE_COMPLETED || state == FUTURE_FAILURE) {
+        complete_future(executor, fut, state);
+        return;
+    }
+
+    uint8_t old = atomic_load(&fut->sched_state);
+    uint8_t new;
+    do {
+        new = old & ~(SCHED_RUNNING | SCHED_NOTIFIED);
+        if (old & SCHED_NOTIFIED)
+            new |= SCHED_SCHEDULED;
+    } while (!atomic_compare_exchange_weak(&fut->sched_state, &old, new));
+
+    // Woken while running: the wake did not queue it, so do it now. With workers, not on the own
+    // deque, whose bottom is taken first: it would run again right away, ahead of the futures it
+    // spawned or woke. The injection queue puts it behind them.
+    if (new & SCHED_SCHEDULED) {
+        if (executor->n_workers == 0) {
+            if (push_ready(executor, fut) != 0)
+                fatal("Out of memory requeueing future %p", fut);
+        } else {
+            push_injected(executor, fut);
+        }
+    }
+}
+
+/* now_us: Monotonic time in microseconds. */
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* check_mio: Every poll_interval futures, handle the I/O events that are ready by now.
+ * Only one thread polls Mio at a time: if another one is at it, it will handle them. */
+static void check_mio(Executor* executor, size_t* since_poll) {
+    if (executor->poll_interval == 0 || ++*since_poll < executor->poll_interval)
+        return;
+    *since_poll = 0;
+    if (executor->n_workers == 0) {
+        mio_poll_nonblocking(executor->mio);
+    } else if (pthread_mutex_trylock(&executor->poll_lock) == 0) {
+        mio_poll_nonblocking(executor->mio);
+        pthread_mutex_unlock(&executor->poll_lock);
+    }
+}
+
+/* spin_on_mio: Out of work: check Mio without waiting for up to poll_spin_us, until that or
+ * `has_work` finds something to do. Returns whether it did; false means: block in mio_poll().
+ * On a multi-threaded executor, the caller holds poll_lock. */
+static bool spin_on_mio(Executor* executor, bool (*has_work)(Executor*, unsigned), unsigned arg) {
+    if (executor->poll_spin_us == 0)
+        return false;
+    uint64_t const deadline = now_us() + executor->poll_spin_us;
+    do {
+        int const handled = mio_poll_nonblocking(executor->mio);
+        if (handled != 0)
+            return handled > 0; // -1: nothing to wait for, let mio_poll() say so.
+        if (has_work(executor, arg))
+            return true;
+    } while (now_us() < deadline);
+    return false;
+}
+
+/* work_added: Whether other threads added work since the given epoch. */
+static bool work_added(Executor* executor, unsigned seen_epoch) {
+    return atomic_load(&executor->epoch) != seen_epoch || atomic_load(&executor->done);
+}
+
+/* find_work: Own deque first, then the injection queue, then steal from the other workers.
+ * The own deque is taken newest first (LIFO): a future woken by the one that just ran runs next,
+ * while what they share is still in cache. For fairness, a future that requeues itself never goes
+ * there (see run_one), the oldest one is taken instead after MAX_LIFO_TAKES in a row (two futures
+ * waking each other would hold the bottom), and every INJECT_CHECK_INTERVAL takes the injection
+ * queue comes first, so that yielding futures and remote spawns and wakes cannot starve either.
+ */
+static Future* find_work(Worker* worker) {
+    Executor* executor = worker->executor;
+    Future* fut;
+
+    if (++worker->taken % INJECT_CHECK_INTERVAL == 0 && (fut = pop_injected(executor)))
+        return fut;
+
+    if (worker->lifo_streak < MAX_LIFO_TAKES) {
+        fut = deque_pop(&worker->deque);
+        if (fut) {
+            worker->lifo_streak++;
+            return fut;
+        }
+    } else {
+        worker->lifo_streak = 0;
+        do {
+            fut = deque_steal(&worker->deque);
+        } while (fut == DEQUE_ABORT);
+        if (fut)
+            return fut;
+    }
+
+    fut = pop_injected(executor);
+    if (fut)
+        return fut;
+
+    size_t const n = executor->n_workers;
+    size_t const start = rand_r(&worker->rng) % n;
+    for (size_t i = 0; i < n; i++) {
+        Worker* victim = &executor->workers[(start + i) % n];
+        if (victim == worker)
+            continue;
+        do {
+            fut = deque_steal(&victim->deque);
+        } while (fut == DEQUE_ABORT);
+        if (fut)
+            return fut;
+    }
+    return NULL;
+}
+
+/* park: Sleep until notified of new work (since seen_epoch). */
+static void park(Executor* executor, unsigned seen_epoch) {
+    pthread_mutex_lock(&executor->park_lock);
+    atomic_fetch_add(&executor->n_parked, 1);
+    if (!work_added(executor, seen_epoch))
+        pthread_cond_wait(&executor->park_cond, &executor->park_lock);
+    atomic_fetch_sub(&executor->n_parked, 1);
+    pthread_mutex_unlock(&executor->park_lock);
+}
+
+/* idle: No work found. Become the poller if nobody else is, otherwise sleep until notified. */
+static void idle(Worker* worker, unsigned seen_epoch) {
+    Executor* executor = worker->executor;
+
+    if (pthread_mutex_trylock(&executor->poll_lock) == 0) {
+        atomic_store(&executor->polling, true);
+        bool waited = false;
+        // mio_poll() returns false at once if nothing is registered.
+        if (!work_added(executor, seen_epoch))
+            waited = spin_on_mio(executor, work_added, seen_epoch) || mio_poll(executor->mio);
+        atomic_store(&executor->polling, false);
+        pthread_mutex_unlock(&executor->poll_lock);
+        // Even if the poll woke nobody (e.g., interrupted because another worker armed an earlier
+        // timer), there is still something to wait for: poll again rather than park.
+        if (waited || atomic_load(&executor->epoch) != seen_epoch)
+            return;
+    }
+    park(executor, seen_epoch);
+}
+
+static void* worker_main(void* arg) {
+    Worker* worker = arg;
+    Executor* executor = worker->executor;
+    current_worker = worker;
+
+    while (!atomic_load(&executor->done)) {
+        unsigned seen_epoch = atomic_load(&executor->epoch);
+        Future* fut = find_work(worker);
+        if (fut) {
+            run_one(executor, fut);
+            check_mio(executor, &worker->since_poll);
+        } else
+            idle(worker, seen_epoch);
+    }
+
+    current_worker = NULL;
+    return NULL;
+}
+
+/* executor_run_multi: Run worker 0 on the calling thread and the others on new threads. */
+static void executor_run_multi(Executor* executor) {
+    if (atomic_load(&executor->active) == 0)
+        return;
+    atomic_store(&executor->done, false);
+
+    for (size_t i = 1; i < executor->n_workers; i++) {
+        Worker* worker = &executor->workers[i];
+        if (pthread_create(&worker->thread, NULL, worker_main, worker) != 0)
+            fatal("pthread_create failed");
+    }
+    worker_main(&executor->workers[0]);
+    for (size_t i = 1; i < executor->n_workers; i++)
+        pthread_join(executor->workers[i].thread, NULL);
+}
+
+/* local_work: Whether the current-thread executor has work queued, or was sent some. */
+static bool local_work(Executor* executor, unsigned seen_epoch) {
+    return !futque_is_empty(&executor->que) || work_added(executor, seen_epoch);
+}
+
+/* idle_current_thread: Nothing queued: wait for I/O and timers, or for wakes from other threads
+ * if there is nothing to poll (mio_poll() returns false at once then). */
+static void idle_current_thread(Executor* executor, unsigned seen_epoch) {
+    atomic_store(&executor->polling, true);
+    bool waited = false;
+    if (!work_added(executor, seen_epoch))
+        waited = spin_on_mio(executor, local_work, seen_epoch) || mio_poll(executor->mio);
+    atomic_store(&executor->polling, false);
+    if (!waited)
+        park(executor, seen_epoch);
 }
 
 /* executor_run: Run the executor until all futures are completed
@@ -104,23 +698,92 @@ void executor_spawn(Executor* executor, Future* fut) {
 void executor_run(Executor* executor) {
     debug("Running the executor\n");
 
-    while(!isEmpty(executor->que)){
-        while(!isEmpty(executor->que)) {
-            Future* fut = pop(executor->que);
-            Waker waker = {executor, fut};
-            FutureState state = fut->progress(fut, executor->mio, waker);
-            if (state == FUTURE_COMPLETED || state == FUTURE_FAILURE)
-                fut->is_active = false;
+    if (executor->n_workers > 0) {
+        executor_run_multi(executor);
+        return;
+    }
+
+    // Runs until every spawned future completed: pending ones may still be woken by Mio, or by
+    // other threads (through the injection queue).
+    executor->owner = pthread_self();
+    while (atomic_load(&executor->active) > 0) {
+        unsigned const seen_epoch = atomic_load(&executor->epoch);
+        Future* fut;
+        while ((fut = pop_injected(executor)) != NULL) {
+            if (futque_push(&executor->que, fut) != 0)
+                fatal("Out of memory queueing future %p", fut);
         }
-        // Poll for events
-        mio_poll(executor->mio);
+        fut = futque_pop(&executor->que);
+        if (fut) {
+            run_one(executor, fut);
+            check_mio(executor, &executor->since_poll);
+        } else {
+            idle_current_thread(executor, seen_epoch);
+        }
+    }
+}
+
+int executor_run_blocking(Executor* executor, BlockingTask* task) {
+    return blocking_pool_submit(&executor->blocking, task);
+}
+
+void* executor_alloc_future(Executor* executor, size_t size) {
+    return future_arena_alloc(&executor->arena, arena_cache_here(executor), size);
+}
+
+void executor_free_future(Executor* executor, void* fut) {
+    future_arena_free(&executor->arena, arena_cache_here(executor), fut);
+}
+
+bool executor_budget_spend(Executor* executor, size_t units) {
+    if (budget_executor != executor)
+        return true;
+    if (budget_left == 0) {
+        COUNT(counters_here(executor), budget_exhausted);
+        return false;
     }
+    budget_left = units < budget_left ? budget_left - units : 0;
+    return true;
+}
+
+Mio* executor_mio(Executor* executor) {
+    return executor->mio;
+}
+
+static void add_counters(ExecutorStats* stats, Counters* counters) {
+    stats->spawned += atomic_load_explicit(&counters->spawned, memory_order_relaxed);
+    stats->wakes += atomic_load_explicit(&counters->wakes, memory_order_relaxed);
+    stats->wakes_coalesced += atomic_load_explicit(&counters->wakes_coalesced, memory_order_relaxed);
+    stats->wakes_stale += atomic_load_explicit(&counters->wakes_stale, memory_order_relaxed);
+    stats->progressed += atomic_load_explicit(&counters->progressed, memory_order_relaxed);
+    stats->injected += atomic_load_explicit(&counters->injected, memory_order_relaxed);
+    stats->budget_exhausted
+        += atomic_load_explicit(&counters->budget_exhausted, memory_order_relaxed);
+}
+
+void executor_stats(Executor* executor, ExecutorStats* stats) {
+    *stats = (ExecutorStats) { 0 };
+    add_counters(stats, &executor->counters);
+    for (size_t i = 0; i < executor->n_workers; i++)
+        add_counters(stats, &executor->workers[i].counters);
 }
 
 void executor_destroy(Executor* executor) {
     debug("Destroying Executor\n");
 
+    blocking_pool_destroy(&executor->blocking); // Its threads may still wake futures.
+
     mio_destroy(executor->mio);
-    futque_destroy(executor->que);
+    future_arena_destroy(&executor->arena);
+    futque_destroy(&executor->que);
+    if (executor->workers) {
+        for (size_t i = 0; i < executor->n_workers; i++)
+            deque_destroy(&executor->workers[i].deque);
+        free(executor->workers);
+    }
+    pthread_mutex_destroy(&executor->inject_lock);
+    pthread_mutex_destroy(&executor->poll_lock);
+    pthread_mutex_destroy(&executor->park_lock);
+    pthread_cond_destroy(&executor->park_cond);
     free(executor);
 }
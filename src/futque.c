@@ -0,0 +1,71 @@
+#include "futque.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static size_t round_up_pow2(size_t n)
+{
+    size_t p = 1;
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+int futque_init(FutQue* que, size_t capacity)
+{
+    if (capacity == 0)
+        capacity = FUTQUE_DEFAULT_CAPACITY;
+    capacity = round_up_pow2(capacity);
+
+    que->futs = malloc(capacity * sizeof(Future*));
+    if (!que->futs)
+        return -1;
+    que->mask = capacity - 1;
+    que->head = 0;
+    que->tail = 0;
+    return 0;
+}
+
+void futque_destroy(FutQue* que)
+{
+    free(que->futs);
+    que->futs = NULL;
+}
+
+/* Doubles the capacity, unrolling the ring so that the queued futures start at index 0. */
+static int futque_grow(FutQue* que)
+{
+    size_t const old_cap = que->mask + 1;
+    size_t const new_cap = old_cap << 1;
+    Future** futs = malloc(new_cap * sizeof(Future*));
+    if (!futs)
+        return -1;
+
+    size_t const size = futque_size(que);
+    size_t const first = que->head & que->mask;
+    size_t const first_len = size < old_cap - first ? size : old_cap - first;
+    memcpy(futs, que->futs + first, first_len * sizeof(Future*));
+    memcpy(futs + first_len, que->futs, (size - first_len) * sizeof(Future*));
+
+    free(que->futs);
+    que->futs = futs;
+    que->mask = new_cap - 1;
+    que->head = 0;
+    que->tail = size;
+    return 0;
+}
+
+int futque_push(FutQue* que, Future* fut)
+{
+    if (futque_size(que) == que->mask + 1 && futque_grow(que) != 0)
+        return -1;
+    que->futs[que->tail++ & que->mask] = fut;
+    return 0;
+}
+
+Future* futque_pop(FutQue* que)
+{
+    if (futque_is_empty(que))
+        return NULL;
+    return que->futs[que->head++ & que->mask];
+}
@@ -0,0 +1,42 @@
+#ifndef FUTQUE_H
+#define FUTQUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct Future Future;
+
+/**
+ * A FIFO run queue of futures, used internally by the executor.
+ *
+ * The ring buffer grows on demand (doubling, so the capacity is always a power of two and
+ * indices are reduced with a mask instead of `%`). It never drops futures: `futque_push` only
+ * fails when memory cannot be allocated.
+ */
+typedef struct FutQue {
+    Future** futs;
+    size_t mask; // capacity - 1, capacity being a power of two.
+    size_t head; // Position of the next future to pop (not reduced by mask).
+    size_t tail; // Position one past the last pushed future (not reduced by mask).
+} FutQue;
+
+/** Initial capacity used when none (zero) is requested. */
+#define FUTQUE_DEFAULT_CAPACITY 16
+
+/** Initializes an empty queue able to hold `capacity` futures before growing. 0 on success. */
+int futque_init(FutQue* que, size_t capacity);
+
+/** Releases the buffer of the queue (queued futures are not touched). */
+void futque_destroy(FutQue* que);
+
+/** Appends a future, growing the buffer if needed. Returns 0 on success, -1 if out of memory. */
+int futque_push(FutQue* que, Future* fut);
+
+/** Removes and returns the oldest future, or NULL if the queue is empty. */
+Future* futque_pop(FutQue* que);
+
+static inline size_t futque_size(FutQue const* que) { return que->tail - que->head; }
+
+static inline bool futque_is_empty(FutQue const* que) { return que->head == que->tail; }
+
+#endif // FUTQUE_H
@@ -0,0 +1,136 @@
+#include "future_arena.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#include "debug.h"
+
+#define SLAB_SIZE (64 * 1024)
+#define CACHE_MAX 128 // Free blocks of a class kept by a thread; beyond, half go back.
+#define REFILL_BATCH 32 // Blocks of a class taken at once into an empty thread cache.
+
+int future_arena_init(FutureArena* arena, size_t size)
+{
+    size = (size + SLAB_SIZE - 1) / SLAB_SIZE * SLAB_SIZE;
+    // Address space only: pages get backed by memory as slabs are carved and written to.
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED)
+        return -1;
+    arena->slab_class = calloc(size / SLAB_SIZE, 1);
+    if (!arena->slab_class) {
+        munmap(base, size);
+        return -1;
+    }
+    arena->base = base;
+    arena->size = size;
+    pthread_mutex_init(&arena->lock, NULL);
+    arena->used = 0;
+    for (int c = 0; c < FUTURE_ARENA_N_CLASSES; c++) {
+        arena->free[c] = NULL;
+        arena->bump[c] = arena->bump_end[c] = NULL;
+    }
+    return 0;
+}
+
+static int size_class(size_t size)
+{
+    if (size <= FUTURE_ARENA_MIN_SIZE)
+        return 0;
+    // ceil(log2(size)) - log2(FUTURE_ARENA_MIN_SIZE).
+    return (int)(sizeof(unsigned long) * 8) - __builtin_clzl(size - 1) - 6;
+}
+
+static size_t class_size(int c)
+{
+    return (size_t)FUTURE_ARENA_MIN_SIZE << c;
+}
+
+/** Takes a block of class `c` from the shared list, or from a slab. Called with the lock held. */
+static ArenaBlock* take_locked(FutureArena* arena, int c)
+{
+    ArenaBlock* block = arena->free[c];
+    if (block) {
+        arena->free[c] = block->next;
+        return block;
+    }
+    if (arena->bump[c] == arena->bump_end[c]) {
+        if (arena->size - arena->used < SLAB_SIZE)
+            return NULL;
+        debug("Arena: new slab of %zu-byte blocks\n", class_size(c));
+        arena->slab_class[arena->used / SLAB_SIZE] = (uint8_t)c;
+        arena->bump[c] = arena->base + arena->used;
+        arena->bump_end[c] = arena->bump[c] + SLAB_SIZE;
+        arena->used += SLAB_SIZE;
+    }
+    block = (ArenaBlock*)arena->bump[c];
+    arena->bump[c] += class_size(c);
+    return block;
+}
+
+void* future_arena_alloc(FutureArena* arena, FutureArenaCache* cache, size_t size)
+{
+    if (size > FUTURE_ARENA_MAX_SIZE) {
+        errno = EINVAL;
+        return NULL;
+    }
+    int const c = size_class(size);
+    ArenaBlock* block;
+    if (cache && (block = cache->free[c]) != NULL) {
+        cache->free[c] = block->next;
+        cache->len[c]--;
+        return block;
+    }
+
+    pthread_mutex_lock(&arena->lock);
+    block = take_locked(arena, c);
+    // Stock up the thread's cache, so that the next allocations need no lock.
+    for (int i = 1; cache && block && i < REFILL_BATCH; i++) {
+        ArenaBlock* extra = take_locked(arena, c);
+        if (!extra)
+            break;
+        extra->next = cache->free[c];
+        cache->free[c] = extra;
+        cache->len[c]++;
+    }
+    pthread_mutex_unlock(&arena->lock);
+    if (!block)
+        errno = ENOMEM;
+    return block;
+}
+
+void future_arena_free(FutureArena* arena, FutureArenaCache* cache, void* ptr)
+{
+    int const c = arena->slab_class[((char*)ptr - arena->base) / SLAB_SIZE];
+    ArenaBlock* block = ptr;
+    if (cache && cache->len[c] < CACHE_MAX) {
+        block->next = cache->free[c];
+        cache->free[c] = block;
+        cache->len[c]++;
+        return;
+    }
+
+    // Give back half of the cache along with the block, so that blocks released by one thread
+    // and allocated by another do not pile up.
+    ArenaBlock* last = block;
+    last->next = NULL;
+    while (cache && cache->len[c] > CACHE_MAX / 2) {
+        ArenaBlock* moved = cache->free[c];
+        cache->free[c] = moved->next;
+        cache->len[c]--;
+        moved->next = block;
+        block = moved;
+    }
+    pthread_mutex_lock(&arena->lock);
+    last->next = arena->free[c];
+    arena->free[c] = block;
+    pthread_mutex_unlock(&arena->lock);
+}
+
+void future_arena_destroy(FutureArena* arena)
+{
+    munmap(arena->base, arena->size);
+    free(arena->slab_class);
+    pthread_mutex_destroy(&arena->lock);
+}
@@ -0,0 +1,69 @@
+#ifndef FUTURE_ARENA_H
+#define FUTURE_ARENA_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FUTURE_ARENA_MIN_SIZE 64 // Smallest size class (one cache line).
+#define FUTURE_ARENA_N_CLASSES 7 // Size classes 64, 128, ..., 4096 bytes.
+#define FUTURE_ARENA_MAX_SIZE (FUTURE_ARENA_MIN_SIZE << (FUTURE_ARENA_N_CLASSES - 1))
+
+/** A free block, linked through its first word. */
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+} ArenaBlock;
+
+/**
+ * Free blocks kept by one thread, which allocates from and releases to them without locking.
+ * They overflow to (and are refilled from) the shared lists of the arena in batches.
+ */
+typedef struct FutureArenaCache {
+    ArenaBlock* free[FUTURE_ARENA_N_CLASSES];
+    size_t len[FUTURE_ARENA_N_CLASSES];
+} FutureArenaCache;
+
+/**
+ * The memory of the futures allocated with `executor_alloc_future`, used internally by the
+ * executor.
+ *
+ * One range of address space is reserved up front (and only backed by memory once touched), so
+ * telling whether a future belongs to the arena is one comparison. It is carved into slabs of
+ * one size class each, and freed blocks are reused, never returned to the system before
+ * `future_arena_destroy`.
+ */
+typedef struct FutureArena {
+    char* base;
+    size_t size; // Of the reserved range.
+    uint8_t* slab_class; // Size class of each slab carved so far.
+    pthread_mutex_t lock; // Guards the fields below.
+    size_t used; // Bytes carved into slabs.
+    ArenaBlock* free[FUTURE_ARENA_N_CLASSES]; // Shared free lists.
+    char* bump[FUTURE_ARENA_N_CLASSES]; // Not yet handed out part of the newest slab of a class.
+    char* bump_end[FUTURE_ARENA_N_CLASSES];
+} FutureArena;
+
+/** Reserves `size` bytes of address space. Returns 0 on success, -1 on failure. */
+int future_arena_init(FutureArena* arena, size_t size);
+
+/** Whether `ptr` was allocated from the arena. */
+static inline bool future_arena_owns(FutureArena const* arena, void const* ptr)
+{
+    return (uintptr_t)ptr - (uintptr_t)arena->base < arena->size;
+}
+
+/**
+ * Allocates a block of at least `size` bytes, aligned to its size class, through `cache` (or
+ * directly from the shared lists if NULL). Returns NULL with errno set to EINVAL if `size`
+ * exceeds FUTURE_ARENA_MAX_SIZE, or to ENOMEM if the arena is exhausted.
+ */
+void* future_arena_alloc(FutureArena* arena, FutureArenaCache* cache, size_t size);
+
+/** Releases a block allocated from the arena, through `cache` (or directly if NULL). */
+void future_arena_free(FutureArena* arena, FutureArenaCache* cache, void* ptr);
+
+/** Releases the whole arena, including any block still allocated. */
+void future_arena_destroy(FutureArena* arena);
+
+#endif // FUTURE_ARENA_H
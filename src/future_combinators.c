@@ -1,15 +1,53 @@
 #include "future_combinators.h"
+#include <stddef.h>
 #include <stdlib.h>
 
 #include "future.h"
 #include "waker.h"
 #include "executor.h"
 
+/* Combinators that run several children at once give each child a waker of its own, pointing
+ * to a WakerSlot of the combinator (see waker.h). Slots are linked on the first progress.
+ */
+
+/* slot_init: Links a child's slot to the combinator's ready list and to its parent slot. */
+static void slot_init(WakerSlot* slot, _Atomic(WakerSlot*)* ready, WakerSlot* parent) {
+    atomic_init(&slot->parent, parent);
+    slot->ready_list = ready;
+    slot->next_ready = NULL;
+    atomic_init(&slot->queued, false);
+}
+
+/* slot_reparent: Follows the combinator if it is now progressed with a different waker slot. */
+static void slot_reparent(WakerSlot* slot, WakerSlot* parent) {
+    if (atomic_load_explicit(&slot->parent, memory_order_relaxed) != parent)
+        atomic_store(&slot->parent, parent);
+}
+
+/* slot_take: Pops a slot from a list taken off a ready list (NULL if empty).
+ * The slot is unmarked first, so that a wake during the child's progress queues it again.
+ */
+static WakerSlot* slot_take(WakerSlot** list) {
+    WakerSlot* slot = *list;
+    if (slot) {
+        *list = slot->next_ready;
+        atomic_store(&slot->queued, false);
+    }
+    return slot;
+}
+
+/* child_waker: The waker to progress a child with. */
+static inline Waker child_waker(Waker waker, WakerSlot* slot) {
+    return (Waker) { .executor = waker.executor, .future = waker.future, .slot = slot };
+}
+
 /* future_then: a combinator to chain two futures sequentially.
  * A full implementation would progress the first future, then pass its result to the second.
  * If the first future fails, the then future should fail as well.
  * If the second future fails, the then future should fail with a different error code.
  */
+/* Only one child is progressed at a time, so the waker is passed down as is: a wake of the
+ * ThenFuture is always for that child. */
 static FutureState then_progress(Future* base, Mio* mio, Waker waker) {
     ThenFuture* self = (ThenFuture*) base;
     
@@ -43,14 +81,10 @@ static FutureState then_progress(Future* base, Mio* mio, Waker waker) {
 
 ThenFuture future_then(Future* fut1, Future* fut2) {
     ThenFuture tf;
+    tf.base = future_create(then_progress);
     tf.fut1 = fut1;
     tf.fut2 = fut2;
     tf.fut1_completed = false;
-    tf.base.progress = then_progress;
-    tf.base.is_active = false;
-    tf.base.arg = NULL;
-    tf.base.ok = NULL;
-    tf.base.errcode = FUTURE_SUCCESS;
     return tf;
 }
 
@@ -59,13 +93,42 @@ ThenFuture future_then(Future* fut1, Future* fut2) {
  * and record their states. When both futures have completed, 
  * the join's progress returns COMPLETED if both succeeded (or FAILURE otherwise).
  */
+/* ready_pair: Which of two children with slots need progress: both on the first call,
+ * then only those woken since.
+ */
+static void ready_pair(WakerSlot* slot1, WakerSlot* slot2, _Atomic(WakerSlot*)* ready,
+    bool* started, WakerSlot* parent, bool* ready1, bool* ready2) {
+    if (!*started) {
+        *started = true;
+        atomic_init(ready, NULL);
+        slot_init(slot1, ready, parent);
+        slot_init(slot2, ready, parent);
+        *ready1 = *ready2 = true;
+        return;
+    }
+    slot_reparent(slot1, parent);
+    slot_reparent(slot2, parent);
+    *ready1 = *ready2 = false;
+    WakerSlot* list = atomic_exchange(ready, NULL);
+    WakerSlot* slot;
+    while ((slot = slot_take(&list)) != NULL) {
+        if (slot == slot1)
+            *ready1 = true;
+        else
+            *ready2 = true;
+    }
+}
+
 static FutureState join_progress(Future* base, Mio* mio, Waker waker) {
     JoinFuture* self = (JoinFuture*) base;
     FutureState state1, state2;
-    
-    // Progress fut1 if not already completed or failed.
-    if (self->fut1_completed == FUTURE_PENDING) {
-        state1 = self->fut1->progress(self->fut1, mio, waker);
+    bool ready1, ready2;
+    ready_pair(&self->slot1, &self->slot2, &self->ready, &self->started, waker.slot, &ready1,
+        &ready2);
+
+    // Progress fut1 if woken and not already completed or failed.
+    if (ready1 && self->fut1_completed == FUTURE_PENDING) {
+        state1 = self->fut1->progress(self->fut1, mio, child_waker(waker, &self->slot1));
         if (state1 == FUTURE_PENDING) {
             // Do nothing yet.
         } else if (state1 == FUTURE_COMPLETED) {
@@ -79,9 +142,9 @@ static FutureState join_progress(Future* base, Mio* mio, Waker waker) {
         }
     }
     
-    // Progress fut2 if not already completed or failed.
-    if (self->fut2_completed == FUTURE_PENDING) {
-        state2 = self->fut2->progress(self->fut2, mio, waker);
+    // Progress fut2 if woken and not already completed or failed.
+    if (ready2 && self->fut2_completed == FUTURE_PENDING) {
+        state2 = self->fut2->progress(self->fut2, mio, child_waker(waker, &self->slot2));
         if (state2 == FUTURE_PENDING) {
             // Do nothing.
         } else if (state2 == FUTURE_COMPLETED) {
@@ -121,17 +184,16 @@ static FutureState join_progress(Future* base, Mio* mio, Waker waker) {
 JoinFuture future_join(Future* fut1, Future* fut2)
 {
     JoinFuture jf;
+    jf.base = future_create(join_progress);
     jf.fut1 = fut1;
     jf.fut2 = fut2;
     jf.fut1_completed = FUTURE_PENDING;
     jf.fut2_completed = FUTURE_PENDING;
-    jf.base.progress = join_progress;
     jf.result.fut1.errcode = FUTURE_SUCCESS;
     jf.result.fut2.errcode = FUTURE_SUCCESS;
     jf.result.fut1.ok = NULL;
     jf.result.fut2.ok = NULL;
-    jf.base.errcode = FUTURE_SUCCESS;
-    jf.base.ok = NULL;
+    jf.started = false;
     return jf;
 }
 
@@ -158,9 +220,15 @@ static FutureState select_progress(Future* base, Mio* mio, Waker waker) {
         return FUTURE_FAILURE;
     }
 
-    // Progress fut1 if it hasn't failed yet.
-    if (self->which_completed == SELECT_COMPLETED_NONE || self->which_completed == SELECT_FAILED_FUT2) {
-        FutureState state1 = self->fut1->progress(self->fut1, mio, waker);
+    bool ready1, ready2;
+    ready_pair(&self->slot1, &self->slot2, &self->ready, &self->started, waker.slot, &ready1,
+        &ready2);
+
+    // Progress fut1 if woken and it hasn't failed yet.
+    if (ready1
+        && (self->which_completed == SELECT_COMPLETED_NONE
+            || self->which_completed == SELECT_FAILED_FUT2)) {
+        FutureState state1 = self->fut1->progress(self->fut1, mio, child_waker(waker, &self->slot1));
         if (state1 == FUTURE_COMPLETED) {
             self->which_completed = SELECT_COMPLETED_FUT1;
             base->ok = self->fut1->ok;
@@ -173,9 +241,11 @@ static FutureState select_progress(Future* base, Mio* mio, Waker waker) {
         }
     }
 
-    // Progress fut2 if it hasn't failed yet.
-    if (self->which_completed == SELECT_COMPLETED_NONE || self->which_completed == SELECT_FAILED_FUT1) {
-        FutureState state2 = self->fut2->progress(self->fut2, mio, waker);
+    // Progress fut2 if woken and it hasn't failed yet.
+    if (ready2
+        && (self->which_completed == SELECT_COMPLETED_NONE
+            || self->which_completed == SELECT_FAILED_FUT1)) {
+        FutureState state2 = self->fut2->progress(self->fut2, mio, child_waker(waker, &self->slot2));
         if (state2 == FUTURE_COMPLETED) {
             self->which_completed = SELECT_COMPLETED_FUT2;
             base->ok = self->fut2->ok;
@@ -194,11 +264,164 @@ static FutureState select_progress(Future* base, Mio* mio, Waker waker) {
 
 SelectFuture future_select(Future* fut1, Future* fut2)
 {
-    // Stub implementation – a complete version would monitor both and decide.
     SelectFuture sf;
+    sf.base = future_create(select_progress);
     sf.fut1 = fut1;
     sf.fut2 = fut2;
     sf.which_completed = SELECT_COMPLETED_NONE;
-    sf.base.progress = select_progress; // Real progress function to be implemented.
+    sf.started = false;
     return sf;
-}
\ No newline at end of file
+}
+
+/* Children of JoinAllFuture and SelectAnyFuture each get a waker with their own slot. */
+
+/* child_slots_init: Prepares the slots before the first progress (the combinator may have been
+ * moved since its creation, so the ready list cannot be set up before).
+ */
+static void child_slots_init(ChildResult* results, size_t n, _Atomic(WakerSlot*)* ready,
+    WakerSlot* parent) {
+    atomic_init(ready, NULL);
+    for (size_t i = 0; i < n; i++) {
+        results[i] = (ChildResult) { .state = FUTURE_PENDING, .errcode = FUTURE_SUCCESS };
+        slot_init(&results[i].slot, ready, parent);
+    }
+}
+
+/* child_slots_reparent: Keep the slots linked to the slot of the combinator's own waker,
+ * in case the combinator was moved to another parent.
+ */
+static void child_slots_reparent(ChildResult* results, size_t n, WakerSlot* parent) {
+    if (n == 0 || atomic_load(&results[0].slot.parent) == parent)
+        return;
+    for (size_t i = 0; i < n; i++)
+        slot_reparent(&results[i].slot, parent);
+}
+
+/* child_take_ready: Takes the next woken child off the ready list (n if there is none).
+ * Its slot is unmarked first, so that a wake during its progress queues it again.
+ */
+static size_t child_take_ready(ChildResult* results, size_t n, WakerSlot** list) {
+    WakerSlot* slot = slot_take(list);
+    if (!slot)
+        return n;
+    return (ChildResult*)((char*)slot - offsetof(ChildResult, slot)) - results;
+}
+
+/* child_progress: Progresses one child with its own waker and records its outcome. */
+static FutureState child_progress(Future* fut, ChildResult* result, Mio* mio, Waker waker) {
+    FutureState state = fut->progress(fut, mio, child_waker(waker, &result->slot));
+    result->state = state;
+    if (state == FUTURE_COMPLETED)
+        result->ok = fut->ok;
+    else if (state == FUTURE_FAILURE)
+        result->errcode = fut->errcode;
+    return state;
+}
+
+/* future_join_all: a combinator to run n futures concurrently.
+ * The first progress progresses every child; later ones only those on the ready list.
+ */
+static void join_all_progress_child(JoinAllFuture* self, size_t i, Mio* mio, Waker waker) {
+    if (self->results[i].state != FUTURE_PENDING)
+        return; // Woken after it finished (e.g., by a stale registration).
+    FutureState state = child_progress(self->futs[i], &self->results[i], mio, waker);
+    if (state != FUTURE_PENDING) {
+        self->n_pending--;
+        if (state == FUTURE_FAILURE)
+            self->n_failed++;
+    }
+}
+
+static FutureState join_all_progress(Future* base, Mio* mio, Waker waker) {
+    JoinAllFuture* self = (JoinAllFuture*)base;
+
+    if (!self->started) {
+        self->started = true;
+        child_slots_init(self->results, self->n, &self->ready, waker.slot);
+        for (size_t i = 0; i < self->n; i++)
+            join_all_progress_child(self, i, mio, waker);
+    } else {
+        child_slots_reparent(self->results, self->n, waker.slot);
+        WakerSlot* list = atomic_exchange(&self->ready, NULL);
+        size_t i;
+        while ((i = child_take_ready(self->results, self->n, &list)) != self->n)
+            join_all_progress_child(self, i, mio, waker);
+    }
+
+    if (self->n_pending > 0)
+        return FUTURE_PENDING;
+    base->ok = self->results;
+    if (self->n_failed > 0) {
+        base->errcode = JOIN_ALL_FUTURE_ERR_FAILED;
+        return FUTURE_FAILURE;
+    }
+    return FUTURE_COMPLETED;
+}
+
+JoinAllFuture future_join_all(Future** futs, size_t n, ChildResult* results)
+{
+    return (JoinAllFuture) {
+        .base = future_create(join_all_progress),
+        .futs = futs,
+        .results = results,
+        .n = n,
+        .n_pending = n,
+        .n_failed = 0,
+        .started = false,
+    };
+}
+
+/* future_select_any: a combinator to run n futures until one completes.
+ * Children are progressed like in future_join_all, until the first one completes.
+ */
+static void select_any_progress_child(SelectAnyFuture* self, size_t i, Mio* mio, Waker waker) {
+    if (self->results[i].state != FUTURE_PENDING)
+        return;
+    FutureState state = child_progress(self->futs[i], &self->results[i], mio, waker);
+    if (state == FUTURE_COMPLETED)
+        self->winner = i;
+    else if (state == FUTURE_FAILURE)
+        self->n_failed++;
+}
+
+static FutureState select_any_progress(Future* base, Mio* mio, Waker waker) {
+    SelectAnyFuture* self = (SelectAnyFuture*)base;
+
+    if (!self->started) {
+        self->started = true;
+        child_slots_init(self->results, self->n, &self->ready, waker.slot);
+        for (size_t i = 0; i < self->n && self->winner == self->n; i++)
+            select_any_progress_child(self, i, mio, waker);
+    } else if (self->winner == self->n) {
+        child_slots_reparent(self->results, self->n, waker.slot);
+        WakerSlot* list = atomic_exchange(&self->ready, NULL);
+        size_t i;
+        while (self->winner == self->n
+            && (i = child_take_ready(self->results, self->n, &list)) != self->n)
+            select_any_progress_child(self, i, mio, waker);
+        // Children still on `list` lost anyway: they are not progressed anymore.
+    }
+
+    if (self->winner != self->n) {
+        base->ok = self->results[self->winner].ok;
+        return FUTURE_COMPLETED;
+    }
+    if (self->n_failed == self->n) {
+        base->errcode = SELECT_ANY_FUTURE_ERR_ALL_FAILED;
+        return FUTURE_FAILURE;
+    }
+    return FUTURE_PENDING;
+}
+
+SelectAnyFuture future_select_any(Future** futs, size_t n, ChildResult* results)
+{
+    return (SelectAnyFuture) {
+        .base = future_create(select_any_progress),
+        .futs = futs,
+        .results = results,
+        .n = n,
+        .n_failed = 0,
+        .winner = n,
+        .started = false,
+    };
+}
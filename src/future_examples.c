@@ -1,12 +1,19 @@
+// Required for `fcntl.h` to declare splice() and tee().
+#define _GNU_SOURCE
+
 #include "future_examples.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdint.h>
 #include <string.h>
 #include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "debug.h"
+#include "future_io.h"
 #include "mio.h"
 #include "waker.h"
 
@@ -31,39 +38,141 @@ ApplyFuture apply_future_create(void* (*func)(void*))
     return apply_future;
 }
 
-/** Progress function for PipeReadFuture */
-static FutureState pipe_read_progress(Future* base, Mio* mio, Waker waker)
+static FutureState spawn_blocking_progress(Future* fut, Mio* mio, Waker waker)
 {
-    PipeReadFuture* self = (PipeReadFuture*)base;
-    debug("PipeReadFuture %p progress. read_so_far=%zu, n=%zu\n", self, self->read_so_far, self->n);
+    SpawnBlockingFuture* self = (SpawnBlockingFuture*)fut;
+
+    if (!self->submitted) {
+        self->task.waker = waker;
+        if (executor_run_blocking((Executor*)waker.executor, &self->task) != 0) {
+            self->base.errcode = SPAWN_BLOCKING_FUTURE_ERR_NO_THREAD;
+            return FUTURE_FAILURE;
+        }
+        self->submitted = true;
+        debug("SpawnBlockingFuture %p submitted\n", self);
+        return FUTURE_PENDING;
+    }
+    if (!blocking_task_done(&self->task))
+        return FUTURE_PENDING; // Woken by something else: the pool thread will wake us again.
+
+    self->base.ok = self->task.result;
+    return FUTURE_COMPLETED;
+}
+
+SpawnBlockingFuture spawn_blocking_future_create(void* (*func)(void*), void* arg)
+{
+    SpawnBlockingFuture fut = {
+        .base = future_create(spawn_blocking_progress),
+        .task = { .func = func, .arg = arg },
+        .submitted = false,
+    };
+    fut.base.arg = arg;
+    return fut;
+}
+
+/** PipeReadFuture over readiness-based I/O: read() until EAGAIN, then wait for EPOLLIN. */
+static FutureState pipe_read_ready_progress(PipeReadFuture* self, Mio* mio, Waker waker)
+{
+    MioReadiness const ready = mio_readiness(mio, self->fd);
+    IoReadiness const known = io_readiness(ready, EPOLLIN);
+    if (known == IO_WOULD_BLOCK) {
+        // Not readable since the last EAGAIN (e.g., progressed along with a sibling): skip read().
+        mio_register(mio, self->fd, EPOLLIN | self->trigger, waker);
+        return FUTURE_PENDING;
+    } else if (known != IO_TRY) {
+        mio_unregister_events(mio, self->fd, EPOLLIN);
+        self->base.errcode = known == IO_EOF ? PIPE_FUTURE_ERR_EOF : PIPE_FUTURE_ERR_IO;
+        return FUTURE_FAILURE;
+    }
 
     while (self->read_so_far < self->n) {
+        if (!io_budget_spend(&waker))
+            return FUTURE_PENDING; // Yield: the pipe may still have data, but we woke ourselves.
         // There are some bytes yet to be read. Try reading from the pipe.
-        ssize_t const bytes_read
-            = read(self->fd, self->buffer + self->read_so_far, self->n - self->read_so_far);
+        ssize_t const bytes_read = read(
+            self->fd, self->buffer + self->read_so_far, io_chunk(self->n - self->read_so_far));
         debug("PipeReadFuture %p: read %zd, errno %s\n", self, bytes_read,
             strerror(bytes_read == -1 ? errno : 0));
 
         if (bytes_read == 0) {
-            mio_unregister(mio, self->fd);
+            mio_unregister_events(mio, self->fd, EPOLLIN);
             self->base.errcode = PIPE_FUTURE_ERR_EOF;
             return FUTURE_FAILURE;
         } else if (bytes_read > 0) {
             self->read_so_far += bytes_read;
+            io_budget_spend_bytes(&waker, bytes_read);
         } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            // Could not read from pipe.
-            // Register the FD with MIO to watch for readability.
-            mio_register(mio, self->fd, EPOLLIN, waker);
+            // Could not read from pipe: it is drained, so even an edge-triggered
+            // registration will fire on the next write. Register the FD with MIO
+            // to watch for readability (a no-op if it already is).
+            mio_clear_readiness(mio, self->fd, ready, EPOLLIN);
+            mio_register(mio, self->fd, EPOLLIN | self->trigger, waker);
             return FUTURE_PENDING;
+        } else if (errno != EINTR) {
+            mio_unregister_events(mio, self->fd, EPOLLIN);
+            self->base.errcode = PIPE_FUTURE_ERR_IO;
+            return FUTURE_FAILURE;
         }
     }
 
     // Read enough bytes.
-    mio_unregister(mio, self->fd);
+    mio_unregister_events(mio, self->fd, EPOLLIN);
+    self->base.ok = self->buffer;
+    return FUTURE_COMPLETED;
+}
+
+/** PipeReadFuture over completion-based I/O: each chunk is a read submitted through Mio. */
+static FutureState pipe_read_submit_progress(PipeReadFuture* self, Mio* mio, Waker waker)
+{
+    while (self->read_so_far < self->n) {
+        if (!self->op.in_flight) {
+            if (!io_budget_spend(&waker))
+                return FUTURE_PENDING;
+            if (mio_submit_read(mio, &self->op, self->fd, self->buffer + self->read_so_far,
+                    io_chunk(self->n - self->read_so_far), waker)
+                != 0)
+                return pipe_read_ready_progress(self, mio, waker); // Submission queue trouble.
+            return FUTURE_PENDING;
+        }
+        if (!mio_op_done(&self->op))
+            return FUTURE_PENDING; // Woken for another reason: completion will wake us again.
+
+        int const bytes_read = mio_op_consume(&self->op);
+        debug("PipeReadFuture %p: read completed with %d\n", self, bytes_read);
+        if (bytes_read == 0) {
+            mio_unregister_events(mio, self->fd, EPOLLIN);
+            self->base.errcode = PIPE_FUTURE_ERR_EOF;
+            return FUTURE_FAILURE;
+        } else if (bytes_read > 0) {
+            self->read_so_far += bytes_read;
+            io_budget_spend_bytes(&waker, bytes_read);
+        } else if (bytes_read == -EAGAIN || bytes_read == -EWOULDBLOCK) {
+            // The kernel did not wait for data: wait for readability, then submit again.
+            mio_register(mio, self->fd, EPOLLIN | self->trigger, waker);
+            return FUTURE_PENDING;
+        } else if (bytes_read != -EINTR) {
+            mio_unregister_events(mio, self->fd, EPOLLIN);
+            self->base.errcode = PIPE_FUTURE_ERR_IO;
+            return FUTURE_FAILURE;
+        }
+    }
+
+    mio_unregister_events(mio, self->fd, EPOLLIN);
     self->base.ok = self->buffer;
     return FUTURE_COMPLETED;
 }
 
+/** Progress function for PipeReadFuture */
+static FutureState pipe_read_progress(Future* base, Mio* mio, Waker waker)
+{
+    PipeReadFuture* self = (PipeReadFuture*)base;
+    debug("PipeReadFuture %p progress. read_so_far=%zu, n=%zu\n", self, self->read_so_far, self->n);
+
+    if (mio_supports_submission(mio))
+        return pipe_read_submit_progress(self, mio, waker);
+    return pipe_read_ready_progress(self, mio, waker);
+}
+
 PipeReadFuture pipe_read_future_create(int fd, uint8_t* buffer, size_t n)
 {
     return (PipeReadFuture) {
@@ -72,54 +181,123 @@ PipeReadFuture pipe_read_future_create(int fd, uint8_t* buffer, size_t n)
         .buffer = buffer,
         .n = n,
         .read_so_far = 0,
+        .trigger = 0,
+        .op = mio_op_create(),
     };
 }
 
-/** Progress function for PipeWriteFuture */
-static FutureState pipe_write_progress(Future* base, Mio* mio, Waker waker)
+/** PipeWriteFuture over readiness-based I/O: write() until EAGAIN, then wait. */
+static FutureState pipe_write_ready_progress(PipeWriteFuture* self, Mio* mio, Waker waker)
 {
-    PipeWriteFuture* self = (PipeWriteFuture*)base;
     const char* buffer = self->base.arg;
-    debug("PipeWriteFuture %p progress. written_so_far=%zu, n=%zu\n", self, self->written_so_far,
-        self->n);
 
-    // If the future was created with stop_on_zero_byte=true,
-    // we interpret the input argument as a c-string and adjust n accordingly.
-    if (self->stop_on_zero_byte) {
-        size_t len = strnlen(buffer, self->n);
-        if (len < self->n) {
-            self->n = len + 1; // Include the zero byte.
-        }
-        self->stop_on_zero_byte = false;
+    MioReadiness const ready = mio_readiness(mio, self->fd);
+    IoReadiness const known = io_readiness(ready, EPOLLOUT);
+    if (known == IO_WOULD_BLOCK) {
+        mio_register(mio, self->fd, EPOLLOUT | self->trigger, waker);
+        return FUTURE_PENDING;
+    } else if (known != IO_TRY) {
+        mio_unregister_events(mio, self->fd, EPOLLOUT);
+        self->base.errcode = known == IO_EOF ? PIPE_FUTURE_ERR_EOF : PIPE_FUTURE_ERR_IO;
+        return FUTURE_FAILURE;
     }
 
     while (self->written_so_far < self->n) {
+        if (!io_budget_spend(&waker))
+            return FUTURE_PENDING;
         // There are some bytes yet to be written. Try writing to the pipe.
-        ssize_t const bytes_written
-            = write(self->fd, buffer + self->written_so_far, self->n - self->written_so_far);
+        ssize_t const bytes_written = write(
+            self->fd, buffer + self->written_so_far, io_chunk(self->n - self->written_so_far));
         debug("PipeReadFuture %p: write %zd, errno %s\n", self, bytes_written,
             strerror(bytes_written == -1 ? errno : 0));
 
         if (bytes_written == 0) {
-            mio_unregister(mio, self->fd);
+            mio_unregister_events(mio, self->fd, EPOLLOUT);
             self->base.errcode = PIPE_FUTURE_ERR_EOF;
             return FUTURE_FAILURE;
         } else if (bytes_written > 0) {
             self->written_so_far += bytes_written;
+            io_budget_spend_bytes(&waker, bytes_written);
         } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            // Could not write from pipe.
+            // Could not write to pipe.
             // Register the FD with MIO to watch for writeability.
-            mio_register(mio, self->fd, EPOLLIN, waker);
+            mio_clear_readiness(mio, self->fd, ready, EPOLLOUT);
+            mio_register(mio, self->fd, EPOLLOUT | self->trigger, waker);
             return FUTURE_PENDING;
+        } else if (errno != EINTR) {
+            mio_unregister_events(mio, self->fd, EPOLLOUT);
+            self->base.errcode = PIPE_FUTURE_ERR_IO;
+            return FUTURE_FAILURE;
         }
     }
 
     // Read enough bytes.
-    mio_unregister(mio, self->fd);
+    mio_unregister_events(mio, self->fd, EPOLLOUT);
+    self->base.ok = (void*)buffer;
+    return FUTURE_COMPLETED;
+}
+
+/** PipeWriteFuture over completion-based I/O: each chunk is a write submitted through Mio. */
+static FutureState pipe_write_submit_progress(PipeWriteFuture* self, Mio* mio, Waker waker)
+{
+    const char* buffer = self->base.arg;
+
+    while (self->written_so_far < self->n) {
+        if (!self->op.in_flight) {
+            if (!io_budget_spend(&waker))
+                return FUTURE_PENDING;
+            if (mio_submit_write(mio, &self->op, self->fd, buffer + self->written_so_far,
+                    io_chunk(self->n - self->written_so_far), waker)
+                != 0)
+                return pipe_write_ready_progress(self, mio, waker); // Submission queue trouble.
+            return FUTURE_PENDING;
+        }
+        if (!mio_op_done(&self->op))
+            return FUTURE_PENDING; // Woken for another reason: completion will wake us again.
+
+        int const bytes_written = mio_op_consume(&self->op);
+        debug("PipeWriteFuture %p: write completed with %d\n", self, bytes_written);
+        if (bytes_written > 0) {
+            self->written_so_far += bytes_written;
+            io_budget_spend_bytes(&waker, bytes_written);
+        } else if (bytes_written == -EAGAIN || bytes_written == -EWOULDBLOCK) {
+            mio_register(mio, self->fd, EPOLLOUT | self->trigger, waker);
+            return FUTURE_PENDING;
+        } else if (bytes_written != -EINTR) {
+            mio_unregister_events(mio, self->fd, EPOLLOUT);
+            self->base.errcode = bytes_written == 0 ? PIPE_FUTURE_ERR_EOF : PIPE_FUTURE_ERR_IO;
+            return FUTURE_FAILURE;
+        }
+    }
+
+    mio_unregister_events(mio, self->fd, EPOLLOUT);
     self->base.ok = (void*)buffer;
     return FUTURE_COMPLETED;
 }
 
+/** Progress function for PipeWriteFuture */
+static FutureState pipe_write_progress(Future* base, Mio* mio, Waker waker)
+{
+    PipeWriteFuture* self = (PipeWriteFuture*)base;
+    const char* buffer = self->base.arg;
+    debug("PipeWriteFuture %p progress. written_so_far=%zu, n=%zu\n", self, self->written_so_far,
+        self->n);
+
+    // If the future was created with stop_on_zero_byte=true,
+    // we interpret the input argument as a c-string and adjust n accordingly.
+    if (self->stop_on_zero_byte) {
+        size_t len = strnlen(buffer, self->n);
+        if (len < self->n) {
+            self->n = len + 1; // Include the zero byte.
+        }
+        self->stop_on_zero_byte = false;
+    }
+
+    if (mio_supports_submission(mio))
+        return pipe_write_submit_progress(self, mio, waker);
+    return pipe_write_ready_progress(self, mio, waker);
+}
+
 PipeWriteFuture pipe_write_future_create(int fd, size_t n, bool stop_on_zero_byte)
 {
     return (PipeWriteFuture) {
@@ -128,5 +306,346 @@ PipeWriteFuture pipe_write_future_create(int fd, size_t n, bool stop_on_zero_byt
         .n = n,
         .written_so_far = 0,
         .stop_on_zero_byte = stop_on_zero_byte,
+        .trigger = 0,
+        .op = mio_op_create(),
+    };
+}
+
+/** Skips the buffers of a vectored pipe future that are complete (or empty). */
+static void pipe_vectored_skip_full(PipeVectoredFuture* self)
+{
+    while (self->iov_index < self->iovcnt
+        && self->iov_offset == self->iov[self->iov_index].iov_len) {
+        self->iov_index++;
+        self->iov_offset = 0;
+    }
+}
+
+/** Accounts for `n` bytes moved, across buffer boundaries. */
+static void pipe_vectored_advance(PipeVectoredFuture* self, size_t n)
+{
+    self->transferred += n;
+    while (n > 0) {
+        size_t const left = self->iov[self->iov_index].iov_len - self->iov_offset;
+        size_t const step = n < left ? n : left;
+        self->iov_offset += step;
+        n -= step;
+        pipe_vectored_skip_full(self);
+    }
+}
+
+/** Fills `iov` with the parts of the buffers not done yet, returning how many. */
+static int pipe_vectored_pending(PipeVectoredFuture const* self, struct iovec* iov)
+{
+    int cnt = 0;
+    for (int i = self->iov_index; i < self->iovcnt && cnt < PIPE_IOV_BATCH; i++)
+        iov[cnt++] = self->iov[i];
+    iov[0].iov_base = (char*)iov[0].iov_base + self->iov_offset;
+    iov[0].iov_len -= self->iov_offset;
+    return cnt;
+}
+
+/** Progress of PipeReadvFuture and PipeWritevFuture: one readv()/writev() per step, over all the
+ *  buffers left (up to PIPE_IOV_BATCH), until EAGAIN. */
+static FutureState pipe_vectored_progress(
+    PipeVectoredFuture* self, Mio* mio, Waker waker, bool is_write)
+{
+    uint32_t const events = is_write ? EPOLLOUT : EPOLLIN;
+    MioReadiness const ready = mio_readiness(mio, self->fd);
+    IoReadiness const known = io_readiness(ready, events);
+    if (known == IO_WOULD_BLOCK) {
+        mio_register(mio, self->fd, events | self->trigger, waker);
+        return FUTURE_PENDING;
+    } else if (known != IO_TRY) {
+        mio_unregister_events(mio, self->fd, events);
+        self->base.errcode = known == IO_EOF ? PIPE_FUTURE_ERR_EOF : PIPE_FUTURE_ERR_IO;
+        return FUTURE_FAILURE;
+    }
+
+    pipe_vectored_skip_full(self);
+    while (self->iov_index < self->iovcnt) {
+        if (!io_budget_spend(&waker))
+            return FUTURE_PENDING;
+        struct iovec iov[PIPE_IOV_BATCH];
+        int const cnt = pipe_vectored_pending(self, iov);
+        ssize_t const n = is_write ? writev(self->fd, iov, cnt) : readv(self->fd, iov, cnt);
+        debug("PipeVectoredFuture %p: %s %zd, errno %s\n", self,
+            is_write ? "writev" : "readv", n, strerror(n == -1 ? errno : 0));
+
+        if (n == 0) {
+            mio_unregister_events(mio, self->fd, events);
+            self->base.errcode = PIPE_FUTURE_ERR_EOF;
+            return FUTURE_FAILURE;
+        } else if (n > 0) {
+            pipe_vectored_advance(self, n);
+            io_budget_spend_bytes(&waker, n);
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            mio_clear_readiness(mio, self->fd, ready, events);
+            mio_register(mio, self->fd, events | self->trigger, waker);
+            return FUTURE_PENDING;
+        } else if (errno != EINTR) {
+            mio_unregister_events(mio, self->fd, events);
+            self->base.errcode = PIPE_FUTURE_ERR_IO;
+            return FUTURE_FAILURE;
+        }
+    }
+
+    mio_unregister_events(mio, self->fd, events);
+    self->base.ok = (void*)self->iov;
+    return FUTURE_COMPLETED;
+}
+
+static FutureState pipe_readv_progress(Future* base, Mio* mio, Waker waker)
+{
+    return pipe_vectored_progress((PipeVectoredFuture*)base, mio, waker, false);
+}
+
+static FutureState pipe_writev_progress(Future* base, Mio* mio, Waker waker)
+{
+    return pipe_vectored_progress((PipeVectoredFuture*)base, mio, waker, true);
+}
+
+static PipeVectoredFuture pipe_vectored_future_create(
+    ProgressFn progress, int fd, struct iovec const* iov, int iovcnt)
+{
+    return (PipeVectoredFuture) {
+        .base = future_create(progress),
+        .fd = fd,
+        .iov = iov,
+        .iovcnt = iovcnt,
+        .iov_index = 0,
+        .iov_offset = 0,
+        .transferred = 0,
+        .trigger = 0,
+    };
+}
+
+PipeReadvFuture pipe_readv_future_create(int fd, struct iovec const* iov, int iovcnt)
+{
+    return pipe_vectored_future_create(pipe_readv_progress, fd, iov, iovcnt);
+}
+
+PipeWritevFuture pipe_writev_future_create(int fd, struct iovec const* iov, int iovcnt)
+{
+    return pipe_vectored_future_create(pipe_writev_progress, fd, iov, iovcnt);
+}
+
+// Bits of SpliceFuture.waiting.
+#define SPLICE_WAIT_IN 0x1
+#define SPLICE_WAIT_OUT 0x2
+#define SPLICE_WAIT_TEE 0x4
+
+/** Registers exactly the fds in `want` (SPLICE_WAIT_* bits), unregistering the others. */
+static void splice_wait(SpliceFuture* self, Mio* mio, Waker waker, uint8_t want)
+{
+    int const fds[] = { self->in_fd, self->out_fd, self->tee_fd };
+    uint32_t const events[] = { EPOLLIN, EPOLLOUT, EPOLLOUT };
+    for (int i = 0; i < 3; i++) {
+        uint8_t const bit = 1 << i;
+        if (want & bit)
+            mio_register(mio, fds[i], events[i] | self->trigger, waker);
+        else if (self->waiting & bit)
+            mio_unregister_events(mio, fds[i], events[i]);
+    }
+    self->waiting = want;
+}
+
+static FutureState splice_finish(SpliceFuture* self, Mio* mio, Waker waker, int errcode)
+{
+    splice_wait(self, mio, waker, 0);
+    free(self->ring);
+    self->ring = NULL;
+    self->base.errcode = errcode;
+    if (errcode != FUTURE_SUCCESS)
+        return FUTURE_FAILURE;
+    self->base.ok = NULL;
+    return FUTURE_COMPLETED;
+}
+
+/** What an EOF of the source means: done if forwarding until EOF, a failure otherwise. */
+static FutureState splice_eof(SpliceFuture* self, Mio* mio, Waker waker)
+{
+    return splice_finish(
+        self, mio, waker, self->n == SPLICE_UNTIL_EOF ? FUTURE_SUCCESS : PIPE_FUTURE_ERR_EOF);
+}
+
+/** After EAGAIN from splice() or tee(): wait for the source if it is empty, else for `sink`. */
+static FutureState splice_blocked(SpliceFuture* self, Mio* mio, Waker waker, uint8_t sink)
+{
+    int available = 0;
+    if (ioctl(self->in_fd, FIONREAD, &available) == 0 && available == 0)
+        splice_wait(self, mio, waker, SPLICE_WAIT_IN);
+    else
+        splice_wait(self, mio, waker, sink);
+    return FUTURE_PENDING;
+}
+
+/** The fallback: read() into a bounded ring buffer and write() out of it, each side going as far
+ *  as it can; wait for whichever sides could make progress. */
+static FutureState splice_copy_progress(SpliceFuture* self, Mio* mio, Waker waker)
+{
+    if (!self->ring && !(self->ring = malloc(SPLICE_RING_SIZE)))
+        return splice_finish(self, mio, waker, PIPE_FUTURE_ERR_IO);
+
+    bool eof = false;
+    while (self->moved < self->n) {
+        if (!io_budget_spend(&waker))
+            return FUTURE_PENDING;
+        bool progressed = false;
+        bool const want_more = self->ring_read < self->n && !eof;
+        size_t const tail = (self->ring_head + self->ring_len) % SPLICE_RING_SIZE;
+        size_t room = SPLICE_RING_SIZE - self->ring_len;
+        if (room > SPLICE_RING_SIZE - tail)
+            room = SPLICE_RING_SIZE - tail; // Up to the end of the buffer: wrap on the next read.
+        if (self->n - self->ring_read < room)
+            room = self->n - self->ring_read;
+        if (want_more && room > 0) {
+            ssize_t const r = read(self->in_fd, self->ring + tail, io_chunk(room));
+            if (r > 0) {
+                self->ring_read += r;
+                self->ring_len += r;
+                progressed = true;
+            } else if (r == 0) {
+                eof = true;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                return splice_finish(self, mio, waker, PIPE_FUTURE_ERR_IO);
+            }
+        }
+        if (self->ring_len > 0) {
+            size_t len = SPLICE_RING_SIZE - self->ring_head;
+            if (len > self->ring_len)
+                len = self->ring_len;
+            ssize_t const w = write(self->out_fd, self->ring + self->ring_head, io_chunk(len));
+            if (w > 0) {
+                self->moved += w;
+                self->ring_head = (self->ring_head + w) % SPLICE_RING_SIZE;
+                self->ring_len -= w;
+                io_budget_spend_bytes(&waker, w);
+                progressed = true;
+            } else if (w == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                return splice_finish(self, mio, waker, PIPE_FUTURE_ERR_IO);
+            }
+        }
+        if (eof && self->ring_len == 0)
+            return splice_eof(self, mio, waker);
+        if (!progressed) {
+            uint8_t want = self->ring_len > 0 ? SPLICE_WAIT_OUT : 0;
+            if (want_more && self->ring_len < SPLICE_RING_SIZE && !eof)
+                want |= SPLICE_WAIT_IN;
+            splice_wait(self, mio, waker, want);
+            return FUTURE_PENDING;
+        }
+    }
+    return splice_finish(self, mio, waker, FUTURE_SUCCESS);
+}
+
+static FutureState splice_progress(Future* base, Mio* mio, Waker waker)
+{
+    SpliceFuture* self = (SpliceFuture*)base;
+    if (self->ring)
+        return splice_copy_progress(self, mio, waker);
+
+    while (self->moved < self->n) {
+        if (!io_budget_spend(&waker))
+            return FUTURE_PENDING;
+        size_t len = io_chunk(self->n - self->moved);
+        if (self->tee_fd != -1) {
+            if (self->teed == 0) {
+                ssize_t const t = tee(self->in_fd, self->tee_fd, len, SPLICE_F_NONBLOCK);
+                if (t == 0)
+                    return splice_eof(self, mio, waker);
+                if (t < 0) {
+                    if (errno == EAGAIN)
+                        return splice_blocked(self, mio, waker, SPLICE_WAIT_TEE);
+                    if (errno == EINTR)
+                        continue;
+                    return splice_finish(self, mio, waker, PIPE_FUTURE_ERR_IO);
+                }
+                self->teed = t;
+            }
+            len = self->teed; // Move exactly what the other sink got.
+        }
+
+        ssize_t const r = splice(
+            self->in_fd, NULL, self->out_fd, NULL, len, SPLICE_F_NONBLOCK | SPLICE_F_MOVE);
+        debug("SpliceFuture %p: splice %zd, errno %s\n", self, r, strerror(r == -1 ? errno : 0));
+        if (r > 0) {
+            self->moved += r;
+            if (self->tee_fd != -1)
+                self->teed -= r;
+            io_budget_spend_bytes(&waker, r);
+        } else if (r == 0) {
+            return splice_eof(self, mio, waker);
+        } else if (errno == EAGAIN) {
+            return splice_blocked(self, mio, waker, SPLICE_WAIT_OUT);
+        } else if (errno == EINVAL && self->tee_fd == -1) {
+            // Neither fd is a pipe (or the fds do not support splicing): copy instead.
+            debug("SpliceFuture %p: falling back to read() and write()\n", self);
+            return splice_copy_progress(self, mio, waker);
+        } else if (errno != EINTR) {
+            return splice_finish(self, mio, waker, PIPE_FUTURE_ERR_IO);
+        }
+    }
+    return splice_finish(self, mio, waker, FUTURE_SUCCESS);
+}
+
+SpliceFuture splice_tee_future_create(int in_fd, int out_fd, int tee_fd, size_t n)
+{
+    return (SpliceFuture) {
+        .base = future_create(splice_progress),
+        .in_fd = in_fd,
+        .out_fd = out_fd,
+        .tee_fd = tee_fd,
+        .n = n,
+        .moved = 0,
+        .teed = 0,
+        .trigger = 0,
+        .waiting = 0,
+        .ring = NULL,
+        .ring_head = 0,
+        .ring_len = 0,
+        .ring_read = 0,
     };
 }
+
+SpliceFuture splice_future_create(int in_fd, int out_fd, size_t n)
+{
+    return splice_tee_future_create(in_fd, out_fd, -1, n);
+}
+
+/** Progress function for SleepFuture */
+static FutureState sleep_progress(Future* base, Mio* mio, Waker waker)
+{
+    SleepFuture* self = (SleepFuture*)base;
+    debug("SleepFuture %p progress. duration_ms=%llu\n", self, (unsigned long long)self->duration_ms);
+
+    if (!self->started) {
+        self->started = true;
+        mio_register_timer(mio, &self->timer, mio_now_ms() + self->duration_ms, waker);
+        return FUTURE_PENDING;
+    }
+    if (mio_timer_pending(&self->timer)) {
+        // Progressed before the deadline: keep the timer, but with the current waker.
+        mio_register_timer(mio, &self->timer, self->timer.deadline, waker);
+        return FUTURE_PENDING;
+    }
+
+    self->base.ok = NULL;
+    return FUTURE_COMPLETED;
+}
+
+SleepFuture sleep_future_create(uint64_t duration_ms)
+{
+    return (SleepFuture) {
+        .base = future_create(sleep_progress),
+        .duration_ms = duration_ms,
+        .started = false,
+        .timer = mio_timer_create(),
+    };
+}
+
+void sleep_future_cancel(Mio* mio, SleepFuture* fut)
+{
+    if (fut->started)
+        mio_cancel_timer(mio, &fut->timer);
+}
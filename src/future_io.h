@@ -0,0 +1,65 @@
+#ifndef FUTURE_IO_H
+#define FUTURE_IO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+
+#include "executor.h"
+#include "mio.h"
+#include "waker.h"
+
+/*
+ * Helpers shared by the futures doing readiness-based I/O (pipes, sockets).
+ */
+
+// Futures move at most this much per syscall, and spend one unit of the task budget per syscall
+// plus one per IO_BYTES_PER_BUDGET_UNIT moved (see `executor_budget_spend`).
+#define IO_CHUNK_MAX (64 * 1024)
+#define IO_BYTES_PER_BUDGET_UNIT 4096
+
+/** Spends the budget of one syscall, or wakes the future to yield if it ran out. */
+static inline bool io_budget_spend(Waker* waker)
+{
+    if (executor_budget_spend((Executor*)waker->executor, 1))
+        return true;
+    waker_wake(waker);
+    return false;
+}
+
+/** Spends the budget of `n` bytes moved by a syscall (one that succeeded regardless). */
+static inline void io_budget_spend_bytes(Waker* waker, size_t n)
+{
+    executor_budget_spend((Executor*)waker->executor, n / IO_BYTES_PER_BUDGET_UNIT);
+}
+
+static inline size_t io_chunk(size_t left)
+{
+    return left < IO_CHUNK_MAX ? left : IO_CHUNK_MAX;
+}
+
+/** What Mio's readiness of an fd tells about the next read or write (see `io_readiness`). */
+typedef enum IoReadiness {
+    IO_TRY, // The syscall is worth making.
+    IO_WOULD_BLOCK, // It would only get EAGAIN: the future was progressed for another reason.
+    IO_EOF, // A read would return 0: hung up and drained.
+    IO_ERROR, // It would fail (for a write to a pipe: with EPIPE, and raise SIGPIPE).
+} IoReadiness;
+
+/** Tells from `ready` (see `mio_readiness`) how a read (`events` EPOLLIN) or write (EPOLLOUT)
+ *  would end, without making it. */
+static inline IoReadiness io_readiness(MioReadiness ready, uint32_t events)
+{
+    if (events == EPOLLOUT && (ready.events & (EPOLLERR | EPOLLHUP)))
+        return IO_ERROR; // Nobody reads anymore.
+    if (ready.events & events)
+        return IO_TRY;
+    if (ready.events & EPOLLERR)
+        return IO_ERROR;
+    if (ready.events & EPOLLHUP)
+        return IO_EOF;
+    return IO_WOULD_BLOCK;
+}
+
+#endif // FUTURE_IO_H
@@ -0,0 +1,430 @@
+// Required for `sys/socket.h` include to contain `accept4`, `recvmmsg` and `sendmmsg`.
+#define _GNU_SOURCE
+
+#include "future_sockets.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "debug.h"
+#include "executor.h"
+#include "future_io.h"
+#include "mio.h"
+#include "waker.h"
+
+int socket_close(Mio* mio, int fd)
+{
+    mio_unregister(mio, fd); // ENOENT if no future ever had to wait on it.
+    return close(fd);
+}
+
+/**
+ * Waits for `events` (EPOLLIN or EPOLLOUT) on a socket, after its I/O got EAGAIN (or readiness
+ * says it would): clears the readiness reported up to `seen`, and registers `waker`.
+ *
+ * The registration outlives the futures, so an event may have been reported (and its wake gone to
+ * the previous future on the socket) after `seen` but before `waker` was in place: if so, wake it
+ * right away rather than waiting for an edge that already passed.
+ */
+static void socket_wait(Mio* mio, int fd, uint32_t events, MioReadiness seen, Waker waker)
+{
+    mio_clear_readiness(mio, fd, seen, events);
+    mio_register(mio, fd, events | EPOLLET, waker);
+    if (io_readiness(mio_readiness(mio, fd), events) != IO_WOULD_BLOCK)
+        waker_wake(&waker);
+}
+
+/** Spends the budget of one syscall; if it ran out, wakes the future to yield unless `done`
+ *  (a future that can complete instead must not be woken after completing). */
+static bool socket_budget_spend(Waker* waker, bool done)
+{
+    if (executor_budget_spend((Executor*)waker->executor, 1))
+        return true;
+    if (!done)
+        waker_wake(waker);
+    return false;
+}
+
+/**
+ * Passes on the state of a progress call, first detaching the future's waker from its socket if it
+ * is done: the socket stays registered for the next future, and an event of it must not wake (the
+ * memory of) one that completed.
+ */
+static FutureState socket_settle(Mio* mio, int fd, uint32_t events, FutureState state)
+{
+    if (state != FUTURE_PENDING)
+        mio_detach_waker(mio, fd, events); // ENOENT if it never had to wait.
+    return state;
+}
+
+static FutureState socket_fail(Future* base, int* error, int err)
+{
+    *error = err;
+    base->errcode = SOCKET_FUTURE_ERR_IO;
+    return FUTURE_FAILURE;
+}
+
+// ========================= SocketAcceptFuture =========================
+
+static FutureState socket_accept_try(Future* base, Mio* mio, Waker waker)
+{
+    SocketAcceptFuture* self = (SocketAcceptFuture*)base;
+    MioReadiness const ready = mio_readiness(mio, self->listen_fd);
+    if (io_readiness(ready, EPOLLIN) == IO_WOULD_BLOCK) {
+        socket_wait(mio, self->listen_fd, EPOLLIN, ready, waker);
+        return FUTURE_PENDING;
+    }
+
+    while (self->accepted < self->max) {
+        if (!socket_budget_spend(&waker, self->accepted > 0)) {
+            if (self->accepted > 0)
+                break;
+            return FUTURE_PENDING;
+        }
+        int const fd = accept4(self->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        debug("SocketAcceptFuture %p: accept4 %d, errno %s\n", self, fd,
+            strerror(fd == -1 ? errno : 0));
+
+        if (fd >= 0) {
+            self->fds[self->accepted++] = fd;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            if (self->accepted > 0) {
+                mio_clear_readiness(mio, self->listen_fd, ready, EPOLLIN);
+                break;
+            }
+            socket_wait(mio, self->listen_fd, EPOLLIN, ready, waker);
+            return FUTURE_PENDING;
+        } else if (errno != EINTR && errno != ECONNABORTED && errno != EPROTO) {
+            if (self->accepted > 0)
+                break; // The error comes again with the next batch, if it persists.
+            return socket_fail(base, &self->error, errno);
+        }
+    }
+
+    self->base.ok = self->fds;
+    return FUTURE_COMPLETED;
+}
+
+static FutureState socket_accept_progress(Future* base, Mio* mio, Waker waker)
+{
+    SocketAcceptFuture* self = (SocketAcceptFuture*)base;
+    return socket_settle(mio, self->listen_fd, EPOLLIN, socket_accept_try(base, mio, waker));
+}
+
+SocketAcceptFuture socket_accept_future_create(int listen_fd, int* fds, size_t max)
+{
+    return (SocketAcceptFuture) {
+        .base = future_create(socket_accept_progress),
+        .listen_fd = listen_fd,
+        .fds = fds,
+        .max = max,
+        .accepted = 0,
+        .error = 0,
+    };
+}
+
+// ========================= SocketConnectFuture =========================
+
+static FutureState socket_connect_try(Future* base, Mio* mio, Waker waker)
+{
+    SocketConnectFuture* self = (SocketConnectFuture*)base;
+    if (!self->started) {
+        self->started = true;
+        if (self->addrlen > sizeof(self->addr)) // Not copied, see socket_connect_future_create().
+            return socket_fail(base, &self->error, EINVAL);
+        if (connect(self->fd, (struct sockaddr const*)&self->addr, self->addrlen) == 0) {
+            self->base.ok = NULL;
+            return FUTURE_COMPLETED;
+        }
+        debug("SocketConnectFuture %p: connect errno %s\n", self, strerror(errno));
+        if (errno != EINPROGRESS && errno != EINTR) // After EINTR, it goes on in the background.
+            return socket_fail(base, &self->error, errno);
+        // Until registered, Mio knows nothing of the socket (it would report it ready).
+        socket_wait(mio, self->fd, EPOLLOUT, mio_readiness(mio, self->fd), waker);
+        return FUTURE_PENDING;
+    }
+
+    MioReadiness const ready = mio_readiness(mio, self->fd);
+    if (!(ready.events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+        socket_wait(mio, self->fd, EPOLLOUT, ready, waker);
+        return FUTURE_PENDING;
+    }
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(self->fd, SOL_SOCKET, SO_ERROR, &err, &len) == -1)
+        err = errno;
+    if (err != 0)
+        return socket_fail(base, &self->error, err);
+    self->base.ok = NULL;
+    return FUTURE_COMPLETED;
+}
+
+static FutureState socket_connect_progress(Future* base, Mio* mio, Waker waker)
+{
+    SocketConnectFuture* self = (SocketConnectFuture*)base;
+    return socket_settle(mio, self->fd, EPOLLOUT, socket_connect_try(base, mio, waker));
+}
+
+SocketConnectFuture socket_connect_future_create(
+    int fd, struct sockaddr const* addr, socklen_t addrlen)
+{
+    SocketConnectFuture fut = {
+        .base = future_create(socket_connect_progress),
+        .fd = fd,
+        .addrlen = addrlen,
+        .started = false,
+        .error = 0,
+    };
+    if (addrlen <= sizeof(fut.addr))
+        memcpy(&fut.addr, addr, addrlen);
+    return fut;
+}
+
+// ========================= SocketRecvFuture =========================
+
+static FutureState socket_recv_end(SocketRecvFuture* self)
+{
+    if (self->received < self->min) {
+        self->base.errcode = SOCKET_FUTURE_ERR_EOF;
+        return FUTURE_FAILURE;
+    }
+    self->base.ok = self->buffer;
+    return FUTURE_COMPLETED;
+}
+
+static FutureState socket_recv_try(Future* base, Mio* mio, Waker waker)
+{
+    SocketRecvFuture* self = (SocketRecvFuture*)base;
+    MioReadiness const ready = mio_readiness(mio, self->fd);
+    IoReadiness const known = io_readiness(ready, EPOLLIN);
+    if (known == IO_WOULD_BLOCK) {
+        socket_wait(mio, self->fd, EPOLLIN, ready, waker);
+        return FUTURE_PENDING;
+    } else if (known == IO_EOF) {
+        return socket_recv_end(self); // Hung up and drained: recv() would return 0.
+    }
+
+    while (self->received < self->n) {
+        bool const enough = self->received >= self->min;
+        if (!socket_budget_spend(&waker, enough)) {
+            if (enough)
+                break;
+            return FUTURE_PENDING;
+        }
+        ssize_t const got = recv(
+            self->fd, self->buffer + self->received, io_chunk(self->n - self->received), 0);
+        debug("SocketRecvFuture %p: recv %zd, errno %s\n", self, got,
+            strerror(got == -1 ? errno : 0));
+
+        if (got > 0) {
+            self->received += got;
+            io_budget_spend_bytes(&waker, got);
+        } else if (got == 0) {
+            return socket_recv_end(self);
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            if (enough) {
+                mio_clear_readiness(mio, self->fd, ready, EPOLLIN);
+                break;
+            }
+            socket_wait(mio, self->fd, EPOLLIN, ready, waker);
+            return FUTURE_PENDING;
+        } else if (errno != EINTR) {
+            return socket_fail(base, &self->error, errno);
+        }
+    }
+
+    self->base.ok = self->buffer;
+    return FUTURE_COMPLETED;
+}
+
+static FutureState socket_recv_progress(Future* base, Mio* mio, Waker waker)
+{
+    SocketRecvFuture* self = (SocketRecvFuture*)base;
+    return socket_settle(mio, self->fd, EPOLLIN, socket_recv_try(base, mio, waker));
+}
+
+SocketRecvFuture socket_recv_future_create(int fd, uint8_t* buffer, size_t n)
+{
+    return (SocketRecvFuture) {
+        .base = future_create(socket_recv_progress),
+        .fd = fd,
+        .buffer = buffer,
+        .n = n,
+        .min = 1,
+        .received = 0,
+        .error = 0,
+    };
+}
+
+// ========================= SocketSendFuture =========================
+
+static FutureState socket_send_try(Future* base, Mio* mio, Waker waker)
+{
+    SocketSendFuture* self = (SocketSendFuture*)base;
+    MioReadiness const ready = mio_readiness(mio, self->fd);
+    if (io_readiness(ready, EPOLLOUT) == IO_WOULD_BLOCK) {
+        socket_wait(mio, self->fd, EPOLLOUT, ready, waker);
+        return FUTURE_PENDING;
+    }
+    // On IO_ERROR, send() is still made: it tells which error (without SIGPIPE).
+
+    while (self->sent < self->n) {
+        if (!io_budget_spend(&waker))
+            return FUTURE_PENDING;
+        ssize_t const put = send(
+            self->fd, self->buffer + self->sent, io_chunk(self->n - self->sent), MSG_NOSIGNAL);
+        debug("SocketSendFuture %p: send %zd, errno %s\n", self, put,
+            strerror(put == -1 ? errno : 0));
+
+        if (put >= 0) {
+            self->sent += put;
+            io_budget_spend_bytes(&waker, put);
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            socket_wait(mio, self->fd, EPOLLOUT, ready, waker);
+            return FUTURE_PENDING;
+        } else if (errno != EINTR) {
+            return socket_fail(base, &self->error, errno);
+        }
+    }
+
+    self->base.ok = (void*)self->buffer;
+    return FUTURE_COMPLETED;
+}
+
+static FutureState socket_send_progress(Future* base, Mio* mio, Waker waker)
+{
+    SocketSendFuture* self = (SocketSendFuture*)base;
+    return socket_settle(mio, self->fd, EPOLLOUT, socket_send_try(base, mio, waker));
+}
+
+SocketSendFuture socket_send_future_create(int fd, uint8_t const* buffer, size_t n)
+{
+    return (SocketSendFuture) {
+        .base = future_create(socket_send_progress),
+        .fd = fd,
+        .buffer = buffer,
+        .n = n,
+        .sent = 0,
+        .error = 0,
+    };
+}
+
+// ========================= UdpRecvBatchFuture / UdpSendBatchFuture =========================
+
+/** Spends the budget of the bytes moved by a batch (one unit per syscall is spent before it). */
+static void udp_budget_spend_bytes(Waker* waker, struct mmsghdr const* msgs, int n)
+{
+    size_t bytes = 0;
+    for (int i = 0; i < n; i++)
+        bytes += msgs[i].msg_len;
+    io_budget_spend_bytes(waker, bytes);
+}
+
+static FutureState udp_recv_batch_try(Future* base, Mio* mio, Waker waker)
+{
+    UdpBatchFuture* self = (UdpBatchFuture*)base;
+    MioReadiness const ready = mio_readiness(mio, self->fd);
+    if (io_readiness(ready, EPOLLIN) == IO_WOULD_BLOCK) {
+        socket_wait(mio, self->fd, EPOLLIN, ready, waker);
+        return FUTURE_PENDING;
+    }
+
+    while (self->done < self->vlen) {
+        if (!socket_budget_spend(&waker, self->done > 0)) {
+            if (self->done > 0)
+                break;
+            return FUTURE_PENDING;
+        }
+        int const n = recvmmsg(self->fd, self->msgs + self->done, self->vlen - self->done, 0, NULL);
+        debug("UdpRecvBatchFuture %p: recvmmsg %d, errno %s\n", self, n,
+            strerror(n == -1 ? errno : 0));
+
+        if (n > 0) {
+            udp_budget_spend_bytes(&waker, self->msgs + self->done, n);
+            self->done += n;
+        } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (self->done > 0) {
+                mio_clear_readiness(mio, self->fd, ready, EPOLLIN);
+                break;
+            }
+            socket_wait(mio, self->fd, EPOLLIN, ready, waker);
+            return FUTURE_PENDING;
+        } else if (n == -1 && errno != EINTR) {
+            if (self->done > 0)
+                break; // Pending errors (e.g., ECONNREFUSED) come again with the next batch.
+            return socket_fail(base, &self->error, errno);
+        }
+    }
+
+    self->base.ok = self->msgs;
+    return FUTURE_COMPLETED;
+}
+
+static FutureState udp_recv_batch_progress(Future* base, Mio* mio, Waker waker)
+{
+    UdpRecvBatchFuture* self = (UdpRecvBatchFuture*)base;
+    return socket_settle(mio, self->fd, EPOLLIN, udp_recv_batch_try(base, mio, waker));
+}
+
+static FutureState udp_send_batch_try(Future* base, Mio* mio, Waker waker)
+{
+    UdpBatchFuture* self = (UdpBatchFuture*)base;
+    MioReadiness const ready = mio_readiness(mio, self->fd);
+    if (io_readiness(ready, EPOLLOUT) == IO_WOULD_BLOCK) {
+        socket_wait(mio, self->fd, EPOLLOUT, ready, waker);
+        return FUTURE_PENDING;
+    }
+
+    while (self->done < self->vlen) {
+        if (!io_budget_spend(&waker))
+            return FUTURE_PENDING;
+        int const n = sendmmsg(
+            self->fd, self->msgs + self->done, self->vlen - self->done, MSG_NOSIGNAL);
+        debug("UdpSendBatchFuture %p: sendmmsg %d, errno %s\n", self, n,
+            strerror(n == -1 ? errno : 0));
+
+        if (n > 0) {
+            udp_budget_spend_bytes(&waker, self->msgs + self->done, n);
+            self->done += n;
+        } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            socket_wait(mio, self->fd, EPOLLOUT, ready, waker);
+            return FUTURE_PENDING;
+        } else if (n == -1 && errno != EINTR) {
+            return socket_fail(base, &self->error, errno);
+        }
+    }
+
+    self->base.ok = self->msgs;
+    return FUTURE_COMPLETED;
+}
+
+static FutureState udp_send_batch_progress(Future* base, Mio* mio, Waker waker)
+{
+    UdpSendBatchFuture* self = (UdpSendBatchFuture*)base;
+    return socket_settle(mio, self->fd, EPOLLOUT, udp_send_batch_try(base, mio, waker));
+}
+
+static UdpBatchFuture udp_batch_future_create(
+    ProgressFn progress, int fd, struct mmsghdr* msgs, unsigned vlen)
+{
+    return (UdpBatchFuture) {
+        .base = future_create(progress),
+        .fd = fd,
+        .msgs = msgs,
+        .vlen = vlen,
+        .done = 0,
+        .error = 0,
+    };
+}
+
+UdpRecvBatchFuture udp_recv_batch_future_create(int fd, struct mmsghdr* msgs, unsigned vlen)
+{
+    return udp_batch_future_create(udp_recv_batch_progress, fd, msgs, vlen);
+}
+
+UdpSendBatchFuture udp_send_batch_future_create(int fd, struct mmsghdr* msgs, unsigned vlen)
+{
+    return udp_batch_future_create(udp_send_batch_progress, fd, msgs, vlen);
+}
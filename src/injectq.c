@@ -0,0 +1,46 @@
+#include "injectq.h"
+
+void injectq_init(InjectQueue* queue)
+{
+    atomic_init(&queue->stub.inject_next, NULL);
+    atomic_init(&queue->back, &queue->stub);
+    queue->front = &queue->stub;
+}
+
+void injectq_push(InjectQueue* queue, Future* fut)
+{
+    atomic_store_explicit(&fut->inject_next, NULL, memory_order_relaxed);
+    Future* prev = atomic_exchange_explicit(&queue->back, fut, memory_order_acq_rel);
+    // Between these two steps the list is cut after prev: the consumer sees prev as the end.
+    atomic_store_explicit(&prev->inject_next, fut, memory_order_release);
+}
+
+Future* injectq_pop(InjectQueue* queue)
+{
+    Future* front = queue->front;
+    Future* next = atomic_load_explicit(&front->inject_next, memory_order_acquire);
+
+    if (front == &queue->stub) {
+        if (!next)
+            return NULL;
+        queue->front = next;
+        front = next;
+        next = atomic_load_explicit(&front->inject_next, memory_order_acquire);
+    }
+    if (next) {
+        queue->front = next;
+        return front;
+    }
+
+    // front is the last linked future: unless a push is in progress, put the stub behind it,
+    // so that front can be handed out without leaving the list empty.
+    if (front != atomic_load_explicit(&queue->back, memory_order_acquire))
+        return NULL;
+    injectq_push(queue, &queue->stub);
+    next = atomic_load_explicit(&front->inject_next, memory_order_acquire);
+    if (next) {
+        queue->front = next;
+        return front;
+    }
+    return NULL;
+}
@@ -0,0 +1,39 @@
+#ifndef INJECTQ_H
+#define INJECTQ_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "future.h"
+
+/**
+ * An unbounded multi-producer single-consumer FIFO of futures, used internally by the executor
+ * for futures spawned or woken from threads other than its own.
+ *
+ * The queue is intrusive (linked through `Future.inject_next`, a future being in at most one run
+ * queue at a time) and pushing is wait-free: one atomic exchange and one store, no lock, no
+ * allocation. Only one thread at a time may pop.
+ *
+ * See: D. Vyukov, "Intrusive MPSC node-based queue".
+ */
+typedef struct InjectQueue {
+    _Atomic(Future*) back; // Last pushed future (or the stub), for producers.
+    Future* front; // Next future to pop (or the stub), for the consumer.
+    Future stub; // Keeps the list non-empty.
+} InjectQueue;
+
+/** Initializes an empty queue. The queue must not be moved afterwards. */
+void injectq_init(InjectQueue* queue);
+
+/** Appends a future. May be called from any thread. */
+void injectq_push(InjectQueue* queue, Future* fut);
+
+/**
+ * Removes and returns the oldest future, or NULL if there is none.
+ *
+ * NULL is also returned while the oldest push is halfway done (its producer was preempted between
+ * its two steps): the future is only popped once that producer is done.
+ */
+Future* injectq_pop(InjectQueue* queue);
+
+#endif // INJECTQ_H
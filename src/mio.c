@@ -1,26 +1,133 @@
 #include "mio.h"
 
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "debug.h"
 #include "executor.h"
+#include "mio_uring.h"
+#include "timer_wheel.h"
 #include "waker.h"
 
-// Maximum number of events to handle per epoll_wait call.
-#define MAX_EVENTS 64
+// Default initial and maximum number of events handled per epoll_wait call (see MioConfig).
+#define DEFAULT_EVENT_BATCH 64
+#define DEFAULT_MAX_EVENT_BATCH 4096
+
+// The event buffer shrinks (by half) after this many polls in a row filled at most a quarter of it.
+#define SHRINK_AFTER_POLLS 64
+
+// Number of expired timers woken per batch (taken under the lock, woken outside it).
+#define TIMER_WAKE_BATCH 64
+
+// Initial size of the registration table (indexed by fd).
+#define INITIAL_REGISTRATIONS 64
+
+// Size of the io_uring submission queue.
+#define URING_ENTRIES 256
+
+// Tags in the low bits of io_uring user_data. MioOp pointers are at least 4-byte aligned.
+#define URING_TAG_MASK 0x3ull
+#define URING_TAG_OP 0x0ull // A MioOp*.
+#define URING_TAG_POLL 0x1ull // A readiness poll: (generation << 32) | (fd << 2) | tag.
+#define URING_TAG_INTERRUPT 0x2ull // The poll on interrupt_fd.
+#define URING_TAG_IGNORE 0x3ull // Completions nobody waits for (e.g., poll removals).
+
+// Directions of an fd, each with its own waker (see Registration.interests).
+#define INTEREST_READ 0
+#define INTEREST_WRITE 1
+#define N_INTERESTS 2
+
+// Events that belong to the read direction (EPOLLOUT is the only write one).
+#define READ_EVENTS (EPOLLIN | EPOLLPRI | EPOLLRDHUP)
+
+// Mode flags of a registration, as opposed to readiness bits.
+#define MODE_FLAGS (EPOLLET | EPOLLONESHOT)
+
+// Reported events kept in Registration.readiness.
+#define READINESS_EVENTS (READ_EVENTS | EPOLLOUT | EPOLLERR | EPOLLHUP)
+
+/* What one direction of an fd waits for. */
+typedef struct Interest {
+    bool wanted; // Somebody waits in this direction.
+    bool armed; // False once a one-shot interest has fired (until re-registered).
+    uint32_t events; // Readiness bits of this direction, plus mode flags.
+    Waker waker; // No future once detached (see mio_detach_waker): events are only recorded.
+} Interest;
+
+/* The interests in one fd, and what the kernel currently knows about them: a reader and a writer
+ * may wait on the same fd at once, through a single kernel registration watching both. */
+typedef struct Registration {
+    bool registered; // Some direction is wanted.
+    bool added; // epoll: the fd is in the interest list (possibly disabled by EPOLLONESHOT).
+    bool armed; // The kernel watches `events` (false once a one-shot registration fired).
+    uint32_t events; // What the kernel was last asked to watch: the union of armed interests.
+    uint32_t generation; // io_uring: identifies the current poll request of this fd.
+    uint32_t readiness; // Events reported by the kernel and not cleared since (mio_readiness).
+    uint32_t tick; // Counts the reports merged into `readiness`.
+    unsigned waking; // Wakers collected by pollers and not woken yet (see wait_for_wakes).
+    Interest interests[N_INTERESTS];
+} Registration;
 
 struct Mio {
     Executor* executor;
-    int epoll_fd;
-    int registered_count;
-    struct epoll_event events[MAX_EVENTS];
+    MioBackend backend;
+    int epoll_fd; // epoll backend only.
+    Uring uring; // io_uring backends only.
+    int interrupt_fd; // eventfd used by mio_interrupt().
+    atomic_int registered_count; // Registered fds, not counting interrupt_fd.
+    atomic_int ops_in_flight; // io_uring: submitted MioOps not completed yet.
+    atomic_size_t timer_count; // Pending timers (mirrors timer_wheel_size).
+
+    pthread_mutex_t lock; // Protects the fields below (workers may share one Mio).
+    pthread_cond_t wakes_delivered; // Signalled when a Registration.waking drops to 0.
+    Registration* registrations; // Indexed by fd.
+    size_t registrations_size;
+    bool interrupt_armed; // io_uring: whether a poll on interrupt_fd is pending.
+    bool polling; // A thread waits for events (with io_uring, submit right away).
+    uint64_t poll_deadline; // While polling: when the wait times out (UINT64_MAX: never).
+    TimerWheel timers;
+
+    MioStats stats;
+
+    // Event buffer of epoll_wait(), only used by the polling thread (there is one at a time).
+    struct epoll_event* events;
+    size_t event_batch; // Current size of `events`.
+    size_t min_event_batch, max_event_batch; // Bounds of the adaptive size.
+    unsigned sparse_polls; // Polls in a row that used at most a quarter of `events`.
 };
 
-Mio* mio_create(Executor* executor)
+static int epoll_init(Mio* mio)
+{
+    mio->epoll_fd = epoll_create1(0);
+    if (mio->epoll_fd == -1) {
+        perror("epoll_create1");
+        return -1;
+    }
+    struct epoll_event ev = {
+        .events = EPOLLIN,
+        .data.fd = mio->interrupt_fd,
+    };
+    if (epoll_ctl(mio->epoll_fd, EPOLL_CTL_ADD, mio->interrupt_fd, &ev) == -1) {
+        perror("epoll_ctl");
+        close(mio->epoll_fd);
+        return -1;
+    }
+    return 0;
+}
+
+Mio* mio_create_with_config(Executor* executor, MioConfig const* config)
 {
     debug("Creating Mio\n");
 
@@ -29,79 +136,965 @@ Mio* mio_create(Executor* executor)
         exit(1);
 
     mio->executor = executor;
-    mio->registered_count = 0;
-    mio->epoll_fd = epoll_create1(0);
-    if (mio->epoll_fd == -1) {
-        perror("epoll_create1");
+    atomic_init(&mio->registered_count, 0);
+    atomic_init(&mio->ops_in_flight, 0);
+    atomic_init(&mio->timer_count, 0);
+    mio->interrupt_armed = false;
+    mio->polling = false;
+    mio->poll_deadline = UINT64_MAX;
+    timer_wheel_init(&mio->timers, mio_now_ms());
+    mio->epoll_fd = -1;
+
+    mio->interrupt_fd = eventfd(0, EFD_NONBLOCK);
+    if (mio->interrupt_fd == -1) {
+        perror("eventfd");
         free(mio);
         exit(1);
     }
+
+    mio->min_event_batch = config->event_batch ? config->event_batch : DEFAULT_EVENT_BATCH;
+    mio->max_event_batch
+        = config->max_event_batch ? config->max_event_batch : DEFAULT_MAX_EVENT_BATCH;
+    if (mio->max_event_batch < mio->min_event_batch)
+        mio->max_event_batch = mio->min_event_batch;
+    mio->event_batch = mio->min_event_batch;
+    mio->sparse_polls = 0;
+    mio->events = NULL;
+
+    mio->backend = config->backend;
+    if (mio->backend != MIO_BACKEND_EPOLL
+        && uring_init(&mio->uring, URING_ENTRIES, mio->backend == MIO_BACKEND_IO_URING_SQPOLL)
+            != 0) {
+        debug("io_uring unavailable (%s), falling back to epoll\n", strerror(errno));
+        mio->backend = MIO_BACKEND_EPOLL;
+    }
+    if (mio->backend == MIO_BACKEND_EPOLL && epoll_init(mio) != 0) {
+        close(mio->interrupt_fd);
+        free(mio);
+        exit(1);
+    }
+    if (mio->backend == MIO_BACKEND_EPOLL) {
+        mio->events = malloc(mio->event_batch * sizeof(struct epoll_event));
+        if (!mio->events)
+            exit(1);
+    }
+
+    mio->registrations = calloc(INITIAL_REGISTRATIONS, sizeof(Registration));
+    if (!mio->registrations)
+        exit(1);
+    mio->registrations_size = INITIAL_REGISTRATIONS;
+    pthread_mutex_init(&mio->lock, NULL);
+    pthread_cond_init(&mio->wakes_delivered, NULL);
+    mio->stats = (MioStats) { 0 };
+    if (mio->backend == MIO_BACKEND_EPOLL)
+        mio->stats.event_batch = mio->event_batch;
     return mio;
 }
 
+Mio* mio_create(Executor* executor)
+{
+    MioConfig config = { .backend = MIO_BACKEND_EPOLL };
+    return mio_create_with_config(executor, &config);
+}
+
 void mio_destroy(Mio* mio) {
     debug("Destroying Mio\n");
     
-    close(mio->epoll_fd);
+    if (mio->backend == MIO_BACKEND_EPOLL)
+        close(mio->epoll_fd);
+    else
+        uring_destroy(&mio->uring);
+    close(mio->interrupt_fd);
+    pthread_mutex_destroy(&mio->lock);
+    pthread_cond_destroy(&mio->wakes_delivered);
+    free(mio->registrations);
+    free(mio->events);
     free(mio);
 }
 
-int mio_register(Mio* mio, int fd, uint32_t events, Waker waker)
+MioBackend mio_backend(Mio* mio)
+{
+    return mio->backend;
+}
+
+bool mio_supports_submission(Mio* mio)
+{
+    return mio->backend != MIO_BACKEND_EPOLL;
+}
+
+/* Returns the table entry for fd, growing the table if needed (NULL if out of memory). */
+static Registration* registration_get(Mio* mio, int fd)
+{
+    if ((size_t)fd >= mio->registrations_size) {
+        size_t size = mio->registrations_size;
+        while (size <= (size_t)fd)
+            size *= 2;
+        Registration* table = realloc(mio->registrations, size * sizeof(Registration));
+        if (!table)
+            return NULL;
+        memset(table + mio->registrations_size, 0,
+            (size - mio->registrations_size) * sizeof(Registration));
+        mio->registrations = table;
+        mio->registrations_size = size;
+    }
+    return &mio->registrations[fd];
+}
+
+static inline bool same_waker(Waker const* a, Waker const* b)
 {
-    debug("Registering (in Mio = %p) fd = %d", mio, fd);
+    return a->executor == b->executor && a->future == b->future && a->slot == b->slot;
+}
+
+/* Returns a free submission entry, flushing the queue if it is full. Called under mio->lock. */
+static struct io_uring_sqe* uring_sqe(Mio* mio)
+{
+    struct io_uring_sqe* sqe = uring_get_sqe(&mio->uring);
+    if (!sqe && uring_submit(&mio->uring) == 0)
+        sqe = uring_get_sqe(&mio->uring);
+    if (sqe)
+        mio->stats.submissions++;
+    return sqe;
+}
+
+/* Entries are normally submitted in batch by the next mio_poll(). If a thread is already
+ * waiting there (or the kernel polls the queue itself), they have to be handed over now.
+ * Called under mio->lock. */
+static void uring_kick(Mio* mio)
+{
+    if (mio->polling || mio->uring.sqpoll)
+        uring_submit(&mio->uring);
+}
+
+static inline uint64_t poll_user_data(int fd, uint32_t generation)
+{
+    return ((uint64_t)generation << 32) | ((uint64_t)fd << 2) | URING_TAG_POLL;
+}
+
+/* Queues the removal of the pending poll of a registration. Called under mio->lock. */
+static int uring_poll_remove(Mio* mio, int fd, Registration* reg)
+{
+    struct io_uring_sqe* sqe = uring_sqe(mio);
+    if (!sqe)
+        return -1;
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = poll_user_data(fd, reg->generation);
+    sqe->user_data = URING_TAG_IGNORE;
+    return 0;
+}
+
+/* io_uring has no persistent interest list: every registration is a one-shot poll request,
+ * re-armed by the next mio_register() after it fires. Called under mio->lock. */
+static int uring_register(Mio* mio, int fd, Registration* reg, uint32_t events)
+{
+    if (reg->armed && uring_poll_remove(mio, fd, reg) != 0)
+        return -1;
 
+    struct io_uring_sqe* sqe = uring_sqe(mio);
+    if (!sqe) {
+        errno = EBUSY;
+        return -1;
+    }
+    reg->generation++;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = events & ~MODE_FLAGS;
+    sqe->user_data = poll_user_data(fd, reg->generation);
+    uring_kick(mio);
+    return 0;
+}
+
+static int epoll_register(Mio* mio, int fd, Registration* reg, uint32_t events)
+{
     struct epoll_event ev = {
         .events = events,
-        .data.ptr = waker.future,
+        .data.fd = fd,
     };
+    int op = reg->added ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    mio->stats.ctl_syscalls++;
+    int ret = epoll_ctl(mio->epoll_fd, op, fd, &ev);
+    if (ret == -1 && op == EPOLL_CTL_MOD && errno == ENOENT) {
+        // The fd was closed (which removes it from epoll) and its number reused.
+        mio->stats.ctl_syscalls++;
+        ret = epoll_ctl(mio->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    }
+    if (ret == 0)
+        reg->added = true;
+    return ret;
+}
 
-    if (epoll_ctl(mio->epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
-        perror("epoll_ctl");
+/* Makes the kernel stop watching fd, if it does. Called under mio->lock. */
+static int kernel_forget(Mio* mio, int fd, Registration* reg)
+{
+    int ret = 0;
+    if (mio->backend == MIO_BACKEND_EPOLL) {
+        if (reg->added) {
+            reg->added = false;
+            mio->stats.ctl_syscalls++;
+            ret = epoll_ctl(mio->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+            // EBADF/ENOENT: the fd was closed already, which removed it from epoll anyway.
+            if (ret == -1 && (errno == EBADF || errno == ENOENT))
+                ret = 0;
+        }
+    } else if (reg->armed) {
+        ret = uring_poll_remove(mio, fd, reg);
+        reg->generation++; // Whatever the pending poll reports now is stale.
+        uring_kick(mio);
+        if (ret == -1)
+            errno = EBUSY;
+    }
+    reg->armed = false;
+    reg->events = 0;
+    return ret;
+}
+
+/* Brings the kernel in line with the armed interests of fd: a single epoll_ctl() (or poll
+ * request) watches both directions, and nothing is done if it already watches exactly them.
+ * Called under mio->lock. */
+static int registration_sync(Mio* mio, int fd, Registration* reg)
+{
+    uint32_t events = 0;
+    for (int i = 0; i < N_INTERESTS; i++)
+        if (reg->interests[i].wanted && reg->interests[i].armed)
+            events |= reg->interests[i].events;
+
+    if (events == 0) // Only fired one-shot interests are left: watch nothing until re-armed.
+        return reg->armed ? kernel_forget(mio, fd, reg) : 0;
+    if (reg->armed && reg->events == events)
+        return 0;
+
+    int const ret = mio->backend == MIO_BACKEND_EPOLL ? epoll_register(mio, fd, reg, events)
+                                                      : uring_register(mio, fd, reg, events);
+    if (ret == -1)
+        return -1;
+    reg->armed = true;
+    reg->events = events;
+    return 0;
+}
+
+/* Returns the directions (INTEREST_* bits) that `events` asks for. */
+static unsigned interest_mask(uint32_t events)
+{
+    unsigned mask = 0;
+    if (events & READ_EVENTS)
+        mask |= 1u << INTEREST_READ;
+    if (events & EPOLLOUT)
+        mask |= 1u << INTEREST_WRITE;
+    return mask ? mask : 1u << INTEREST_READ; // E.g., only EPOLLERR: count it as reading.
+}
+
+/* Returns the readiness bits of direction `i`. */
+static uint32_t direction_events(int i)
+{
+    return i == INTEREST_WRITE ? EPOLLOUT : READ_EVENTS;
+}
+
+/* Returns the part of `events` that concerns direction `i` (mode flags apply to both). */
+static uint32_t interest_events(uint32_t events, int i)
+{
+    return i == INTEREST_WRITE ? events & (EPOLLOUT | MODE_FLAGS) : events & ~EPOLLOUT;
+}
+
+/* Collects in `wakers` those of the interests of fd that `revents` (as reported by the kernel)
+ * concerns, returning how many, and disarms the ones that fire only once. If the kernel disabled
+ * the whole registration, re-arms it for the interests still waiting. Called under mio->lock. */
+static int registration_collect(Mio* mio, int fd, Registration* reg, uint32_t revents,
+    Waker wakers[N_INTERESTS])
+{
+    bool const uring = mio->backend != MIO_BACKEND_EPOLL;
+    reg->readiness |= revents & READINESS_EVENTS;
+    reg->tick++;
+
+    int n = 0;
+    unsigned woken = 0;
+    for (int i = 0; i < N_INTERESTS; i++) {
+        Interest* interest = &reg->interests[i];
+        // Errors and hang-ups concern both directions.
+        if (!interest->wanted || !interest->armed
+            || !(revents & (interest->events | EPOLLERR | EPOLLHUP)))
+            continue;
+        woken |= 1u << i;
+        if (interest->waker.future && (n == 0 || !same_waker(&wakers[0], &interest->waker)))
+            wakers[n++] = interest->waker;
+        if (uring || (interest->events & EPOLLONESHOT))
+            interest->armed = false; // The next mio_register re-arms it.
+    }
+
+    if (!uring && !(reg->events & EPOLLONESHOT))
+        return n; // The kernel keeps watching.
+    reg->armed = false;
+    if (registration_sync(mio, fd, reg) == 0)
+        return n;
+    // Could not re-arm: wake the other interests too, so that they register again.
+    perror("mio: re-arm");
+    for (int i = 0; i < N_INTERESTS; i++) {
+        Interest* interest = &reg->interests[i];
+        if (!interest->wanted || !interest->armed || (woken & (1u << i)))
+            continue;
+        if (interest->waker.future && (n == 0 || !same_waker(&wakers[0], &interest->waker)))
+            wakers[n++] = interest->waker;
+        interest->armed = false;
+    }
+    return n;
+}
+
+/* registration_collect(), counting the wakers collected as in flight until deliver_wakes() has
+ * woken them (which the caller must call once it released mio->lock). */
+static int registration_fire(Mio* mio, int fd, Registration* reg, uint32_t revents,
+    Waker wakers[N_INTERESTS])
+{
+    int const n = registration_collect(mio, fd, reg, revents, wakers);
+    if (n > 0)
+        reg->waking++;
+    return n;
+}
+
+/* Wakes the wakers registration_fire() collected from fd, then lets the threads waiting for
+ * them in wait_for_wakes() go on. Called without mio->lock. */
+static void deliver_wakes(Mio* mio, int fd, Waker wakers[N_INTERESTS], int n)
+{
+    if (n == 0)
+        return;
+    for (int j = 0; j < n; j++) {
+        debug_print_waker(&wakers[j]);
+        waker_wake(&wakers[j]);
+    }
+    pthread_mutex_lock(&mio->lock);
+    if (--mio->registrations[fd].waking == 0)
+        pthread_cond_broadcast(&mio->wakes_delivered);
+    pthread_mutex_unlock(&mio->lock);
+}
+
+/* Waits until the wakers a poller collected from fd (before the caller dropped them) are woken:
+ * once the caller returns, the futures they belong to may complete and be freed. Called under
+ * mio->lock (released while waiting). */
+static void wait_for_wakes(Mio* mio, int fd)
+{
+    while (mio->registrations[fd].waking > 0)
+        pthread_cond_wait(&mio->wakes_delivered, &mio->lock);
+}
+
+int mio_register(Mio* mio, int fd, uint32_t events, Waker waker)
+{
+    debug("Registering (in Mio = %p) fd = %d\n", mio, fd);
+
+    if (fd < 0) {
+        errno = EBADF;
+        return -1;
+    }
+
+    pthread_mutex_lock(&mio->lock);
+    mio->stats.registers++;
+
+    Registration* reg = registration_get(mio, fd);
+    if (!reg) {
+        pthread_mutex_unlock(&mio->lock);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    Interest saved[N_INTERESTS];
+    memcpy(saved, reg->interests, sizeof(saved));
+    unsigned const mask = interest_mask(events);
+    for (int i = 0; i < N_INTERESTS; i++) {
+        if (mask & (1u << i)) {
+            reg->interests[i] = (Interest) {
+                .events = interest_events(events, i),
+                .wanted = true,
+                .armed = true,
+                .waker = waker,
+            };
+        }
+    }
+
+    // Only a change of what the kernel watches costs a syscall (not a change of waker).
+    if (registration_sync(mio, fd, reg) == -1) {
+        int err = errno;
+        memcpy(reg->interests, saved, sizeof(saved));
+        pthread_mutex_unlock(&mio->lock);
+        perror("mio_register");
+        errno = err;
+        return -1;
+    }
+
+    // A direction starts out not ready: it is registered once its I/O would block.
+    for (int i = 0; i < N_INTERESTS; i++)
+        if ((mask & (1u << i)) && !saved[i].wanted)
+            reg->readiness &= ~direction_events(i);
+    if (!reg->registered)
+        atomic_fetch_add(&mio->registered_count, 1);
+    reg->registered = true;
+    pthread_mutex_unlock(&mio->lock);
+
+    return 0;
+}
+
+/* Drops the interests of fd in the directions of `mask` (INTEREST_* bits); the kernel
+ * registration goes with the last of them. */
+static int unregister_interests(Mio* mio, int fd, unsigned mask)
+{
+    debug("Unregistering (from Mio = %p) fd = %d\n", mio, fd);
+
+    pthread_mutex_lock(&mio->lock);
+    mio->stats.unregisters++;
+
+    Registration* reg = fd >= 0 && (size_t)fd < mio->registrations_size
+        ? &mio->registrations[fd]
+        : NULL;
+    bool found = false;
+    for (int i = 0; reg && i < N_INTERESTS; i++) {
+        if ((mask & (1u << i)) && reg->interests[i].wanted) {
+            reg->interests[i] = (Interest) { .wanted = false };
+            found = true;
+        }
+    }
+    if (!found) {
+        // Never registered (or already unregistered): no need to ask the kernel.
+        pthread_mutex_unlock(&mio->lock);
+        errno = ENOENT;
+        return -1;
+    }
+
+    int ret;
+    if (reg->interests[INTEREST_READ].wanted || reg->interests[INTEREST_WRITE].wanted) {
+        ret = registration_sync(mio, fd, reg); // The other direction stays watched.
+    } else {
+        reg->registered = false;
+        reg->readiness = 0;
+        reg->tick++;
+        atomic_fetch_sub(&mio->registered_count, 1);
+        ret = kernel_forget(mio, fd, reg);
+    }
+    int const err = errno;
+    wait_for_wakes(mio, fd);
+    pthread_mutex_unlock(&mio->lock);
+
+    if (ret == -1) {
+        errno = err;
+        perror("mio_unregister");
         return -1;
     }
-    mio->registered_count++;
 
     return 0;
 }
 
 int mio_unregister(Mio* mio, int fd)
 {
-    debug("Unregistering (from Mio = %p) fd = %d", mio, fd);
+    return unregister_interests(mio, fd, (1u << INTEREST_READ) | (1u << INTEREST_WRITE));
+}
 
-    if (epoll_ctl(mio->epoll_fd, EPOLL_CTL_DEL, fd, NULL) == -1) {
-        perror("epoll_ctl");
+int mio_unregister_events(Mio* mio, int fd, uint32_t events)
+{
+    return unregister_interests(mio, fd, interest_mask(events));
+}
+
+int mio_detach_waker(Mio* mio, int fd, uint32_t events)
+{
+    pthread_mutex_lock(&mio->lock);
+    Registration* reg = fd >= 0 && (size_t)fd < mio->registrations_size
+        ? &mio->registrations[fd]
+        : NULL;
+    unsigned const mask = interest_mask(events);
+    bool found = false;
+    for (int i = 0; reg && i < N_INTERESTS; i++) {
+        if ((mask & (1u << i)) && reg->interests[i].wanted) {
+            reg->interests[i].waker = (Waker) { 0 };
+            found = true;
+        }
+    }
+    if (found)
+        wait_for_wakes(mio, fd);
+    pthread_mutex_unlock(&mio->lock);
+    if (!found) {
+        errno = ENOENT;
         return -1;
     }
+    return 0;
+}
 
-    mio->registered_count--;
+MioReadiness mio_readiness(Mio* mio, int fd)
+{
+    MioReadiness ready = { .events = EPOLLIN | EPOLLOUT, .tick = 0 };
+    pthread_mutex_lock(&mio->lock);
+    if (fd >= 0 && (size_t)fd < mio->registrations_size && mio->registrations[fd].registered) {
+        Registration const* reg = &mio->registrations[fd];
+        ready.events = reg->readiness;
+        ready.tick = reg->tick;
+        // Nothing is known of a direction nobody waits for: report it ready, to be tried.
+        for (int i = 0; i < N_INTERESTS; i++)
+            if (!reg->interests[i].wanted)
+                ready.events |= direction_events(i) & (EPOLLIN | EPOLLOUT);
+    }
+    pthread_mutex_unlock(&mio->lock);
+    return ready;
+}
 
+void mio_clear_readiness(Mio* mio, int fd, MioReadiness seen, uint32_t events)
+{
+    pthread_mutex_lock(&mio->lock);
+    if (fd >= 0 && (size_t)fd < mio->registrations_size && mio->registrations[fd].registered
+        && mio->registrations[fd].tick == seen.tick)
+        mio->registrations[fd].readiness &= ~events;
+    pthread_mutex_unlock(&mio->lock);
+}
+
+
+/* Queues a read or write of a MioOp. */
+static int mio_submit(
+    Mio* mio, uint8_t opcode, MioOp* op, int fd, void* buf, size_t len, Waker waker)
+{
+    if (mio->backend == MIO_BACKEND_EPOLL) {
+        errno = ENOTSUP;
+        return -1;
+    }
+
+    pthread_mutex_lock(&mio->lock);
+    struct io_uring_sqe* sqe = uring_sqe(mio);
+    if (!sqe) {
+        pthread_mutex_unlock(&mio->lock);
+        errno = EBUSY;
+        return -1;
+    }
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = len > UINT32_MAX ? UINT32_MAX : (uint32_t)len;
+    sqe->off = (uint64_t)-1; // Use (and advance) the file position, as read()/write() do.
+    sqe->user_data = (uint64_t)(uintptr_t)op | URING_TAG_OP;
+
+    op->waker = waker;
+    op->in_flight = true;
+    atomic_store_explicit(&op->done, false, memory_order_relaxed);
+    atomic_store_explicit(&op->completed, false, memory_order_relaxed);
+    atomic_fetch_add(&mio->ops_in_flight, 1);
+    uring_kick(mio);
+    pthread_mutex_unlock(&mio->lock);
     return 0;
 }
 
-/* Poll for events on the registered file descriptors.
- * This function blocks until at least one event is available.
- * When an event is available, the corresponding future is woken up.
- */
-void mio_poll(Mio* mio)
+int mio_submit_read(Mio* mio, MioOp* op, int fd, void* buf, size_t len, Waker waker)
 {
-    debug("Mio (%p) polling\n", mio);
+    debug("Submitting read (in Mio = %p) fd = %d, len = %zu\n", mio, fd, len);
+    return mio_submit(mio, IORING_OP_READ, op, fd, buf, len, waker);
+}
 
-    if (mio->registered_count == 0) {
-        debug("No registered events\n");
+int mio_submit_write(Mio* mio, MioOp* op, int fd, const void* buf, size_t len, Waker waker)
+{
+    debug("Submitting write (in Mio = %p) fd = %d, len = %zu\n", mio, fd, len);
+    return mio_submit(mio, IORING_OP_WRITE, op, fd, (void*)buf, len, waker);
+}
+
+bool mio_op_done(MioOp* op)
+{
+    if (atomic_load_explicit(&op->done, memory_order_acquire))
+        return true;
+    if (!atomic_load_explicit(&op->completed, memory_order_acquire))
+        return false;
+    // Only as long as waker_wake() takes on the polling thread.
+    while (!atomic_load_explicit(&op->done, memory_order_acquire))
+        sched_yield();
+    return true;
+}
+
+int mio_op_consume(MioOp* op)
+{
+    op->in_flight = false;
+    return op->result;
+}
+
+uint64_t mio_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int mio_register_timer(Mio* mio, MioTimer* timer, uint64_t deadline_ms, Waker waker)
+{
+    debug("Registering timer (in Mio = %p) deadline = %llu\n", mio, (unsigned long long)deadline_ms);
+
+    pthread_mutex_lock(&mio->lock);
+    mio->stats.timers++;
+
+    if (atomic_load_explicit(&timer->pending, memory_order_relaxed)) {
+        if (timer->deadline == deadline_ms) {
+            // Already armed for that deadline (e.g., the future was progressed for another reason).
+            timer->waker = waker;
+            pthread_mutex_unlock(&mio->lock);
+            return 0;
+        }
+        timer_wheel_remove(&mio->timers, timer);
+    }
+    timer->deadline = deadline_ms;
+    timer->waker = waker;
+    atomic_store_explicit(&timer->pending, true, memory_order_relaxed);
+    timer_wheel_insert(&mio->timers, timer);
+    atomic_store(&mio->timer_count, timer_wheel_size(&mio->timers));
+
+    // A thread waiting in mio_poll() computed its timeout without this timer: cut the wait short.
+    bool const interrupt = mio->polling && deadline_ms < mio->poll_deadline;
+    if (interrupt)
+        mio->poll_deadline = deadline_ms;
+    pthread_mutex_unlock(&mio->lock);
+
+    if (interrupt)
+        mio_interrupt(mio);
+    return 0;
+}
+
+/* Waits until no poller is invoking the timer's waker (only as long as waker_wake() takes). */
+static void wait_for_timer_wake(MioTimer* timer)
+{
+    while (atomic_load_explicit(&timer->waking, memory_order_acquire) > 0)
+        sched_yield();
+}
+
+int mio_cancel_timer(Mio* mio, MioTimer* timer)
+{
+    debug("Cancelling timer (in Mio = %p)\n", mio);
+
+    pthread_mutex_lock(&mio->lock);
+    bool const pending = atomic_load_explicit(&timer->pending, memory_order_relaxed);
+    if (pending) {
+        timer_wheel_remove(&mio->timers, timer);
+        atomic_store_explicit(&timer->pending, false, memory_order_relaxed);
+        atomic_store(&mio->timer_count, timer_wheel_size(&mio->timers));
+    }
+    pthread_mutex_unlock(&mio->lock);
+
+    // Pending or not, an earlier expiry of it may still be waking.
+    wait_for_timer_wake(timer);
+    if (!pending) {
+        errno = ENOENT;
+        return -1;
+    }
+    return 0;
+}
+
+bool mio_timer_pending(MioTimer* timer)
+{
+    if (atomic_load_explicit(&timer->pending, memory_order_acquire))
+        return true;
+    wait_for_timer_wake(timer);
+    return false;
+}
+
+/* Advances the timer wheel to the current time and wakes the expired timers.
+ * Returns how many fired. Wakers are invoked outside the lock, a batch at a time; each timer's
+ * `waking` count covers its wake, as the future may complete once it is 0 and `pending` is not. */
+static size_t fire_timers(Mio* mio)
+{
+    if (atomic_load(&mio->timer_count) == 0)
+        return 0;
+
+    MioTimer* timers[TIMER_WAKE_BATCH];
+    Waker wakers[TIMER_WAKE_BATCH];
+    size_t fired = 0;
+    for (;;) {
+        size_t n = 0;
+        pthread_mutex_lock(&mio->lock);
+        timer_wheel_advance(&mio->timers, mio_now_ms());
+        MioTimer* timer;
+        while (n < TIMER_WAKE_BATCH && (timer = timer_wheel_pop_expired(&mio->timers)) != NULL) {
+            atomic_fetch_add_explicit(&timer->waking, 1, memory_order_relaxed);
+            atomic_store_explicit(&timer->pending, false, memory_order_release);
+            timers[n] = timer;
+            wakers[n++] = timer->waker;
+        }
+        atomic_store(&mio->timer_count, timer_wheel_size(&mio->timers));
+        mio->stats.timers_fired += n;
+        pthread_mutex_unlock(&mio->lock);
+
+        for (size_t i = 0; i < n; i++) {
+            debug_print_waker(&wakers[i]);
+            waker_wake(&wakers[i]);
+            atomic_fetch_sub_explicit(&timers[i]->waking, 1, memory_order_release);
+        }
+        fired += n;
+        if (n < TIMER_WAKE_BATCH)
+            return fired;
+    }
+}
+
+/* Starts a wait: returns its timeout in milliseconds (-1 for none), given the pending timers.
+ * Called under mio->lock. */
+static int begin_wait(Mio* mio)
+{
+    mio->polling = true;
+    mio->stats.polls++;
+    mio->poll_deadline = timer_wheel_next_expiration(&mio->timers);
+    if (mio->poll_deadline == UINT64_MAX)
+        return -1;
+    uint64_t const now = mio_now_ms();
+    if (mio->poll_deadline <= now)
+        return 0;
+    uint64_t const timeout = mio->poll_deadline - now;
+    return timeout > INT_MAX ? INT_MAX : (int)timeout;
+}
+
+/* Ends a wait started by begin_wait(). Called under mio->lock. */
+static void end_wait(Mio* mio)
+{
+    mio->polling = false;
+    mio->poll_deadline = UINT64_MAX;
+}
+
+/* Starts a poll: a wait if `block`, otherwise a check for what is ready right away.
+ * Returns its timeout. Called under mio->lock. */
+static int begin_poll(Mio* mio, bool block)
+{
+    if (block)
+        return begin_wait(mio);
+    mio->stats.nonblocking_polls++;
+    return 0;
+}
+
+/* Ends a poll started by begin_poll(). Called under mio->lock. */
+static void end_poll(Mio* mio, bool block)
+{
+    if (block)
+        end_wait(mio);
+}
+
+void mio_interrupt(Mio* mio)
+{
+    uint64_t one = 1;
+    if (write(mio->interrupt_fd, &one, sizeof(one)) == -1) {
+        perror("mio_interrupt");
+    }
+}
+
+void mio_stats(Mio* mio, MioStats* stats)
+{
+    pthread_mutex_lock(&mio->lock);
+    *stats = mio->stats;
+    pthread_mutex_unlock(&mio->lock);
+}
+
+/* Drains the eventfd written by mio_interrupt(). */
+static void consume_interrupt(Mio* mio)
+{
+    uint64_t count;
+    if (read(mio->interrupt_fd, &count, sizeof(count)) == -1 && errno != EAGAIN) {
+        perror("mio_interrupt");
+    }
+}
+
+/* Accounts for the events returned by one poll. Called under mio->lock. */
+static void count_events(Mio* mio, uint64_t n)
+{
+    mio->stats.events += n;
+    if (n > mio->stats.max_events_per_poll)
+        mio->stats.max_events_per_poll = n;
+}
+
+/* Adapts the epoll event buffer to the last poll, which returned n events: a full buffer means
+ * more events may be waiting, so it doubles; after many polls that barely used it, it halves.
+ * Called by the polling thread, after handling the events (they live in the buffer). */
+static void resize_events(Mio* mio, int n)
+{
+    size_t size = mio->event_batch;
+    if (n >= 0 && (size_t)n == size && size < mio->max_event_batch) {
+        size = size * 2 < mio->max_event_batch ? size * 2 : mio->max_event_batch;
+        mio->sparse_polls = 0;
+    } else if (size > mio->min_event_batch && (size_t)n <= size / 4) {
+        if (++mio->sparse_polls < SHRINK_AFTER_POLLS)
+            return;
+        size = size / 2 > mio->min_event_batch ? size / 2 : mio->min_event_batch;
+        mio->sparse_polls = 0;
+    } else {
+        mio->sparse_polls = 0;
         return;
     }
+    if (size == mio->event_batch)
+        return;
+
+    struct epoll_event* events = realloc(mio->events, size * sizeof(struct epoll_event));
+    if (!events)
+        return; // Keep the current buffer.
+    pthread_mutex_lock(&mio->lock);
+    if (size > mio->event_batch)
+        mio->stats.event_batch_grows++;
+    else
+        mio->stats.event_batch_shrinks++;
+    mio->stats.event_batch = size;
+    pthread_mutex_unlock(&mio->lock);
+    mio->events = events;
+    mio->event_batch = size;
+}
+
+/* Waits with epoll_wait() (or only checks, if not `block`); returns the number of events
+ * handled. */
+static int epoll_poll(Mio* mio, bool block)
+{
+    pthread_mutex_lock(&mio->lock);
+    int const timeout = begin_poll(mio, block);
+    pthread_mutex_unlock(&mio->lock);
+
+    int n = epoll_wait(mio->epoll_fd, mio->events, mio->event_batch, timeout);
+    int const err = errno;
+
+    pthread_mutex_lock(&mio->lock);
+    end_poll(mio, block);
+    if (n > 0)
+        count_events(mio, n);
+    if (n >= 0 && (size_t)n == mio->event_batch)
+        mio->stats.full_polls++;
+    pthread_mutex_unlock(&mio->lock);
 
-    int n = epoll_wait(mio->epoll_fd, mio->events, MAX_EVENTS, -1);
     if (n == -1) {
+        if (err == EINTR)
+            return 0;
+        errno = err;
         perror("epoll_wait");
         mio_destroy(mio);
         exit(1);
     }
+
     for (int i = 0; i < n; i++) {
-        // Wake up the future associated with the event.
-        Future* future = (Future*)mio->events[i].data.ptr;
-        Waker waker = {mio->executor, future};
-        debug_print_waker(&waker);
-        waker_wake(&waker);
+        int fd = mio->events[i].data.fd;
+        if (fd == mio->interrupt_fd) {
+            // Interrupted by mio_interrupt(): just consume the notification.
+            consume_interrupt(mio);
+            continue;
+        }
+
+        // Wake up the futures waiting for these events (unless unregistered in the meantime).
+        Waker wakers[N_INTERESTS];
+        pthread_mutex_lock(&mio->lock);
+        Registration* reg = &mio->registrations[fd];
+        int const n_wakers
+            = reg->registered ? registration_fire(mio, fd, reg, mio->events[i].events, wakers) : 0;
+        pthread_mutex_unlock(&mio->lock);
+        deliver_wakes(mio, fd, wakers, n_wakers);
+    }
+    if (block)
+        resize_events(mio, n); // Zero-timeout checks say little about the load.
+    return n;
+}
+
+/* Handles one io_uring completion. */
+static void uring_complete(Mio* mio, uint64_t user_data, int32_t res)
+{
+    switch (user_data & URING_TAG_MASK) {
+    case URING_TAG_OP: {
+        MioOp* op = (MioOp*)(uintptr_t)user_data;
+        // Wake the future before setting `done`: once it sees `done`, it may complete and be
+        // freed (with the op). Until then, mio_op_done() waits for the wake.
+        op->result = res;
+        atomic_fetch_sub(&mio->ops_in_flight, 1);
+        atomic_store_explicit(&op->completed, true, memory_order_release);
+        debug_print_waker(&op->waker);
+        waker_wake(&op->waker);
+        atomic_store_explicit(&op->done, true, memory_order_release);
+        break;
+    }
+    case URING_TAG_POLL: {
+        int fd = (int)((user_data & 0xffffffffull) >> 2);
+        uint32_t generation = (uint32_t)(user_data >> 32);
+        Waker wakers[N_INTERESTS];
+        int n_wakers = 0;
+        pthread_mutex_lock(&mio->lock);
+        Registration* reg = &mio->registrations[fd];
+        if (reg->registered && reg->generation == generation) // Else removed or replaced meanwhile.
+            n_wakers = registration_fire(mio, fd, reg, res < 0 ? EPOLLERR : (uint32_t)res, wakers);
+        pthread_mutex_unlock(&mio->lock);
+        deliver_wakes(mio, fd, wakers, n_wakers);
+        break;
+    }
+    case URING_TAG_INTERRUPT:
+        consume_interrupt(mio);
+        pthread_mutex_lock(&mio->lock);
+        mio->interrupt_armed = false;
+        pthread_mutex_unlock(&mio->lock);
+        break;
+    default:
+        break;
     }
-}
\ No newline at end of file
+}
+
+/* Submits the queued entries and waits with io_uring_enter() (or only reaps the completions
+ * already there, if not `block`); returns the number of completions handled. */
+static int uring_poll(Mio* mio, bool block)
+{
+    pthread_mutex_lock(&mio->lock);
+    if (!mio->interrupt_armed) {
+        struct io_uring_sqe* sqe = uring_sqe(mio);
+        if (sqe) {
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = mio->interrupt_fd;
+            sqe->poll32_events = EPOLLIN;
+            sqe->user_data = URING_TAG_INTERRUPT;
+            mio->interrupt_armed = true;
+        }
+    }
+    // Everything queued since the last poll goes to the kernel in the same syscall as the wait.
+    unsigned to_submit = uring_flush(&mio->uring);
+    int const timeout = begin_poll(mio, block);
+    pthread_mutex_unlock(&mio->lock);
+
+    int ret = uring_enter(&mio->uring, to_submit, block, timeout);
+
+    pthread_mutex_lock(&mio->lock);
+    end_poll(mio, block);
+    pthread_mutex_unlock(&mio->lock);
+    if (ret == -1) {
+        perror("io_uring_enter");
+        mio_destroy(mio);
+        exit(1);
+    }
+
+    unsigned n = 0;
+    struct io_uring_cqe* cqe;
+    while ((cqe = uring_peek_cqe(&mio->uring)) != NULL) {
+        uint64_t user_data = cqe->user_data;
+        int32_t res = cqe->res;
+        uring_cqe_seen(&mio->uring);
+        uring_complete(mio, user_data, res);
+        n++;
+    }
+
+    pthread_mutex_lock(&mio->lock);
+    count_events(mio, n);
+    pthread_mutex_unlock(&mio->lock);
+    return n;
+}
+
+/* Whether there is anything at all to wait for. */
+static bool has_interest(Mio* mio)
+{
+    return atomic_load(&mio->registered_count) > 0 || atomic_load(&mio->ops_in_flight) > 0
+        || atomic_load(&mio->timer_count) > 0;
+}
+
+/* Poll for events on the registered file descriptors.
+ * This function blocks until at least one event is available or timer expires.
+ * When an event is available, the corresponding future is woken up.
+ */
+bool mio_poll(Mio* mio)
+{
+    debug("Mio (%p) polling\n", mio);
+
+    if (!has_interest(mio)) {
+        debug("No registered events\n");
+        return false;
+    }
+
+    // A timeout may only mean that a slot of the timer wheel has to cascade: wait again then.
+    for (;;) {
+        int const events
+            = mio->backend == MIO_BACKEND_EPOLL ? epoll_poll(mio, true) : uring_poll(mio, true);
+        size_t const fired = fire_timers(mio);
+        if (events > 0 || fired > 0 || !has_interest(mio))
+            return true;
+    }
+}
+
+int mio_poll_nonblocking(Mio* mio)
+{
+    if (!has_interest(mio))
+        return -1;
+    int const events
+        = mio->backend == MIO_BACKEND_EPOLL ? epoll_poll(mio, false) : uring_poll(mio, false);
+    return events + (int)fire_timers(mio);
+}
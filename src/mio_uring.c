@@ -0,0 +1,173 @@
+#include "mio_uring.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params* params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int sys_io_uring_enter(
+    int fd, unsigned to_submit, unsigned min_complete, unsigned flags, void* arg, size_t argsz)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+int uring_init(Uring* ring, unsigned entries, bool sqpoll)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    if (sqpoll) {
+        params.flags |= IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = 100; // ms
+    }
+
+    int fd = sys_io_uring_setup(entries, &params);
+    if (fd == -1)
+        return -1;
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_NODROP)
+        || !(params.features & IORING_FEAT_EXT_ARG)) {
+        // Too old a kernel: let the caller fall back to epoll.
+        close(fd);
+        errno = ENOSYS;
+        return -1;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = fd;
+    ring->sqpoll = sqpoll;
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sq_ring_size = sq_size > cq_size ? sq_size : cq_size;
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED)
+        goto fail_fd;
+    ring->cq_ring = ring->sq_ring;
+    ring->cq_ring_size = ring->sq_ring_size;
+
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+        IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED)
+        goto fail_sq;
+
+    char* sq = ring->sq_ring;
+    ring->sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_flags = (unsigned*)(sq + params.sq_off.flags);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring->sq_mask = *(unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_entries = *(unsigned*)(sq + params.sq_off.ring_entries);
+
+    char* cq = ring->cq_ring;
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = *(unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return 0;
+
+fail_sq:
+    munmap(ring->sq_ring, ring->sq_ring_size);
+fail_fd:
+    close(fd);
+    return -1;
+}
+
+void uring_destroy(Uring* ring)
+{
+    munmap(ring->sqes, ring->sqes_size);
+    munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->fd);
+}
+
+struct io_uring_sqe* uring_get_sqe(Uring* ring)
+{
+    unsigned const head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    unsigned const tail = *ring->sq_tail + ring->sq_unsubmitted;
+    if (tail - head >= ring->sq_entries)
+        return NULL;
+
+    // The entry only becomes visible to the kernel when the tail is published, on the next
+    // submit, so the caller can fill it in after this returns.
+    unsigned const index = tail & ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    ring->sq_unsubmitted++;
+    return sqe;
+}
+
+unsigned uring_flush(Uring* ring)
+{
+    unsigned const published = ring->sq_unsubmitted;
+    if (published > 0) {
+        __atomic_store_n(ring->sq_tail, *ring->sq_tail + published, __ATOMIC_RELEASE);
+        ring->sq_unsubmitted = 0;
+    }
+    return published;
+}
+
+int uring_enter(Uring* ring, unsigned to_submit, bool wait, int timeout_ms)
+{
+    unsigned flags = 0;
+    if (ring->sqpoll) {
+        // The kernel thread picks up the entries; only wake it if it went to sleep.
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(ring->sq_flags, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP)
+            flags |= IORING_ENTER_SQ_WAKEUP;
+        else if (!wait)
+            return 0;
+        to_submit = 0;
+    } else if (to_submit == 0 && !wait) {
+        return 0;
+    }
+
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    void* argp = NULL;
+    size_t argsz = 0;
+    if (wait) {
+        flags |= IORING_ENTER_GETEVENTS;
+        if (timeout_ms >= 0) {
+            ts.tv_sec = timeout_ms / 1000;
+            ts.tv_nsec = (long long)(timeout_ms % 1000) * 1000000;
+            memset(&arg, 0, sizeof(arg));
+            arg.ts = (uint64_t)(uintptr_t)&ts;
+            flags |= IORING_ENTER_EXT_ARG;
+            argp = &arg;
+            argsz = sizeof(arg);
+        }
+    }
+
+    int ret = sys_io_uring_enter(ring->fd, to_submit, wait ? 1 : 0, flags, argp, argsz);
+    if (ret >= 0 || errno == ETIME || errno == EINTR)
+        return 0;
+    if (errno == EAGAIN || errno == EBUSY)
+        return 0; // Completion queue backlog: the caller reaps, then tries again.
+    return -1;
+}
+
+int uring_submit(Uring* ring)
+{
+    return uring_enter(ring, uring_flush(ring), false, 0);
+}
+
+struct io_uring_cqe* uring_peek_cqe(Uring* ring)
+{
+    unsigned const head = *ring->cq_head;
+    unsigned const tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    if (head == tail)
+        return NULL;
+    return &ring->cqes[head & ring->cq_mask];
+}
+
+void uring_cqe_seen(Uring* ring)
+{
+    __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
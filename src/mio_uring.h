@@ -0,0 +1,72 @@
+#ifndef MIO_URING_H
+#define MIO_URING_H
+
+#include <linux/io_uring.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A minimal io_uring wrapper over the raw syscalls, used internally by Mio's io_uring backend.
+ *
+ * It is not thread-safe: Mio serializes access to the submission queue with its own lock, and
+ * only the polling thread consumes the completion queue.
+ */
+typedef struct Uring {
+    int fd;
+    bool sqpoll; // A kernel thread consumes the submission queue (IORING_SETUP_SQPOLL).
+
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_flags;
+    unsigned* sq_array;
+    unsigned sq_mask;
+    unsigned sq_entries;
+    unsigned sq_unsubmitted; // Entries queued since the last io_uring_enter().
+    struct io_uring_sqe* sqes;
+
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe* cqes;
+
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring; // Same as sq_ring with IORING_FEAT_SINGLE_MMAP.
+    size_t cq_ring_size;
+    size_t sqes_size;
+} Uring;
+
+/** Sets up a ring. Returns 0 on success, -1 (with errno) if the kernel does not support it. */
+int uring_init(Uring* ring, unsigned entries, bool sqpoll);
+
+/** Tears down the ring. */
+void uring_destroy(Uring* ring);
+
+/** Returns a zeroed submission entry to fill, or NULL if the submission queue is full. */
+struct io_uring_sqe* uring_get_sqe(Uring* ring);
+
+/**
+ * Publishes the entries filled since the last call, returning how many there are.
+ * Must be serialized with `uring_get_sqe`.
+ */
+unsigned uring_flush(Uring* ring);
+
+/**
+ * Calls io_uring_enter: submits `to_submit` published entries and, if `wait`, waits for at least
+ * one completion or until `timeout_ms` elapses (-1 for no timeout). Does not touch the submission
+ * queue itself, so it may run concurrently with `uring_get_sqe` on another thread.
+ * Returns 0 on success (including a timeout or a signal), -1 (with errno) on failure.
+ */
+int uring_enter(Uring* ring, unsigned to_submit, bool wait, int timeout_ms);
+
+/** Publishes and submits the filled entries, without waiting. */
+int uring_submit(Uring* ring);
+
+/** Returns the oldest unconsumed completion, or NULL. Release it with `uring_cqe_seen`. */
+struct io_uring_cqe* uring_peek_cqe(Uring* ring);
+
+/** Marks the completion returned by `uring_peek_cqe` as consumed. */
+void uring_cqe_seen(Uring* ring);
+
+#endif // MIO_URING_H
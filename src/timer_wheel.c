@@ -0,0 +1,161 @@
+#include "timer_wheel.h"
+
+#include <string.h>
+
+#define BITS_PER_LEVEL 6 // log2(TIMER_WHEEL_SLOTS)
+
+// Deadlines further than this from the current time all land in the last level.
+#define MAX_SPAN ((uint64_t)1 << (BITS_PER_LEVEL * TIMER_WHEEL_LEVELS))
+
+// `slot` of a timer in the expired list (slots are numbered level * TIMER_WHEEL_SLOTS + slot).
+#define SLOT_EXPIRED (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS)
+
+static inline uint64_t slot_range(int level) { return (uint64_t)1 << (BITS_PER_LEVEL * level); }
+
+static inline uint64_t level_range(int level) { return slot_range(level + 1); }
+
+/* The deadline of a timer, relative to the start of the wheel. */
+static inline uint64_t relative_deadline(TimerWheel const* wheel, MioTimer const* timer)
+{
+    return timer->deadline > wheel->start ? timer->deadline - wheel->start : 0;
+}
+
+static void list_push(MioTimer** head, MioTimer* timer)
+{
+    timer->next = *head;
+    if (timer->next)
+        timer->next->prev_next = &timer->next;
+    *head = timer;
+    timer->prev_next = head;
+}
+
+static void list_unlink(TimerWheel* wheel, MioTimer* timer)
+{
+    *timer->prev_next = timer->next;
+    if (timer->next)
+        timer->next->prev_next = timer->prev_next;
+    if (timer->slot != SLOT_EXPIRED) {
+        int const level = timer->slot / TIMER_WHEEL_SLOTS;
+        int const slot = timer->slot % TIMER_WHEEL_SLOTS;
+        if (!wheel->slots[level][slot])
+            wheel->occupied[level] &= ~((uint64_t)1 << slot);
+    }
+    timer->next = NULL;
+    timer->prev_next = NULL;
+}
+
+/* The level for a deadline: the one of the highest base-64 digit in which it differs from now. */
+static int level_for(uint64_t elapsed, uint64_t when)
+{
+    uint64_t masked = (elapsed ^ when) | (TIMER_WHEEL_SLOTS - 1);
+    if (masked >= MAX_SPAN)
+        masked = MAX_SPAN - 1;
+    int const significant = 63 - __builtin_clzll(masked);
+    return significant / BITS_PER_LEVEL;
+}
+
+/* Links a timer into the slot for its deadline (relative), or into the expired list. */
+static void place(TimerWheel* wheel, MioTimer* timer, uint64_t when)
+{
+    if (when <= wheel->elapsed) {
+        timer->slot = SLOT_EXPIRED;
+        list_push(&wheel->expired, timer);
+        return;
+    }
+    int const level = level_for(wheel->elapsed, when);
+    int const slot = (when >> (BITS_PER_LEVEL * level)) % TIMER_WHEEL_SLOTS;
+    timer->slot = level * TIMER_WHEEL_SLOTS + slot;
+    list_push(&wheel->slots[level][slot], timer);
+    wheel->occupied[level] |= (uint64_t)1 << slot;
+}
+
+/* Finds the first non-empty slot to be reached, and the (relative) time it is reached at.
+ * Slots of lower levels are always reached before those of higher levels. */
+static bool next_slot(TimerWheel const* wheel, int* level_out, int* slot_out, uint64_t* when_out)
+{
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        uint64_t const occupied = wheel->occupied[level];
+        if (!occupied)
+            continue;
+
+        // The first occupied slot at or after the current one, wrapping around.
+        int const now_slot = (wheel->elapsed >> (BITS_PER_LEVEL * level)) % TIMER_WHEEL_SLOTS;
+        uint64_t const rotated
+            = now_slot ? (occupied >> now_slot) | (occupied << (TIMER_WHEEL_SLOTS - now_slot))
+                       : occupied;
+        int const slot = (__builtin_ctzll(rotated) + now_slot) % TIMER_WHEEL_SLOTS;
+
+        uint64_t const level_start = wheel->elapsed & ~(level_range(level) - 1);
+        uint64_t when = level_start + slot * slot_range(level);
+        if (when <= wheel->elapsed)
+            when += level_range(level); // Wrapped around: only for far deadlines in the last level.
+
+        *level_out = level;
+        *slot_out = slot;
+        *when_out = when;
+        return true;
+    }
+    return false;
+}
+
+void timer_wheel_init(TimerWheel* wheel, uint64_t now)
+{
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->start = now;
+}
+
+void timer_wheel_insert(TimerWheel* wheel, MioTimer* timer)
+{
+    place(wheel, timer, relative_deadline(wheel, timer));
+    wheel->count++;
+}
+
+void timer_wheel_remove(TimerWheel* wheel, MioTimer* timer)
+{
+    list_unlink(wheel, timer);
+    wheel->count--;
+}
+
+uint64_t timer_wheel_next_expiration(TimerWheel const* wheel)
+{
+    if (wheel->expired)
+        return wheel->start + wheel->elapsed;
+    int level, slot;
+    uint64_t when;
+    if (!next_slot(wheel, &level, &slot, &when))
+        return UINT64_MAX;
+    return wheel->start + when;
+}
+
+void timer_wheel_advance(TimerWheel* wheel, uint64_t now)
+{
+    now = now > wheel->start ? now - wheel->start : 0;
+    if (now <= wheel->elapsed)
+        return;
+
+    int level, slot;
+    uint64_t when;
+    while (next_slot(wheel, &level, &slot, &when) && when <= now) {
+        // Move to the time the slot is reached, and empty it: its timers either expired, or go
+        // to the lower level slots matching their deadline.
+        wheel->elapsed = when;
+        MioTimer* timer = wheel->slots[level][slot];
+        wheel->slots[level][slot] = NULL;
+        wheel->occupied[level] &= ~((uint64_t)1 << slot);
+        while (timer) {
+            MioTimer* next = timer->next;
+            uint64_t const deadline = relative_deadline(wheel, timer);
+            place(wheel, timer, deadline <= now ? wheel->elapsed : deadline);
+            timer = next;
+        }
+    }
+    wheel->elapsed = now;
+}
+
+MioTimer* timer_wheel_pop_expired(TimerWheel* wheel)
+{
+    MioTimer* timer = wheel->expired;
+    if (timer)
+        timer_wheel_remove(wheel, timer);
+    return timer;
+}
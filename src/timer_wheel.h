@@ -0,0 +1,59 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mio.h"
+
+#define TIMER_WHEEL_LEVELS 6
+#define TIMER_WHEEL_SLOTS 64 // Per level, so level `l` slots span 64^l milliseconds.
+
+/**
+ * A hierarchical timer wheel of MioTimers with a millisecond tick, used internally by Mio.
+ *
+ * Level 0 has one slot per millisecond of the current 64 ms, level 1 one slot per 64 ms of the
+ * current 4096 ms, and so on: six levels reach about two years ahead (further deadlines are kept
+ * in the last level and re-inserted when it comes around). Timers are intrusive doubly linked
+ * lists, so insertion and removal take constant time; per-level occupancy bitmaps make finding
+ * the next expiration take constant time too. When time reaches a slot of a higher level, its
+ * timers cascade down to lower levels (or expire).
+ *
+ * Times are absolute (CLOCK_MONOTONIC milliseconds) in the interface and relative to the
+ * creation of the wheel inside. Not thread-safe: Mio protects it with its lock.
+ */
+typedef struct TimerWheel {
+    uint64_t start; // Absolute time of `elapsed == 0`.
+    uint64_t elapsed; // Time (relative to start) up to which the wheel has been advanced.
+    uint64_t occupied[TIMER_WHEEL_LEVELS]; // Bit `s` set iff slots[level][s] is not empty.
+    MioTimer* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    MioTimer* expired; // Timers past their deadline, not yet popped.
+    size_t count; // Timers in the wheel, including expired ones.
+} TimerWheel;
+
+/** Initializes an empty wheel whose clock starts at `now`. */
+void timer_wheel_init(TimerWheel* wheel, uint64_t now);
+
+/** Adds a timer (whose `deadline` is set and which is not in the wheel). */
+void timer_wheel_insert(TimerWheel* wheel, MioTimer* timer);
+
+/** Removes a timer that is in the wheel (expired or not). */
+void timer_wheel_remove(TimerWheel* wheel, MioTimer* timer);
+
+/**
+ * Returns the absolute time by which the wheel must be advanced again (UINT64_MAX if empty).
+ *
+ * That is not always a deadline: reaching a slot of a higher level only cascades its timers.
+ */
+uint64_t timer_wheel_next_expiration(TimerWheel const* wheel);
+
+/** Advances the wheel to `now`, moving the timers whose deadline passed to the expired list. */
+void timer_wheel_advance(TimerWheel* wheel, uint64_t now);
+
+/** Removes and returns an expired timer, or NULL if there is none. */
+MioTimer* timer_wheel_pop_expired(TimerWheel* wheel);
+
+static inline size_t timer_wheel_size(TimerWheel const* wheel) { return wheel->count; }
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,158 @@
+// The trace ring is only compiled in with DEBUG_LOG=RING (see debug.h).
+#include "debug.h"
+
+#ifdef DEBUG_TRACE_RING
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Number of records in the ring (a power of two).
+#define TRACE_RING_RECORDS 8192
+
+// Maximum length of one message (longer ones are truncated).
+#define TRACE_RECORD_SIZE 120
+
+// How long the flushing thread sleeps when the ring is empty.
+#define TRACE_FLUSH_INTERVAL_NS 5000000
+
+/* A message slot. `seq` tells whose turn it is (a bounded MPMC queue, as in Vyukov's design):
+ * equal to the position when free for the producer of that position, to position + 1 once
+ * written, and advanced by one lap when read. */
+typedef struct Record {
+    atomic_size_t seq;
+    unsigned len;
+    char text[TRACE_RECORD_SIZE];
+} Record;
+
+static Record records[TRACE_RING_RECORDS];
+static atomic_size_t tail; // Next position to write.
+static size_t head; // Next position to read (only under flush_lock).
+static atomic_size_t dropped; // Messages lost because the ring was full.
+
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t flush_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t flusher;
+static atomic_bool stopping;
+static pid_t owner; // Process running the flusher (forked children only flush at exit).
+
+static void write_all(char const* buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(STDERR_FILENO, buf, len);
+        if (n <= 0)
+            return;
+        buf += n;
+        len -= n;
+    }
+}
+
+/* Writes out the messages in the ring, in batches. Returns whether there were any. */
+static bool drain(void)
+{
+    char batch[1 << 16];
+    size_t used = 0;
+    bool any = false;
+
+    pthread_mutex_lock(&flush_lock);
+    size_t lost = atomic_exchange(&dropped, 0);
+    if (lost > 0)
+        used = snprintf(batch, sizeof(batch), "[trace ring full: %zu messages dropped]\n", lost);
+    for (;;) {
+        Record* record = &records[head & (TRACE_RING_RECORDS - 1)];
+        if (atomic_load_explicit(&record->seq, memory_order_acquire) != head + 1)
+            break; // Not written yet.
+        if (used + record->len > sizeof(batch)) {
+            write_all(batch, used);
+            used = 0;
+        }
+        memcpy(batch + used, record->text, record->len);
+        used += record->len;
+        atomic_store_explicit(&record->seq, head + TRACE_RING_RECORDS, memory_order_release);
+        head++;
+        any = true;
+    }
+    write_all(batch, used);
+    pthread_mutex_unlock(&flush_lock);
+    return any;
+}
+
+static void* flusher_main(void* arg)
+{
+    struct timespec interval = { .tv_sec = 0, .tv_nsec = TRACE_FLUSH_INTERVAL_NS };
+    while (!atomic_load(&stopping)) {
+        if (!drain())
+            nanosleep(&interval, NULL);
+    }
+    return NULL;
+}
+
+static void stop_at_exit(void)
+{
+    if (getpid() == owner) {
+        atomic_store(&stopping, true);
+        pthread_join(flusher, NULL);
+    }
+    drain();
+}
+
+/* A forked child has no flusher, and may have inherited the lock held by the parent's. */
+static void after_fork_in_child(void)
+{
+    pthread_mutex_init(&flush_lock, NULL);
+    owner = 0;
+}
+
+static void start(void)
+{
+    for (size_t i = 0; i < TRACE_RING_RECORDS; i++)
+        atomic_init(&records[i].seq, i);
+    owner = getpid();
+    if (pthread_create(&flusher, NULL, flusher_main, NULL) != 0)
+        owner = 0; // No flusher: messages are written at exit (or by trace_ring_flush) only.
+    pthread_atfork(NULL, NULL, after_fork_in_child);
+    atexit(stop_at_exit);
+}
+
+void trace_ring_vwrite(const char* fmt, va_list args)
+{
+    pthread_once(&once, start);
+
+    size_t pos = atomic_load_explicit(&tail, memory_order_relaxed);
+    Record* record;
+    for (;;) {
+        record = &records[pos & (TRACE_RING_RECORDS - 1)];
+        size_t seq = atomic_load_explicit(&record->seq, memory_order_acquire);
+        if (seq == pos) {
+            if (atomic_compare_exchange_weak_explicit(
+                    &tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (seq < pos) {
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            return; // Full: the record still holds a message of the previous lap.
+        } else {
+            pos = atomic_load_explicit(&tail, memory_order_relaxed);
+        }
+    }
+
+    int len = vsnprintf(record->text, TRACE_RECORD_SIZE, fmt, args);
+    if (len < 0)
+        len = 0;
+    if (len >= TRACE_RECORD_SIZE) {
+        len = TRACE_RECORD_SIZE - 1;
+        record->text[len - 1] = '\n'; // Truncated: keep messages on separate lines.
+    }
+    record->len = len;
+    atomic_store_explicit(&record->seq, pos + 1, memory_order_release);
+}
+
+void trace_ring_flush(void)
+{
+    drain();
+}
+
+#endif // DEBUG_TRACE_RING
@@ -1,7 +1,13 @@
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 #include "executor.h"
+#include "future.h"
 #include "future_examples.h"
 
 void* increment(void* arg)
@@ -10,8 +16,289 @@ void* increment(void* arg)
     return (void*)(number + 1);
 }
 
+/** A future that yields once before completing. */
+static FutureState yield_once_progress(Future* fut, Mio* mio, Waker waker)
+{
+    if (fut->ok == NULL) {
+        fut->ok = fut;
+        waker_wake(&waker);
+        return FUTURE_PENDING;
+    }
+    return FUTURE_COMPLETED;
+}
+
+static void test_queue_growth_and_cap(void)
+{
+    // Many more futures than the initial queue capacity: none of them may be dropped.
+    enum { N = 5000 };
+    static Future futs[N];
+    Executor* executor = executor_create(0);
+    for (int i = 0; i < N; ++i) {
+        futs[i] = future_create(yield_once_progress);
+        assert(executor_spawn(executor, &futs[i]) == 0);
+    }
+    executor_run(executor);
+    for (int i = 0; i < N; ++i)
+        assert(!futs[i].is_active && futs[i].ok == &futs[i]);
+    executor_destroy(executor);
+
+    // With a cap, spawning beyond it is rejected, but wakes of active futures still go through.
+    executor = executor_create(2);
+    for (int i = 0; i < 3; ++i)
+        futs[i] = future_create(yield_once_progress);
+    assert(executor_spawn(executor, &futs[0]) == 0);
+    assert(executor_spawn(executor, &futs[1]) == 0);
+    assert(executor_spawn(executor, &futs[2]) == -1 && errno == EAGAIN);
+    assert(!futs[2].is_active);
+    executor_run(executor);
+    assert(futs[0].ok == &futs[0] && futs[1].ok == &futs[1] && futs[2].ok == NULL);
+    assert(executor_spawn(executor, &futs[2]) == 0);
+    executor_run(executor);
+    assert(futs[2].ok == &futs[2]);
+    executor_destroy(executor);
+}
+
+/** Makes a pipe ready on its first progress, then yields until a read of it is done. */
+typedef struct BusyFuture {
+    Future base;
+    int write_fd;
+    PipeReadFuture* read;
+    int yields;
+} BusyFuture;
+
+static FutureState busy_progress(Future* base, Mio* mio, Waker waker)
+{
+    BusyFuture* self = (BusyFuture*)base;
+    if (self->yields == 0) {
+        ssize_t written = write(self->write_fd, "x", 1);
+        assert(written == 1);
+    }
+    if (!self->read->base.is_active || self->yields == 100000)
+        return FUTURE_COMPLETED;
+    self->yields++;
+    waker_wake(&waker);
+    return FUTURE_PENDING;
+}
+
+/** Returns how many times a busy future yielded before a pipe read it made ready completed. */
+static int yields_before_read(size_t poll_interval)
+{
+    int fds[2];
+    assert(pipe(fds) == 0);
+    assert(fcntl(fds[0], F_SETFL, O_NONBLOCK) == 0);
+    uint8_t byte;
+    PipeReadFuture read = pipe_read_future_create(fds[0], &byte, 1);
+    BusyFuture busy = { .base = future_create(busy_progress), .write_fd = fds[1], .read = &read };
+
+    ExecutorConfig config = executor_config_default();
+    config.poll_interval = poll_interval;
+    Executor* executor = executor_create_with_config(&config);
+    executor_spawn(executor, (Future*)&read); // Registers, the pipe being empty yet.
+    executor_spawn(executor, (Future*)&busy);
+    executor_run(executor);
+    executor_destroy(executor);
+    assert(byte == 'x');
+    close(fds[0]);
+    close(fds[1]);
+    return busy.yields;
+}
+
+static void test_poll_interval(void)
+{
+    // Readiness is noticed while futures keep the queue busy, not only once it runs dry.
+    int yields = yields_before_read(16);
+    assert(yields > 0 && yields <= 16);
+    assert(yields_before_read(0) == 100000);
+}
+
+static atomic_int conns_done;
+
+/** Stands for a connection: yields once, then counts itself done. */
+static FutureState conn_progress(Future* fut, Mio* mio, Waker waker)
+{
+    if (yield_once_progress(fut, mio, waker) == FUTURE_PENDING)
+        return FUTURE_PENDING;
+    atomic_fetch_add(&conns_done, 1);
+    return FUTURE_COMPLETED;
+}
+
+/** Spawns `arg` rounds of 100 connection futures allocated from the executor. */
+static FutureState acceptor_progress(Future* fut, Mio* mio, Waker waker)
+{
+    Executor* executor = (Executor*)waker.executor;
+    intptr_t* rounds_left = (intptr_t*)&fut->arg;
+    if ((*rounds_left)-- == 0)
+        return FUTURE_COMPLETED;
+    for (int i = 0; i < 100; i++) {
+        Future* conn = executor_alloc_future(executor, sizeof(Future));
+        assert(conn);
+        *conn = future_create(conn_progress);
+        assert(executor_spawn(executor, conn) == 0);
+    }
+    waker_wake(&waker);
+    return FUTURE_PENDING;
+}
+
+static void test_future_arena(size_t n_threads)
+{
+    ExecutorConfig config = executor_config_default();
+    config.n_threads = n_threads;
+    config.future_arena_size = 1 << 20;
+    Executor* executor = executor_create_with_config(&config);
+    errno = 0;
+    assert(!executor_alloc_future(executor, EXECUTOR_MAX_FUTURE_SIZE + 1) && errno == EINVAL);
+
+    // A completed future's block is released, and reused for the next one.
+    Future* fut = executor_alloc_future(executor, sizeof(ApplyFuture));
+    assert(fut && (uintptr_t)fut % 64 == 0);
+    *(ApplyFuture*)fut = apply_future_create(increment);
+    assert(executor_spawn(executor, fut) == 0);
+    executor_run(executor);
+    if (n_threads == 0) {
+        // (Multi-threaded, it went to the cache of whichever worker completed it.)
+        Future* again = executor_alloc_future(executor, sizeof(ApplyFuture));
+        assert(again == fut);
+        executor_free_future(executor, again);
+    }
+
+    // Far more futures than fit in the arena at once: they only fit thanks to the releases.
+    Future acceptor = future_create(acceptor_progress);
+    acceptor.arg = (void*)200;
+    atomic_store(&conns_done, 0);
+    assert(executor_spawn(executor, &acceptor) == 0);
+    executor_run(executor);
+    assert(atomic_load(&conns_done) == 200 * 100);
+    executor_destroy(executor);
+}
+
+/** Fails on its first progress, with errcode `arg`. */
+static FutureState fail_progress(Future* fut, Mio* mio, Waker waker)
+{
+    fut->errcode = (int)(intptr_t)fut->arg;
+    return FUTURE_FAILURE;
+}
+
+typedef struct Outcomes {
+    int completed;
+    int failed;
+    intptr_t sum; // Of results and error codes.
+    int destroyed;
+} Outcomes;
+
+static void record_outcome(Future* fut, FutureState state, void* ctx)
+{
+    Outcomes* outcomes = ctx;
+    assert(!fut->is_active);
+    if (state == FUTURE_COMPLETED) {
+        outcomes->completed++;
+        outcomes->sum += (intptr_t)fut->ok;
+    } else {
+        assert(state == FUTURE_FAILURE);
+        outcomes->failed++;
+        outcomes->sum += fut->errcode;
+    }
+}
+
+static void free_future(Future* fut, void* ctx)
+{
+    ((Outcomes*)ctx)->destroyed++;
+    free(fut);
+}
+
+static void test_spawn_detached(void)
+{
+    Outcomes outcomes = { 0 };
+    Executor* executor = executor_create(0);
+    for (intptr_t i = 0; i < 100; i++) {
+        // malloc()ed futures, freed by the destructor: no leak (as checked by the sanitizers).
+        ApplyFuture* fut = malloc(sizeof(ApplyFuture));
+        *fut = apply_future_create(increment);
+        fut->base.arg = (void*)i;
+        assert(executor_spawn_detached(executor, &fut->base, record_outcome, free_future, &outcomes)
+            == 0);
+        // Futures from the executor's arena, with no destructor.
+        Future* failing = executor_alloc_future(executor, sizeof(Future));
+        *failing = future_create(fail_progress);
+        failing->arg = (void*)i;
+        assert(executor_spawn_detached(executor, failing, record_outcome, NULL, &outcomes) == 0);
+    }
+    executor_run(executor);
+    assert(outcomes.completed == 100 && outcomes.failed == 100 && outcomes.destroyed == 100);
+    assert(outcomes.sum == 2 * (99 * 100 / 2) + 100);
+
+    Future fut = future_create(yield_once_progress);
+    assert(executor_spawn(executor, &fut) == 0);
+    assert(executor_spawn_detached(executor, &fut, record_outcome, NULL, &outcomes) == -1);
+    assert(errno == EINVAL);
+    executor_run(executor);
+    assert(outcomes.completed == 100);
+    executor_destroy(executor);
+}
+
+/** Counts its progress calls, yielding until another future is done. */
+typedef struct LightFuture {
+    Future base;
+    Future const* other;
+    int turns; // Progress calls while the other future was still active.
+} LightFuture;
+
+static FutureState light_progress(Future* base, Mio* mio, Waker waker)
+{
+    LightFuture* self = (LightFuture*)base;
+    if (!self->other->is_active)
+        return FUTURE_COMPLETED;
+    self->turns++;
+    waker_wake(&waker);
+    return FUTURE_PENDING;
+}
+
+/** Reads 1 MiB from /dev/zero (never dry: no EAGAIN to stop at) next to a light future; returns
+ * how many turns that one got meanwhile. */
+static int light_turns_during_read(size_t task_budget, size_t* budget_exhausted)
+{
+    enum { N = 1 << 20 };
+    static uint8_t buffer[N];
+    int fd = open("/dev/zero", O_RDONLY | O_NONBLOCK);
+    assert(fd != -1);
+    PipeReadFuture heavy = pipe_read_future_create(fd, buffer, N);
+    LightFuture light = { .base = future_create(light_progress), .other = &heavy.base };
+
+    ExecutorConfig config = executor_config_default();
+    config.task_budget = task_budget;
+    Executor* executor = executor_create_with_config(&config);
+    executor_spawn(executor, (Future*)&heavy);
+    executor_spawn(executor, (Future*)&light);
+    executor_run(executor);
+    assert(heavy.base.errcode == FUTURE_SUCCESS && heavy.read_so_far == N);
+    ExecutorStats stats;
+    executor_stats(executor, &stats);
+    *budget_exhausted = stats.budget_exhausted;
+    executor_destroy(executor);
+    close(fd);
+    return light.turns;
+}
+
+static void test_task_budget(void)
+{
+    // 1 MiB in 64 KiB reads costs 16 * (1 + 16) units: with 128 per progress call, the reader
+    // yields after 8 reads, letting the light future run in between.
+    size_t exhausted;
+    int turns = light_turns_during_read(128, &exhausted);
+    assert(exhausted == 1 && turns == 1);
+    // Unlimited: the whole read happens in its first progress call.
+    turns = light_turns_during_read(0, &exhausted);
+    assert(exhausted == 0 && turns == 0);
+}
+
 int main()
 {
+    test_queue_growth_and_cap();
+    test_poll_interval();
+    test_future_arena(0);
+    test_future_arena(2);
+    test_spawn_detached();
+    test_task_budget();
+
     // A trivial example where we just call a function as a future, in the executor.
 
     Executor* executor = executor_create(1024);
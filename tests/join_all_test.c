@@ -0,0 +1,208 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "err.h"
+#include "executor.h"
+#include "future.h"
+#include "future_combinators.h"
+#include "future_examples.h"
+#include "utils.h"
+
+#define N_CHILDREN 1000
+#define N_PIPES 50
+
+/** A future that stays pending until released by a DriverFuture, counting its progress calls. */
+typedef struct ManualFuture {
+    Future base;
+    Waker waker;
+    bool released;
+    bool fail;
+    int progressed;
+} ManualFuture;
+
+static FutureState manual_progress(Future* base, Mio* mio, Waker waker)
+{
+    ManualFuture* self = (ManualFuture*)base;
+    self->progressed++;
+    self->waker = waker;
+    if (!self->released)
+        return FUTURE_PENDING;
+    if (self->fail) {
+        base->errcode = 42;
+        return FUTURE_FAILURE;
+    }
+    base->ok = self;
+    return FUTURE_COMPLETED;
+}
+
+static ManualFuture manual_future_create(void)
+{
+    return (ManualFuture) { .base = future_create(manual_progress) };
+}
+
+/** Releases the given ManualFutures one per progress, yielding in between. */
+typedef struct DriverFuture {
+    Future base;
+    ManualFuture** manuals;
+    size_t n;
+    size_t next;
+} DriverFuture;
+
+static FutureState driver_progress(Future* base, Mio* mio, Waker waker)
+{
+    DriverFuture* self = (DriverFuture*)base;
+    if (self->next == self->n)
+        return FUTURE_COMPLETED;
+    ManualFuture* manual = self->manuals[self->next++];
+    manual->released = true;
+    waker_wake(&manual->waker);
+    waker_wake(&waker);
+    return FUTURE_PENDING;
+}
+
+static DriverFuture driver_future_create(ManualFuture** manuals, size_t n)
+{
+    return (DriverFuture) { .base = future_create(driver_progress), .manuals = manuals, .n = n };
+}
+
+/** Every wake re-progresses only the woken child: 2 progress calls per child in total. */
+static void test_join_all_progresses_woken_children_only(void)
+{
+    static ManualFuture children[N_CHILDREN];
+    static Future* futs[N_CHILDREN];
+    static ManualFuture* order[N_CHILDREN];
+    static ChildResult results[N_CHILDREN];
+    for (int i = 0; i < N_CHILDREN; i++) {
+        children[i] = manual_future_create();
+        futs[i] = (Future*)&children[i];
+        order[i] = &children[(i * 7) % N_CHILDREN]; // Release them out of order.
+    }
+    children[3].fail = true;
+
+    Executor* executor = executor_create(0);
+    JoinAllFuture join = future_join_all(futs, N_CHILDREN, results);
+    DriverFuture driver = driver_future_create(order, N_CHILDREN);
+    executor_spawn(executor, (Future*)&join);
+    executor_spawn(executor, (Future*)&driver);
+    executor_run(executor);
+
+    assert(!join.base.is_active);
+    assert(join.base.errcode == JOIN_ALL_FUTURE_ERR_FAILED);
+    assert(join.base.ok == results);
+    for (int i = 0; i < N_CHILDREN; i++) {
+        assert(children[i].progressed == 2);
+        if (i == 3) {
+            assert(results[i].state == FUTURE_FAILURE && results[i].errcode == 42);
+        } else {
+            assert(results[i].state == FUTURE_COMPLETED && results[i].ok == &children[i]);
+        }
+    }
+    executor_destroy(executor);
+}
+
+/** Wakes go through nested combinators (n-ary and binary) up to the spawned future. */
+static void test_nested(void)
+{
+    ManualFuture a = manual_future_create(), b = manual_future_create();
+    ManualFuture c = manual_future_create(), d = manual_future_create();
+    JoinFuture ab = future_join((Future*)&a, (Future*)&b);
+    Future* inner_futs[] = { (Future*)&ab, (Future*)&c };
+    ChildResult inner_results[2];
+    JoinAllFuture inner = future_join_all(inner_futs, 2, inner_results);
+    Future* outer_futs[] = { (Future*)&inner, (Future*)&d };
+    ChildResult outer_results[2];
+    JoinAllFuture outer = future_join_all(outer_futs, 2, outer_results);
+
+    ManualFuture* order[] = { &c, &d, &a, &b };
+    DriverFuture driver = driver_future_create(order, 4);
+
+    Executor* executor = executor_create(0);
+    executor_spawn(executor, (Future*)&outer);
+    executor_spawn(executor, (Future*)&driver);
+    executor_run(executor);
+
+    assert(outer.base.errcode == FUTURE_SUCCESS && !outer.base.is_active);
+    assert(c.progressed == 2 && d.progressed == 2);
+    assert(a.progressed == 2 && b.progressed == 2);
+    executor_destroy(executor);
+}
+
+static void test_select_any(void)
+{
+    ManualFuture children[4];
+    Future* futs[4];
+    ChildResult results[4];
+    for (int i = 0; i < 4; i++) {
+        children[i] = manual_future_create();
+        futs[i] = (Future*)&children[i];
+    }
+    children[1].fail = true;
+    ManualFuture* order[] = { &children[1], &children[2], &children[0] };
+    DriverFuture driver = driver_future_create(order, 3);
+
+    Executor* executor = executor_create(0);
+    SelectAnyFuture select = future_select_any(futs, 4, results);
+    executor_spawn(executor, (Future*)&select);
+    executor_spawn(executor, (Future*)&driver);
+    executor_run(executor);
+
+    assert(select.base.errcode == FUTURE_SUCCESS);
+    assert(select.winner == 2 && select.base.ok == &children[2]);
+    assert(results[1].state == FUTURE_FAILURE);
+    assert(children[3].progressed == 1); // Never woken.
+    assert(children[0].progressed == 1); // Released after the winner: not progressed again.
+    executor_destroy(executor);
+
+    // If every child fails, so does the select.
+    for (int i = 0; i < 4; i++) {
+        children[i] = manual_future_create();
+        children[i].released = children[i].fail = true;
+    }
+    executor = executor_create(0);
+    select = future_select_any(futs, 4, results);
+    executor_spawn(executor, (Future*)&select);
+    executor_run(executor);
+    assert(select.base.errcode == SELECT_ANY_FUTURE_ERR_ALL_FAILED);
+    executor_destroy(executor);
+}
+
+/** Pipe reads, woken by Mio through their slots, on a multi-threaded executor. */
+static void test_pipes(void)
+{
+    const char* message = "AAABBBCCCD";
+    int fds[N_PIPES];
+    uint8_t buffers[N_PIPES][strlen(message) + 1];
+    PipeReadFuture reads[N_PIPES];
+    Future* futs[N_PIPES];
+    ChildResult results[N_PIPES];
+    for (int i = 0; i < N_PIPES; i++) {
+        fds[i] = create_example_read_pipe_end(message, 1 + i % 4, 0, 0);
+        reads[i] = pipe_read_future_create(fds[i], buffers[i], sizeof(buffers[i]));
+        futs[i] = (Future*)&reads[i];
+    }
+
+    Executor* executor = executor_create_multi(4, 0);
+    JoinAllFuture join = future_join_all(futs, N_PIPES, results);
+    executor_spawn(executor, (Future*)&join);
+    executor_run(executor);
+
+    assert(join.base.errcode == FUTURE_SUCCESS);
+    for (int i = 0; i < N_PIPES; i++) {
+        assert(results[i].state == FUTURE_COMPLETED);
+        assert(memcmp(buffers[i], message, sizeof(buffers[i])) == 0);
+        ASSERT_SYS_OK(close(fds[i]));
+    }
+    executor_destroy(executor);
+}
+
+int main()
+{
+    test_join_all_progresses_woken_children_only();
+    test_nested();
+    test_select_any();
+    test_pipes();
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "err.h"
+#include "executor.h"
+#include "future.h"
+#include "future_combinators.h"
+
+#define N_TASKS 200
+#define FAILING_TASK_MOD 10 // Tasks whose number is 7 mod this fail.
+
+/** Yields `arg` times (going through the run queue each time), then completes with arg * arg. */
+typedef struct TaskFuture {
+    Future base;
+    intptr_t yields;
+} TaskFuture;
+
+static FutureState task_progress(Future* base, Mio* mio, Waker waker)
+{
+    TaskFuture* self = (TaskFuture*)base;
+    intptr_t const n = (intptr_t)base->arg;
+    if (self->yields < n) {
+        self->yields++;
+        waker_wake(&waker);
+        return FUTURE_PENDING;
+    }
+    if (n % FAILING_TASK_MOD == 7) {
+        base->errcode = (int)n;
+        return FUTURE_FAILURE;
+    }
+    base->ok = (void*)(n * n);
+    return FUTURE_COMPLETED;
+}
+
+/** Spawns N_TASKS tasks on `executor` (allocated from it) and awaits them all. */
+typedef struct FanOutFuture {
+    Future base;
+    Executor* executor;
+    bool spawned;
+    int progressed;
+    JoinHandle handles[N_TASKS];
+    Future* handle_ptrs[N_TASKS];
+    ChildResult results[N_TASKS];
+    JoinAllFuture join;
+} FanOutFuture;
+
+static FutureState fan_out_progress(Future* base, Mio* mio, Waker waker)
+{
+    FanOutFuture* self = (FanOutFuture*)base;
+    self->progressed++;
+    if (!self->spawned) {
+        self->spawned = true;
+        for (intptr_t i = 0; i < N_TASKS; i++) {
+            TaskFuture* task = executor_alloc_future(self->executor, sizeof(TaskFuture));
+            assert(task);
+            *task = (TaskFuture) { .base = future_create(task_progress) };
+            task->base.arg = (void*)(i % 13);
+            ASSERT_ZERO(executor_spawn_handle(self->executor, &task->base, &self->handles[i]));
+            self->handle_ptrs[i] = &self->handles[i].base;
+        }
+        self->join = future_join_all(self->handle_ptrs, N_TASKS, self->results);
+    }
+    return self->join.base.progress(&self->join.base, mio, waker);
+}
+
+static void check_results(FanOutFuture const* fan_out)
+{
+    assert(fan_out->join.base.errcode == JOIN_ALL_FUTURE_ERR_FAILED);
+    for (intptr_t i = 0; i < N_TASKS; i++) {
+        intptr_t const n = i % 13;
+        if (n % FAILING_TASK_MOD == 7) {
+            assert(fan_out->results[i].state == FUTURE_FAILURE);
+            assert(fan_out->results[i].errcode == n);
+        } else {
+            assert(fan_out->results[i].state == FUTURE_COMPLETED);
+            assert(fan_out->results[i].ok == (void*)(n * n));
+        }
+    }
+    // Woken by the tasks' completions (at most once each), never polled.
+    assert(fan_out->progressed <= N_TASKS + 1);
+}
+
+/** The awaiter and the tasks run on the same executor. */
+static void test_fan_out(size_t n_threads)
+{
+    static FanOutFuture fan_out;
+    ExecutorConfig config = executor_config_default();
+    config.n_threads = n_threads;
+    Executor* executor = executor_create_with_config(&config);
+    fan_out = (FanOutFuture) { .base = future_create(fan_out_progress), .executor = executor };
+    ASSERT_ZERO(executor_spawn(executor, &fan_out.base));
+    executor_run(executor);
+    assert(!fan_out.base.is_active);
+    check_results(&fan_out);
+    printf("threads=%zu: awaiter progressed %d times for %d tasks\n", n_threads,
+        fan_out.progressed, N_TASKS);
+    executor_destroy(executor);
+}
+
+/** Keeps a multi-threaded executor running until the awaiter on the other executor is done. */
+typedef struct Keeper {
+    Future base;
+    Waker waker;
+    atomic_bool armed;
+    atomic_bool release;
+} Keeper;
+
+static FutureState keeper_progress(Future* base, Mio* mio, Waker waker)
+{
+    Keeper* self = (Keeper*)base;
+    if (atomic_load(&self->release))
+        return FUTURE_COMPLETED;
+    self->waker = waker;
+    atomic_store(&self->armed, true);
+    return FUTURE_PENDING;
+}
+
+static void* run_executor(void* arg)
+{
+    executor_run(arg);
+    return NULL;
+}
+
+/** The tasks run on a multi-threaded executor, in other threads; the awaiter on the caller's. */
+static void test_across_executors(void)
+{
+    static FanOutFuture fan_out;
+    Executor* workers = executor_create_multi(2, 0);
+    Keeper keeper = { .base = future_create(keeper_progress) };
+    ASSERT_ZERO(executor_spawn(workers, &keeper.base));
+    pthread_t thread;
+    ASSERT_ZERO(pthread_create(&thread, NULL, run_executor, workers));
+    while (!atomic_load(&keeper.armed))
+        usleep(100);
+
+    Executor* awaiter = executor_create(0);
+    fan_out = (FanOutFuture) { .base = future_create(fan_out_progress), .executor = workers };
+    ASSERT_ZERO(executor_spawn(awaiter, &fan_out.base));
+    executor_run(awaiter);
+    check_results(&fan_out);
+
+    atomic_store(&keeper.release, true);
+    waker_wake(&keeper.waker);
+    ASSERT_ZERO(pthread_join(thread, NULL));
+    executor_destroy(awaiter);
+    executor_destroy(workers);
+}
+
+/** A handle progressed only after its task is done completes right away. */
+static void test_await_after_completion(void)
+{
+    Executor* executor = executor_create(0);
+    TaskFuture task = { .base = future_create(task_progress) };
+    task.base.arg = (void*)3;
+    JoinHandle handle;
+    ASSERT_ZERO(executor_spawn_handle(executor, &task.base, &handle));
+    executor_run(executor);
+    assert(!task.base.is_active);
+
+    ASSERT_ZERO(executor_spawn(executor, &handle.base));
+    executor_run(executor);
+    assert(!handle.base.is_active && handle.base.ok == (void*)9);
+    executor_destroy(executor);
+}
+
+int main()
+{
+    test_fan_out(0);
+    test_fan_out(2);
+    test_across_executors();
+    test_await_after_completion();
+    printf("OK\n");
+    return 0;
+}
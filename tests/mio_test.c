@@ -2,11 +2,14 @@
 #define _GNU_SOURCE
 
 #include <assert.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <stdint.h> // For uint64_t
 #include <stdio.h> // For printf
 #include <stdlib.h> // For exit
 #include <string.h> // For memcmp
+#include <sys/epoll.h> // For EPOLLIN, EPOLLOUT
+#include <sys/socket.h> // For socketpair
 #include <sys/timerfd.h> // For timerfd
 #include <unistd.h> // For pipe, read, write
 
@@ -17,7 +20,43 @@
 #include "mio.h"
 #include "utils.h"
 
-int main()
+#define N_BATCH_PIPES 400
+
+/** Writes one byte to each of the given fds, then completes. */
+typedef struct WriteAllFuture {
+    Future base;
+    int* fds;
+    size_t n;
+} WriteAllFuture;
+
+static FutureState write_all_progress(Future* base, Mio* mio, Waker waker)
+{
+    WriteAllFuture* self = (WriteAllFuture*)base;
+    for (size_t i = 0; i < self->n; i++)
+        ASSERT_SYS_OK(write(self->fds[i], "x", 1));
+    return FUTURE_COMPLETED;
+}
+
+/** Sleeps 1 ms, `remaining` times in a row. */
+typedef struct NapsFuture {
+    Future base;
+    SleepFuture nap;
+    int remaining;
+} NapsFuture;
+
+static FutureState naps_progress(Future* base, Mio* mio, Waker waker)
+{
+    NapsFuture* self = (NapsFuture*)base;
+    while (self->remaining > 0) {
+        if (self->nap.base.progress((Future*)&self->nap, mio, waker) == FUTURE_PENDING)
+            return FUTURE_PENDING;
+        self->nap = sleep_future_create(1);
+        self->remaining--;
+    }
+    return FUTURE_COMPLETED;
+}
+
+static void test_slow_pipes(void)
 {
     // In this test, we create two futures that read from two slow pipes, independently.
     // They should be able to work concurrently (with one future progressing when the other is waiting to read).
@@ -58,6 +97,241 @@ int main()
 
     // Destroy the executor
     executor_destroy(executor);
+}
+
+static void test_event_batch(void)
+{
+    // Many fds get ready at once: the epoll event buffer grows to take them in fewer polls, and
+    // shrinks back once polls return few events (here: none, while sleeping).
+    ExecutorConfig config = executor_config_default();
+    config.mio.event_batch = 8;
+    config.mio.max_event_batch = 64;
+    Executor* executor = executor_create_with_config(&config);
+
+    static int read_fds[N_BATCH_PIPES], write_fds[N_BATCH_PIPES];
+    static uint8_t buffers[N_BATCH_PIPES];
+    static PipeReadFuture reads[N_BATCH_PIPES];
+    for (int i = 0; i < N_BATCH_PIPES; i++) {
+        int fds[2];
+        ASSERT_SYS_OK(pipe2(fds, O_NONBLOCK));
+        read_fds[i] = fds[0];
+        write_fds[i] = fds[1];
+        reads[i] = pipe_read_future_create(read_fds[i], &buffers[i], 1);
+        executor_spawn(executor, (Future*)&reads[i]);
+    }
+    // Runs after every read got EAGAIN and registered.
+    WriteAllFuture write_all = {
+        .base = future_create(write_all_progress),
+        .fds = write_fds,
+        .n = N_BATCH_PIPES,
+    };
+    executor_spawn(executor, (Future*)&write_all);
+    executor_run(executor);
+
+    MioStats stats;
+    mio_stats(executor_mio(executor), &stats);
+    printf("%llu events in %llu polls (at most %llu per poll), buffer grew %llu times\n",
+        (unsigned long long)stats.events, (unsigned long long)stats.polls,
+        (unsigned long long)stats.max_events_per_poll, (unsigned long long)stats.event_batch_grows);
+    assert(stats.events >= N_BATCH_PIPES);
+    assert(stats.event_batch_grows == 3 && stats.event_batch == 64);
+    assert(stats.max_events_per_poll == 64);
+    assert(stats.full_polls >= 3);
+    assert(stats.polls < N_BATCH_PIPES / 8);
+
+    NapsFuture naps = {
+        .base = future_create(naps_progress),
+        .nap = sleep_future_create(1),
+        .remaining = 200,
+    };
+    executor_spawn(executor, (Future*)&naps);
+    executor_run(executor);
+    mio_stats(executor_mio(executor), &stats);
+    printf("after naps: buffer of %llu events, shrank %llu times\n",
+        (unsigned long long)stats.event_batch, (unsigned long long)stats.event_batch_shrinks);
+    assert(stats.event_batch_shrinks > 0 && stats.event_batch < 64);
+
+    for (int i = 0; i < N_BATCH_PIPES; i++) {
+        assert(buffers[i] == 'x');
+        ASSERT_SYS_OK(close(read_fds[i]));
+        ASSERT_SYS_OK(close(write_fds[i]));
+    }
+    executor_destroy(executor);
+}
+
+#define VECTORED_BYTES (256 * 1024) // Several times the pipe capacity.
+
+/** Fills iovecs over `buffer` with segment lengths cycling through `lengths` (zeros included). */
+static int segment(uint8_t* buffer, size_t size, size_t const* lengths, size_t n_lengths,
+    struct iovec* iov, int max_iov)
+{
+    int cnt = 0;
+    size_t offset = 0;
+    for (size_t i = 0; offset < size && cnt < max_iov; i++) {
+        size_t len = lengths[i % n_lengths];
+        if (len > size - offset)
+            len = size - offset;
+        iov[cnt++] = (struct iovec) { .iov_base = buffer + offset, .iov_len = len };
+        offset += len;
+    }
+    assert(offset == size);
+    return cnt;
+}
+
+static void test_vectored_pipes(void)
+{
+    // Gather-write segments of one layout into a pipe, scatter-read them into another: short reads
+    // and writes end in the middle of segments, and more segments than one call takes are queued.
+    static uint8_t out[VECTORED_BYTES], in[VECTORED_BYTES];
+    static struct iovec out_iov[4096], in_iov[4096];
+    size_t const out_lengths[] = { 7, 0, 1000, 3, 65536, 129 };
+    size_t const in_lengths[] = { 4096, 1, 0, 333 };
+    for (size_t i = 0; i < VECTORED_BYTES; i++)
+        out[i] = (uint8_t)(i * 31 + i / 251);
+    int const out_cnt = segment(out, VECTORED_BYTES, out_lengths, 6, out_iov, 4096);
+    int const in_cnt = segment(in, VECTORED_BYTES, in_lengths, 4, in_iov, 4096);
+    assert(in_cnt > PIPE_IOV_BATCH);
+
+    int fds[2];
+    ASSERT_SYS_OK(pipe2(fds, O_NONBLOCK));
+    Executor* executor = executor_create(0);
+    PipeWritevFuture writev_fut = pipe_writev_future_create(fds[1], out_iov, out_cnt);
+    PipeReadvFuture readv_fut = pipe_readv_future_create(fds[0], in_iov, in_cnt);
+    executor_spawn(executor, (Future*)&readv_fut);
+    executor_spawn(executor, (Future*)&writev_fut);
+    executor_run(executor);
+    assert(!writev_fut.base.is_active && writev_fut.base.errcode == FUTURE_SUCCESS);
+    assert(!readv_fut.base.is_active && readv_fut.base.errcode == FUTURE_SUCCESS);
+    assert(readv_fut.transferred == VECTORED_BYTES && readv_fut.base.ok == in_iov);
+    assert(memcmp(in, out, VECTORED_BYTES) == 0);
+
+    // EOF before the buffers are full.
+    readv_fut = pipe_readv_future_create(fds[0], in_iov, in_cnt);
+    ASSERT_SYS_OK(write(fds[1], "abcdefgh", 8));
+    ASSERT_SYS_OK(close(fds[1]));
+    executor_spawn(executor, (Future*)&readv_fut);
+    executor_run(executor);
+    assert(readv_fut.base.errcode == PIPE_FUTURE_ERR_EOF && readv_fut.transferred == 8);
+    assert(memcmp(in, "abcdefgh", 8) == 0);
+    executor_destroy(executor);
+    ASSERT_SYS_OK(close(fds[0]));
+}
 
+#define DUPLEX_BYTES (1024 * 1024) // Far more than a socket buffer holds.
+
+static void test_full_duplex(void)
+{
+    // Each end of a socket pair has a reader and a writer at once, both mostly waiting on the same
+    // fd (in different directions), as neither side reads before it wrote its share.
+    static uint8_t out[2][DUPLEX_BYTES], in[2][DUPLEX_BYTES];
+    for (size_t i = 0; i < DUPLEX_BYTES; i++) {
+        out[0][i] = (uint8_t)(i * 7);
+        out[1][i] = (uint8_t)(i / 3 + 1);
+    }
+    int fds[2];
+    ASSERT_SYS_OK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds));
+
+    Executor* executor = executor_create(0);
+    PipeWriteFuture writes[2];
+    PipeReadFuture reads[2];
+    for (int i = 0; i < 2; i++) {
+        writes[i] = pipe_write_future_create(fds[i], DUPLEX_BYTES, false);
+        writes[i].base.arg = out[i];
+        reads[i] = pipe_read_future_create(fds[i], in[i], DUPLEX_BYTES);
+        executor_spawn(executor, (Future*)&writes[i]);
+        executor_spawn(executor, (Future*)&reads[i]);
+    }
+    executor_run(executor);
+    for (int i = 0; i < 2; i++) {
+        assert(!writes[i].base.is_active && writes[i].base.errcode == FUTURE_SUCCESS);
+        assert(!reads[i].base.is_active && reads[i].base.errcode == FUTURE_SUCCESS);
+        assert(memcmp(in[i], out[1 - i], DUPLEX_BYTES) == 0);
+    }
+
+    // Unregistering one direction leaves the other one's waker registered.
+    Mio* mio = executor_mio(executor);
+    Waker waker = { .executor = executor, .future = NULL };
+    ASSERT_SYS_OK(mio_register(mio, fds[0], EPOLLIN, waker));
+    ASSERT_SYS_OK(mio_register(mio, fds[0], EPOLLOUT, waker));
+    ASSERT_SYS_OK(mio_unregister_events(mio, fds[0], EPOLLOUT));
+    assert(mio_unregister_events(mio, fds[0], EPOLLOUT) == -1 && errno == ENOENT);
+    ASSERT_SYS_OK(mio_unregister_events(mio, fds[0], EPOLLIN));
+    assert(mio_unregister(mio, fds[0]) == -1 && errno == ENOENT);
+
+    executor_destroy(executor);
+    ASSERT_SYS_OK(close(fds[0]));
+    ASSERT_SYS_OK(close(fds[1]));
+}
+
+/** Closes an fd when progressed (after the futures spawned before it started waiting). */
+typedef struct CloseFuture {
+    Future base;
+    int fd;
+} CloseFuture;
+
+static FutureState close_progress(Future* base, Mio* mio, Waker waker)
+{
+    ASSERT_SYS_OK(close(((CloseFuture*)base)->fd));
+    return FUTURE_COMPLETED;
+}
+
+static void test_readiness(void)
+{
+    int fds[2];
+    ASSERT_SYS_OK(pipe2(fds, O_NONBLOCK));
+    Executor* executor = executor_create(0);
+    Mio* mio = executor_mio(executor);
+
+    // Unknown until registered; then reported events accumulate until cleared.
+    Future dummy = future_create(close_progress); // Never spawned: its wakes are ignored.
+    Waker waker = { .executor = executor, .future = &dummy };
+    assert(mio_readiness(mio, fds[0]).events == (EPOLLIN | EPOLLOUT));
+    ASSERT_SYS_OK(mio_register(mio, fds[0], EPOLLIN, waker));
+    MioReadiness ready = mio_readiness(mio, fds[0]);
+    assert(!(ready.events & EPOLLIN) && (ready.events & EPOLLOUT));
+    ASSERT_SYS_OK(write(fds[1], "x", 1));
+    assert(mio_poll_nonblocking(mio) == 1);
+    assert(mio_readiness(mio, fds[0]).events & EPOLLIN);
+    mio_clear_readiness(mio, fds[0], ready, EPOLLIN); // Stale: an event came since.
+    assert(mio_readiness(mio, fds[0]).events & EPOLLIN);
+    ready = mio_readiness(mio, fds[0]);
+    mio_clear_readiness(mio, fds[0], ready, EPOLLIN);
+    assert(!(mio_readiness(mio, fds[0]).events & EPOLLIN));
+    ASSERT_SYS_OK(mio_unregister(mio, fds[0]));
+
+    // A hang-up ends a read with EOF (once drained), an error a write, both with no syscall (a
+    // write() to a pipe without reader would raise SIGPIPE).
+    uint8_t buffer[2];
+    PipeReadFuture read_fut = pipe_read_future_create(fds[0], buffer, sizeof(buffer));
+    CloseFuture close_writer = { .base = future_create(close_progress), .fd = fds[1] };
+    executor_spawn(executor, (Future*)&read_fut);
+    executor_spawn(executor, (Future*)&close_writer);
+    executor_run(executor);
+    // Only the "x" from above was there.
+    assert(read_fut.base.errcode == PIPE_FUTURE_ERR_EOF && read_fut.read_so_far == 1);
+
+    ASSERT_SYS_OK(close(fds[0]));
+    ASSERT_SYS_OK(pipe2(fds, O_NONBLOCK));
+    static uint8_t big[1 << 20];
+    PipeWriteFuture write_fut = pipe_write_future_create(fds[1], sizeof(big), false);
+    write_fut.base.arg = big;
+    CloseFuture close_reader = { .base = future_create(close_progress), .fd = fds[0] };
+    executor_spawn(executor, (Future*)&write_fut);
+    executor_spawn(executor, (Future*)&close_reader);
+    executor_run(executor);
+    assert(write_fut.base.errcode == PIPE_FUTURE_ERR_IO && write_fut.written_so_far > 0);
+
+    executor_destroy(executor);
+    ASSERT_SYS_OK(close(fds[1]));
+}
+
+int main()
+{
+    test_slow_pipes();
+    test_event_batch();
+    test_vectored_pipes();
+    test_full_duplex();
+    test_readiness();
+    printf("OK\n");
     return 0;
 }
@@ -0,0 +1,131 @@
+// Required for `unistd.h` include to contain `pipe2`.
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "err.h"
+#include "executor.h"
+#include "future.h"
+#include "future_combinators.h"
+#include "future_examples.h"
+#include "utils.h"
+
+#define N_WORKERS 4
+#define N_COUNTERS 200
+#define N_STEPS 50
+
+/** A future that yields N_STEPS times, checking it is never progressed concurrently. */
+typedef struct CounterFuture {
+    Future base;
+    atomic_int inside; // Number of threads currently in progress().
+    int steps;
+} CounterFuture;
+
+static FutureState counter_progress(Future* base, Mio* mio, Waker waker)
+{
+    CounterFuture* self = (CounterFuture*)base;
+    assert(atomic_fetch_add(&self->inside, 1) == 0);
+
+    // Wake ourselves twice: the duplicate must not lead to a concurrent progress() call.
+    self->steps++;
+    FutureState state = FUTURE_COMPLETED;
+    if (self->steps < N_STEPS) {
+        waker_wake(&waker);
+        waker_wake(&waker);
+        state = FUTURE_PENDING;
+    }
+
+    atomic_fetch_sub(&self->inside, 1);
+    return state;
+}
+
+/** A future woken by a helper thread, rather than by Mio or by itself. */
+typedef struct RemoteFuture {
+    Future base;
+    pthread_t thread;
+    Waker waker;
+    atomic_bool fired;
+    bool started;
+} RemoteFuture;
+
+static void* remote_thread(void* arg)
+{
+    RemoteFuture* self = arg;
+    usleep(100000);
+    atomic_store(&self->fired, true);
+    waker_wake(&self->waker);
+    return NULL;
+}
+
+static FutureState remote_progress(Future* base, Mio* mio, Waker waker)
+{
+    RemoteFuture* self = (RemoteFuture*)base;
+    if (!self->started) {
+        self->started = true;
+        self->waker = waker;
+        ASSERT_ZERO(pthread_create(&self->thread, NULL, remote_thread, self));
+        return FUTURE_PENDING;
+    }
+    if (!atomic_load(&self->fired))
+        return FUTURE_PENDING;
+    ASSERT_ZERO(pthread_join(self->thread, NULL));
+    return FUTURE_COMPLETED;
+}
+
+int main()
+{
+    // Yielding futures, pipe readers and a remotely woken future, all on a pool of workers.
+    Executor* executor = executor_create_multi(N_WORKERS, 0);
+
+    static CounterFuture counters[N_COUNTERS];
+    for (int i = 0; i < N_COUNTERS; ++i) {
+        counters[i] = (CounterFuture) { .base = future_create(counter_progress) };
+        executor_spawn(executor, (Future*)&counters[i]);
+    }
+
+    const char* message = "AAABBBCCCD";
+    int read_fd1 = create_example_read_pipe_end(message, 3, 0, 0);
+    int read_fd2 = create_example_read_pipe_end(message, 4, 0, 0);
+    uint8_t buffer1[strlen(message) + 1];
+    uint8_t buffer2[strlen(message) + 1];
+    PipeReadFuture r1 = pipe_read_future_create(read_fd1, buffer1, sizeof(buffer1));
+    PipeReadFuture r2 = pipe_read_future_create(read_fd2, buffer2, sizeof(buffer2));
+    r1.trigger = EPOLLET;
+    r2.trigger = EPOLLONESHOT;
+    JoinFuture join = future_join((Future*)&r1, (Future*)&r2);
+    executor_spawn(executor, (Future*)&join);
+
+    RemoteFuture remote = { .base = future_create(remote_progress) };
+    executor_spawn(executor, (Future*)&remote);
+
+    executor_run(executor);
+
+    for (int i = 0; i < N_COUNTERS; ++i) {
+        assert(!counters[i].base.is_active);
+        assert(counters[i].steps == N_STEPS);
+    }
+    assert(join.base.errcode == FUTURE_SUCCESS);
+    assert(memcmp(buffer1, message, sizeof(buffer1)) == 0);
+    assert(memcmp(buffer2, message, sizeof(buffer2)) == 0);
+    assert(!remote.base.is_active && atomic_load(&remote.fired));
+
+    // Each counter step wakes twice; the second wake is always collapsed into the first.
+    ExecutorStats stats;
+    executor_stats(executor, &stats);
+    printf("wakes: %zu, coalesced: %zu, progressed: %zu\n", stats.wakes, stats.wakes_coalesced,
+        stats.progressed);
+    assert(stats.wakes_coalesced >= N_COUNTERS * (N_STEPS - 1));
+    assert(stats.progressed <= stats.spawned + stats.wakes - stats.wakes_coalesced);
+
+    executor_destroy(executor);
+    ASSERT_SYS_OK(close(read_fd1));
+    ASSERT_SYS_OK(close(read_fd2));
+    printf("OK\n");
+    return 0;
+}
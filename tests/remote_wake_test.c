@@ -0,0 +1,233 @@
+// Required for `unistd.h` include to contain `pipe2`.
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "err.h"
+#include "executor.h"
+#include "future.h"
+#include "future_examples.h"
+
+#define N_THREADS 4
+#define N_SPAWNS_PER_THREAD 20000
+
+/** Hands its waker to a helper thread, which computes for a while and then wakes it. */
+typedef struct OffloadFuture {
+    Future base;
+    pthread_t thread;
+    Waker waker;
+    atomic_bool finished; // Set by the helper before waking.
+    bool started;
+    int write_fd; // If not -1, written to once the future resumes.
+} OffloadFuture;
+
+static void* offload_thread(void* arg)
+{
+    OffloadFuture* self = arg;
+    usleep(50000);
+    atomic_store(&self->finished, true);
+    waker_wake(&self->waker);
+    return NULL;
+}
+
+static FutureState offload_progress(Future* base, Mio* mio, Waker waker)
+{
+    OffloadFuture* self = (OffloadFuture*)base;
+    if (!self->started) {
+        self->started = true;
+        self->waker = waker;
+        ASSERT_ZERO(pthread_create(&self->thread, NULL, offload_thread, self));
+        return FUTURE_PENDING;
+    }
+    if (!atomic_load(&self->finished))
+        return FUTURE_PENDING;
+    ASSERT_ZERO(pthread_join(self->thread, NULL));
+    if (self->write_fd != -1)
+        ASSERT_SYS_OK(write(self->write_fd, "x", 1));
+    return FUTURE_COMPLETED;
+}
+
+static OffloadFuture offload_future_create(int write_fd)
+{
+    return (OffloadFuture) { .base = future_create(offload_progress), .write_fd = write_fd };
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/** A current-thread executor with nothing registered in Mio waits for the wake (parked). */
+static void test_wake_while_parked(void)
+{
+    Executor* executor = executor_create(0);
+    OffloadFuture fut = offload_future_create(-1);
+    executor_spawn(executor, (Future*)&fut);
+    executor_run(executor);
+    assert(!fut.base.is_active && atomic_load(&fut.finished));
+
+    ExecutorStats stats;
+    executor_stats(executor, &stats);
+    assert(stats.injected == 1);
+    executor_destroy(executor);
+}
+
+/** A current-thread executor blocked in mio_poll() (on a pipe nobody else writes to) is
+ * interrupted by the wake; the woken future then makes the pipe ready. */
+static void test_wake_interrupts_poll(void)
+{
+    int fds[2];
+    ASSERT_SYS_OK(pipe2(fds, O_NONBLOCK));
+    uint8_t byte;
+    PipeReadFuture read = pipe_read_future_create(fds[0], &byte, 1);
+    OffloadFuture fut = offload_future_create(fds[1]);
+
+    Executor* executor = executor_create(0);
+    double const start = now();
+    executor_spawn(executor, (Future*)&read);
+    executor_spawn(executor, (Future*)&fut);
+    executor_run(executor);
+    double const elapsed = now() - start;
+    printf("Woken out of mio_poll() after %.3f s\n", elapsed);
+    assert(!read.base.is_active && byte == 'x');
+    assert(elapsed < 1.0);
+    executor_destroy(executor);
+    ASSERT_SYS_OK(close(fds[0]));
+    ASSERT_SYS_OK(close(fds[1]));
+}
+
+/** Counts its progress calls, completing on the first one. */
+static atomic_int completed;
+
+static FutureState count_progress(Future* base, Mio* mio, Waker waker)
+{
+    atomic_fetch_add(&completed, 1);
+    return FUTURE_COMPLETED;
+}
+
+/** Pending until the last spawning thread is done, so that executor_run() does not return early. */
+typedef struct GateFuture {
+    Future base;
+    Waker waker;
+    atomic_bool waker_set;
+    atomic_int running_threads;
+} GateFuture;
+
+static FutureState gate_progress(Future* base, Mio* mio, Waker waker)
+{
+    GateFuture* self = (GateFuture*)base;
+    if (atomic_load(&self->running_threads) == 0)
+        return FUTURE_COMPLETED;
+    self->waker = waker;
+    atomic_store(&self->waker_set, true);
+    return FUTURE_PENDING;
+}
+
+typedef struct Spawner {
+    Executor* executor;
+    GateFuture* gate;
+    Future futs[N_SPAWNS_PER_THREAD];
+} Spawner;
+
+static void* spawner_thread(void* arg)
+{
+    Spawner* spawner = arg;
+    while (!atomic_load(&spawner->gate->waker_set))
+        usleep(100);
+    for (int i = 0; i < N_SPAWNS_PER_THREAD; i++) {
+        spawner->futs[i] = future_create(count_progress);
+        ASSERT_SYS_OK(executor_spawn(spawner->executor, &spawner->futs[i]));
+    }
+    if (atomic_fetch_sub(&spawner->gate->running_threads, 1) == 1)
+        waker_wake(&spawner->gate->waker);
+    return NULL;
+}
+
+/** Many threads spawn into a running executor at once: every future runs exactly once. */
+static void test_concurrent_remote_spawns(size_t n_threads)
+{
+    static Spawner spawners[N_THREADS];
+    pthread_t threads[N_THREADS];
+    ExecutorConfig config = executor_config_default();
+    config.n_threads = n_threads;
+    Executor* executor = executor_create_with_config(&config);
+    GateFuture gate = { .base = future_create(gate_progress) };
+    atomic_store(&gate.running_threads, N_THREADS);
+    atomic_store(&completed, 0);
+
+    executor_spawn(executor, (Future*)&gate);
+    for (int i = 0; i < N_THREADS; i++) {
+        spawners[i].executor = executor;
+        spawners[i].gate = &gate;
+        ASSERT_ZERO(pthread_create(&threads[i], NULL, spawner_thread, &spawners[i]));
+    }
+    executor_run(executor);
+    for (int i = 0; i < N_THREADS; i++)
+        ASSERT_ZERO(pthread_join(threads[i], NULL));
+
+    assert(!gate.base.is_active);
+    assert(atomic_load(&completed) == N_THREADS * N_SPAWNS_PER_THREAD);
+    for (int i = 0; i < N_THREADS; i++)
+        for (int j = 0; j < N_SPAWNS_PER_THREAD; j++)
+            assert(!spawners[i].futs[j].is_active);
+    ExecutorStats stats;
+    executor_stats(executor, &stats);
+    assert(stats.injected >= N_THREADS * N_SPAWNS_PER_THREAD);
+    executor_destroy(executor);
+}
+
+static atomic_int blocking_running, blocking_max_running;
+
+/** A blocking call, tracking how many run at once. Returns its argument plus one. */
+static void* blocking_call(void* arg)
+{
+    int running = atomic_fetch_add(&blocking_running, 1) + 1;
+    int max = atomic_load(&blocking_max_running);
+    while (running > max && !atomic_compare_exchange_weak(&blocking_max_running, &max, running)) { }
+    usleep(5000);
+    atomic_fetch_sub(&blocking_running, 1);
+    return (void*)((intptr_t)arg + 1);
+}
+
+/** Blocking calls run on at most max_blocking_threads threads, and complete their futures. */
+static void test_spawn_blocking(size_t n_threads)
+{
+    enum { N = 16 };
+    SpawnBlockingFuture futs[N];
+    ExecutorConfig config = executor_config_default();
+    config.n_threads = n_threads;
+    config.max_blocking_threads = 3;
+    Executor* executor = executor_create_with_config(&config);
+    atomic_store(&blocking_max_running, 0);
+    for (intptr_t i = 0; i < N; i++) {
+        futs[i] = spawn_blocking_future_create(blocking_call, (void*)i);
+        executor_spawn(executor, (Future*)&futs[i]);
+    }
+    executor_run(executor);
+    for (intptr_t i = 0; i < N; i++)
+        assert(!futs[i].base.is_active && futs[i].base.ok == (void*)(i + 1));
+    printf("%d blocking calls at most at once\n", atomic_load(&blocking_max_running));
+    assert(atomic_load(&blocking_max_running) <= 3);
+    executor_destroy(executor);
+}
+
+int main()
+{
+    test_wake_while_parked();
+    test_wake_interrupts_poll();
+    test_concurrent_remote_spawns(0);
+    test_concurrent_remote_spawns(2);
+    test_spawn_blocking(0);
+    test_spawn_blocking(2);
+    printf("OK\n");
+    return 0;
+}
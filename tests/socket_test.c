@@ -0,0 +1,545 @@
+#define _GNU_SOURCE
+
+#include <arpa/inet.h>
+#include <assert.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "err.h"
+#include "executor.h"
+#include "future.h"
+#include "future_examples.h"
+#include "future_sockets.h"
+#include "mio.h"
+
+#define N_CLIENTS 32
+#define ROUNDS 20
+#define MESSAGE_SIZE 100
+#define ACCEPT_BATCH 16
+#define UDP_BATCH 32 // Datagrams sent per round (received in one batch of up to 2 * UDP_BATCH).
+
+/** A listening socket, and the address to connect to. */
+typedef struct Listener {
+    int fd;
+    struct sockaddr_storage addr;
+    socklen_t addrlen;
+} Listener;
+
+static Listener listen_on(int family)
+{
+    Listener listener = { .fd = socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0) };
+    ASSERT_SYS_OK(listener.fd);
+    if (family == AF_INET) {
+        struct sockaddr_in* in = (struct sockaddr_in*)&listener.addr;
+        in->sin_family = AF_INET;
+        in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        in->sin_port = 0; // Any free port (read back below).
+        listener.addrlen = sizeof(*in);
+    } else {
+        struct sockaddr_un* un = (struct sockaddr_un*)&listener.addr;
+        un->sun_family = AF_UNIX;
+        snprintf(un->sun_path, sizeof(un->sun_path), "/tmp/socket_test_%d.sock", (int)getpid());
+        unlink(un->sun_path);
+        listener.addrlen = sizeof(*un);
+    }
+    ASSERT_SYS_OK(bind(listener.fd, (struct sockaddr*)&listener.addr, listener.addrlen));
+    ASSERT_SYS_OK(listen(listener.fd, 128));
+    ASSERT_SYS_OK(getsockname(listener.fd, (struct sockaddr*)&listener.addr, &listener.addrlen));
+    return listener;
+}
+
+static void listener_close(Listener* listener, Mio* mio)
+{
+    ASSERT_SYS_OK(socket_close(mio, listener->fd));
+    if (listener->addr.ss_family == AF_UNIX)
+        ASSERT_SYS_OK(unlink(((struct sockaddr_un*)&listener->addr)->sun_path));
+}
+
+/** Echoes what it receives on its connection until the peer closes it. */
+typedef struct EchoFuture {
+    Future base;
+    int fd;
+    bool sending;
+    SocketRecvFuture recv;
+    SocketSendFuture send;
+    uint8_t buffer[512];
+} EchoFuture;
+
+static FutureState echo_progress(Future* base, Mio* mio, Waker waker)
+{
+    EchoFuture* self = (EchoFuture*)base;
+    for (;;) {
+        FutureState state;
+        if (!self->sending) {
+            state = self->recv.base.progress(&self->recv.base, mio, waker);
+            if (state == FUTURE_PENDING)
+                return FUTURE_PENDING;
+            if (state == FUTURE_FAILURE)
+                return self->recv.base.errcode == SOCKET_FUTURE_ERR_EOF ? FUTURE_COMPLETED
+                                                                       : FUTURE_FAILURE;
+            self->send = socket_send_future_create(self->fd, self->buffer, self->recv.received);
+            self->sending = true;
+        }
+        state = self->send.base.progress(&self->send.base, mio, waker);
+        if (state != FUTURE_COMPLETED)
+            return state;
+        self->recv = socket_recv_future_create(self->fd, self->buffer, sizeof(self->buffer));
+        self->sending = false;
+    }
+}
+
+static atomic_int echoes_done;
+
+static void echo_done(Future* fut, FutureState state, void* ctx)
+{
+    assert(state == FUTURE_COMPLETED);
+    atomic_fetch_add(&echoes_done, 1);
+}
+
+static void echo_destroy(Future* fut, void* ctx)
+{
+    ASSERT_SYS_OK(socket_close(executor_mio(ctx), ((EchoFuture*)fut)->fd));
+}
+
+/** Accepts `to_accept` connections, spawning an EchoFuture for each. */
+typedef struct ServerFuture {
+    Future base;
+    Executor* executor;
+    int listen_fd;
+    size_t to_accept;
+    size_t max_batch; // Most connections accepted at once.
+    bool accepting;
+    SocketAcceptFuture accept;
+    int fds[ACCEPT_BATCH];
+} ServerFuture;
+
+static FutureState server_progress(Future* base, Mio* mio, Waker waker)
+{
+    ServerFuture* self = (ServerFuture*)base;
+    while (self->to_accept > 0) {
+        if (!self->accepting) {
+            self->accept = socket_accept_future_create(self->listen_fd, self->fds, ACCEPT_BATCH);
+            self->accepting = true;
+        }
+        FutureState state = self->accept.base.progress(&self->accept.base, mio, waker);
+        if (state == FUTURE_PENDING)
+            return FUTURE_PENDING;
+        assert(state == FUTURE_COMPLETED && self->accept.accepted > 0);
+        for (size_t i = 0; i < self->accept.accepted; i++) {
+            EchoFuture* echo = executor_alloc_future(self->executor, sizeof(EchoFuture));
+            assert(echo);
+            *echo = (EchoFuture) { .base = future_create(echo_progress), .fd = self->fds[i] };
+            echo->recv = socket_recv_future_create(echo->fd, echo->buffer, sizeof(echo->buffer));
+            ASSERT_SYS_OK(executor_spawn_detached(
+                self->executor, &echo->base, echo_done, echo_destroy, self->executor));
+        }
+        if (self->accept.accepted > self->max_batch)
+            self->max_batch = self->accept.accepted;
+        self->to_accept -= self->accept.accepted;
+        self->accepting = false;
+    }
+    return FUTURE_COMPLETED;
+}
+
+/** Connects, then sends ROUNDS messages, each time receiving the echo before the next. */
+typedef struct ClientFuture {
+    Future base;
+    int fd;
+    int round; // -1 while connecting.
+    bool receiving;
+    SocketConnectFuture connect;
+    SocketSendFuture send;
+    SocketRecvFuture recv;
+    uint8_t request[MESSAGE_SIZE];
+    uint8_t reply[MESSAGE_SIZE];
+} ClientFuture;
+
+static FutureState client_progress(Future* base, Mio* mio, Waker waker)
+{
+    ClientFuture* self = (ClientFuture*)base;
+    if (self->round == -1) {
+        FutureState state = self->connect.base.progress(&self->connect.base, mio, waker);
+        if (state == FUTURE_PENDING)
+            return FUTURE_PENDING;
+        assert(state == FUTURE_COMPLETED);
+        self->round = 0;
+        self->send = socket_send_future_create(self->fd, self->request, MESSAGE_SIZE);
+    }
+    while (self->round < ROUNDS) {
+        FutureState state;
+        if (!self->receiving) {
+            state = self->send.base.progress(&self->send.base, mio, waker);
+            if (state == FUTURE_PENDING)
+                return FUTURE_PENDING;
+            assert(state == FUTURE_COMPLETED);
+            self->recv = socket_recv_future_create(self->fd, self->reply, MESSAGE_SIZE);
+            self->recv.min = MESSAGE_SIZE;
+            self->receiving = true;
+        }
+        state = self->recv.base.progress(&self->recv.base, mio, waker);
+        if (state == FUTURE_PENDING)
+            return FUTURE_PENDING;
+        assert(state == FUTURE_COMPLETED && memcmp(self->reply, self->request, MESSAGE_SIZE) == 0);
+        self->round++;
+        self->request[self->round % MESSAGE_SIZE]++;
+        self->send = socket_send_future_create(self->fd, self->request, MESSAGE_SIZE);
+        self->receiving = false;
+    }
+    ASSERT_SYS_OK(socket_close(mio, self->fd));
+    return FUTURE_COMPLETED;
+}
+
+static void test_echo(int family, MioBackend backend, size_t n_threads)
+{
+    static ClientFuture clients[N_CLIENTS];
+    static ServerFuture server;
+    ExecutorConfig config = executor_config_default();
+    config.n_threads = n_threads;
+    config.mio.backend = backend;
+    Executor* executor = executor_create_with_config(&config);
+    Listener listener = listen_on(family);
+    atomic_store(&echoes_done, 0);
+
+    // The clients first: their connections are all pending when the server first accepts.
+    for (int i = 0; i < N_CLIENTS; i++) {
+        int const fd = socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        ASSERT_SYS_OK(fd);
+        clients[i]
+            = (ClientFuture) { .base = future_create(client_progress), .fd = fd, .round = -1 };
+        clients[i].connect
+            = socket_connect_future_create(fd, (struct sockaddr*)&listener.addr, listener.addrlen);
+        memset(clients[i].request, 'a' + i % 26, MESSAGE_SIZE);
+        ASSERT_SYS_OK(executor_spawn(executor, &clients[i].base));
+    }
+    server = (ServerFuture) {
+        .base = future_create(server_progress),
+        .executor = executor,
+        .listen_fd = listener.fd,
+        .to_accept = N_CLIENTS,
+    };
+    ASSERT_SYS_OK(executor_spawn(executor, &server.base));
+    executor_run(executor);
+
+    for (int i = 0; i < N_CLIENTS; i++)
+        assert(!clients[i].base.is_active && clients[i].round == ROUNDS);
+    assert(!server.base.is_active && atomic_load(&echoes_done) == N_CLIENTS);
+    printf("%s, %zu thread(s): %d connections accepted, at most %zu at once\n",
+        family == AF_INET ? "tcp" : "unix", n_threads, N_CLIENTS, server.max_batch);
+    if (n_threads == 0)
+        assert(server.max_batch > 1); // Several connections per readiness.
+
+    listener_close(&listener, executor_mio(executor));
+    executor_destroy(executor);
+}
+
+/** Transfers much more than the socket buffers hold, in both directions of one socket pair. */
+static void test_partial_progress(void)
+{
+    enum { N = 1 << 20 };
+    static uint8_t out[N], in[N];
+    for (size_t i = 0; i < N; i++)
+        out[i] = (uint8_t)(i * 13 + i / 4096);
+    int fds[2];
+    ASSERT_SYS_OK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds));
+    Executor* executor = executor_create(0);
+    Mio* mio = executor_mio(executor);
+
+    SocketSendFuture send = socket_send_future_create(fds[0], out, N);
+    SocketRecvFuture recv = socket_recv_future_create(fds[1], in, N);
+    recv.min = N;
+    executor_spawn(executor, &recv.base);
+    executor_spawn(executor, &send.base);
+    executor_run(executor);
+    assert(send.base.errcode == FUTURE_SUCCESS && send.sent == N);
+    assert(recv.base.errcode == FUTURE_SUCCESS && recv.received == N);
+    assert(memcmp(in, out, N) == 0);
+
+    // Whatever is there, by default.
+    ASSERT_SYS_OK(write(fds[0], "0123456789", 10));
+    recv = socket_recv_future_create(fds[1], in, 100);
+    executor_spawn(executor, &recv.base);
+    executor_run(executor);
+    assert(recv.base.errcode == FUTURE_SUCCESS && recv.received == 10);
+
+    // The peer closes the connection: EOF when receiving, EPIPE (and no SIGPIPE) when sending.
+    ASSERT_SYS_OK(socket_close(mio, fds[0]));
+    recv = socket_recv_future_create(fds[1], in, 100);
+    send = socket_send_future_create(fds[1], out, 100);
+    executor_spawn(executor, &recv.base);
+    executor_spawn(executor, &send.base);
+    executor_run(executor);
+    assert(recv.base.errcode == SOCKET_FUTURE_ERR_EOF && recv.received == 0);
+    assert(send.base.errcode == SOCKET_FUTURE_ERR_IO && send.error == EPIPE);
+
+    ASSERT_SYS_OK(socket_close(mio, fds[1]));
+    executor_destroy(executor);
+}
+
+/** Connecting to a port nobody listens on fails with ECONNREFUSED; to an oversized address, with
+ *  EINVAL. */
+static void test_connect_refused(void)
+{
+    // Bound but not listening: the port is taken, and connections are refused.
+    int const bound = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t addrlen = sizeof(addr);
+    ASSERT_SYS_OK(bind(bound, (struct sockaddr*)&addr, addrlen));
+    ASSERT_SYS_OK(getsockname(bound, (struct sockaddr*)&addr, &addrlen));
+
+    Executor* executor = executor_create(0);
+    int const fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    SocketConnectFuture connect
+        = socket_connect_future_create(fd, (struct sockaddr*)&addr, addrlen);
+    executor_spawn(executor, &connect.base);
+    executor_run(executor);
+    assert(connect.base.errcode == SOCKET_FUTURE_ERR_IO && connect.error == ECONNREFUSED);
+
+    connect = socket_connect_future_create(
+        fd, (struct sockaddr*)&addr, sizeof(struct sockaddr_storage) + 1);
+    executor_spawn(executor, &connect.base);
+    executor_run(executor);
+    assert(connect.base.errcode == SOCKET_FUTURE_ERR_IO && connect.error == EINVAL);
+
+    ASSERT_SYS_OK(socket_close(executor_mio(executor), fd));
+    executor_destroy(executor);
+    ASSERT_SYS_OK(close(bound));
+}
+
+static int udp_socket_bound(struct sockaddr_in* addr)
+{
+    int const fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    ASSERT_SYS_OK(fd);
+    *addr = (struct sockaddr_in) {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t addrlen = sizeof(*addr);
+    ASSERT_SYS_OK(bind(fd, (struct sockaddr*)addr, addrlen));
+    ASSERT_SYS_OK(getsockname(fd, (struct sockaddr*)addr, &addrlen));
+    return fd;
+}
+
+/** Batches of datagrams, received by a future that waits before they are sent, in one recvmmsg. */
+static void test_udp_batch(MioBackend backend)
+{
+    ExecutorConfig config = executor_config_default();
+    config.mio.backend = backend;
+    Executor* executor = executor_create_with_config(&config);
+    struct sockaddr_in receiver_addr, sender_addr;
+    int const receiver = udp_socket_bound(&receiver_addr);
+    int const sender = udp_socket_bound(&sender_addr);
+
+    static uint8_t out[UDP_BATCH][MESSAGE_SIZE], in[2 * UDP_BATCH][MESSAGE_SIZE];
+    struct iovec out_iov[UDP_BATCH], in_iov[2 * UDP_BATCH];
+    struct mmsghdr out_msgs[UDP_BATCH], in_msgs[2 * UDP_BATCH];
+    struct sockaddr_in sources[2 * UDP_BATCH];
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < UDP_BATCH; i++) {
+            size_t const len = 1 + (round + i) % MESSAGE_SIZE; // Datagrams keep their bounds.
+            memset(out[i], round * UDP_BATCH + i, len);
+            out_iov[i] = (struct iovec) { .iov_base = out[i], .iov_len = len };
+            out_msgs[i] = (struct mmsghdr) { .msg_hdr = {
+                .msg_name = &receiver_addr, .msg_namelen = sizeof(receiver_addr),
+                .msg_iov = &out_iov[i], .msg_iovlen = 1 } };
+        }
+        for (int i = 0; i < 2 * UDP_BATCH; i++) {
+            in_iov[i] = (struct iovec) { .iov_base = in[i], .iov_len = MESSAGE_SIZE };
+            in_msgs[i] = (struct mmsghdr) { .msg_hdr = {
+                .msg_name = &sources[i], .msg_namelen = sizeof(sources[i]),
+                .msg_iov = &in_iov[i], .msg_iovlen = 1 } };
+        }
+
+        UdpRecvBatchFuture recv = udp_recv_batch_future_create(receiver, in_msgs, 2 * UDP_BATCH);
+        UdpSendBatchFuture send = udp_send_batch_future_create(sender, out_msgs, UDP_BATCH);
+        ASSERT_SYS_OK(executor_spawn(executor, &recv.base));
+        ASSERT_SYS_OK(executor_spawn(executor, &send.base));
+        executor_run(executor);
+
+        assert(send.base.ok == out_msgs && send.done == UDP_BATCH);
+        // Loopback delivers in sendmmsg(), so the receiver is woken with the whole batch queued.
+        assert(recv.base.ok == in_msgs && recv.done == UDP_BATCH);
+        for (int i = 0; i < UDP_BATCH; i++) {
+            assert(in_msgs[i].msg_len == out_iov[i].iov_len);
+            assert(memcmp(in[i], out[i], in_msgs[i].msg_len) == 0);
+            assert(in_msgs[i].msg_hdr.msg_namelen == sizeof(sender_addr));
+            assert(sources[i].sin_port == sender_addr.sin_port);
+        }
+    }
+
+    // A connected socket gets the ICMP "port unreachable" of what it sent as a receive error.
+    ASSERT_SYS_OK(connect(sender, (struct sockaddr*)&receiver_addr, sizeof(receiver_addr)));
+    ASSERT_SYS_OK(socket_close(executor_mio(executor), receiver));
+    out_msgs[0].msg_hdr.msg_name = NULL;
+    out_msgs[0].msg_hdr.msg_namelen = 0;
+    UdpSendBatchFuture send = udp_send_batch_future_create(sender, out_msgs, 1);
+    UdpRecvBatchFuture recv = udp_recv_batch_future_create(sender, in_msgs, 2 * UDP_BATCH);
+    ASSERT_SYS_OK(executor_spawn(executor, &send.base));
+    ASSERT_SYS_OK(executor_spawn(executor, &recv.base));
+    executor_run(executor);
+    assert(send.done == 1);
+    assert(recv.base.errcode == SOCKET_FUTURE_ERR_IO && recv.error == ECONNREFUSED);
+
+    ASSERT_SYS_OK(socket_close(executor_mio(executor), sender));
+    executor_destroy(executor);
+    printf("UDP batches: OK (backend %d)\n", backend);
+}
+
+/** The socket futures whose waker test_detached_freed checks. */
+typedef enum { STALE_RECV, STALE_SEND, STALE_UDP_RECV } StaleKind;
+
+static uint8_t stale_buffer[64 * 1024];
+
+/** Fills a socket, down to the last byte: a send would wait. */
+static void fill_socket(int fd)
+{
+    for (size_t size = sizeof(stale_buffer); size > 0; size /= 2)
+        while (send(fd, stale_buffer, size, MSG_DONTWAIT) > 0)
+            continue;
+}
+
+/** Makes the socket of the future under test (fds[0]) ready, or ready again. */
+static void stale_trigger(StaleKind kind, int const fds[2])
+{
+    if (kind == STALE_SEND) {
+        fill_socket(fds[0]); // If not full already; then drain its peer: EPOLLOUT (again).
+        while (recv(fds[1], stale_buffer, sizeof(stale_buffer), MSG_DONTWAIT) > 0)
+            continue;
+    } else {
+        ASSERT_SYS_OK(send(fds[1], "x", 1, 0));
+    }
+}
+
+/** Spawns a detached, malloc'ed socket future that has to wait, then has its socket made ready
+ *  once it completed and was freed. */
+typedef struct StaleDriverFuture {
+    Future base;
+    Executor* executor;
+    StaleKind kind;
+    int fds[2];
+    int step;
+    bool completed;
+    Waker waker;
+    SleepFuture sleep;
+} StaleDriverFuture;
+
+static void stale_completed(Future* fut, FutureState state, void* ctx)
+{
+    StaleDriverFuture* driver = ctx;
+    assert(state == FUTURE_COMPLETED);
+    driver->completed = true;
+    waker_wake(&driver->waker);
+}
+
+static void stale_free(Future* fut, void* ctx)
+{
+    free(fut);
+}
+
+static Future* stale_future_create(StaleKind kind, int fd)
+{
+    static uint8_t buffer[16];
+    static struct iovec iov = { .iov_base = buffer, .iov_len = sizeof(buffer) };
+    static struct mmsghdr msg = { .msg_hdr = { .msg_iov = &iov, .msg_iovlen = 1 } };
+    switch (kind) {
+    case STALE_RECV: {
+        SocketRecvFuture* fut = malloc(sizeof(*fut));
+        *fut = socket_recv_future_create(fd, buffer, sizeof(buffer));
+        return &fut->base;
+    }
+    case STALE_SEND: {
+        SocketSendFuture* fut = malloc(sizeof(*fut));
+        *fut = socket_send_future_create(fd, buffer, 1);
+        return &fut->base;
+    }
+    default: {
+        UdpRecvBatchFuture* fut = malloc(sizeof(*fut));
+        *fut = udp_recv_batch_future_create(fd, &msg, 1);
+        return &fut->base;
+    }
+    }
+}
+
+static FutureState stale_driver_progress(Future* base, Mio* mio, Waker waker)
+{
+    StaleDriverFuture* self = (StaleDriverFuture*)base;
+    self->waker = waker;
+    switch (self->step++) {
+    case 0: {
+        if (self->kind == STALE_SEND)
+            fill_socket(self->fds[0]); // So that the send waits.
+        Future* fut = stale_future_create(self->kind, self->fds[0]);
+        ASSERT_SYS_OK(
+            executor_spawn_detached(self->executor, fut, stale_completed, stale_free, self));
+        waker_wake(&waker); // Queued after the future, which waits for its socket first.
+        return FUTURE_PENDING;
+    }
+    case 1:
+        assert(!self->completed);
+        stale_trigger(self->kind, self->fds);
+        return FUTURE_PENDING; // Until woken by stale_completed.
+    case 2:
+        assert(self->completed);
+        stale_trigger(self->kind, self->fds); // Must wake nobody.
+        self->sleep = sleep_future_create(20); // Meanwhile, Mio polls the socket's event.
+        // fall through
+    default:
+        return self->sleep.base.progress(&self->sleep.base, mio, waker);
+    }
+}
+
+/** A socket future that completes must not leave its waker registered with the socket it keeps
+ *  registered (for the next future): it may be freed right away. */
+static void test_detached_freed(StaleKind kind)
+{
+    static StaleDriverFuture driver;
+    Executor* executor = executor_create(0);
+    driver = (StaleDriverFuture) {
+        .base = future_create(stale_driver_progress),
+        .executor = executor,
+        .kind = kind,
+    };
+    if (kind == STALE_UDP_RECV) {
+        struct sockaddr_in addr, peer_addr;
+        driver.fds[0] = udp_socket_bound(&addr);
+        driver.fds[1] = udp_socket_bound(&peer_addr);
+        ASSERT_SYS_OK(connect(driver.fds[1], (struct sockaddr*)&addr, sizeof(addr)));
+    } else {
+        ASSERT_SYS_OK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, driver.fds));
+    }
+
+    ASSERT_SYS_OK(executor_spawn(executor, &driver.base));
+    executor_run(executor);
+    assert(driver.completed && !driver.base.is_active);
+    ExecutorStats stats;
+    executor_stats(executor, &stats);
+    assert(stats.wakes_stale == 0);
+
+    ASSERT_SYS_OK(socket_close(executor_mio(executor), driver.fds[0]));
+    ASSERT_SYS_OK(close(driver.fds[1]));
+    executor_destroy(executor);
+}
+
+int main()
+{
+    test_echo(AF_INET, MIO_BACKEND_EPOLL, 0);
+    test_echo(AF_INET, MIO_BACKEND_EPOLL, 2);
+    test_echo(AF_INET, MIO_BACKEND_IO_URING, 0);
+    test_echo(AF_UNIX, MIO_BACKEND_EPOLL, 0);
+    test_echo(AF_UNIX, MIO_BACKEND_EPOLL, 2);
+    test_partial_progress();
+    test_connect_refused();
+    test_udp_batch(MIO_BACKEND_EPOLL);
+    test_udp_batch(MIO_BACKEND_IO_URING);
+    test_detached_freed(STALE_RECV);
+    test_detached_freed(STALE_SEND);
+    test_detached_freed(STALE_UDP_RECV);
+    printf("OK\n");
+    return 0;
+}
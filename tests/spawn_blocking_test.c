@@ -0,0 +1,177 @@
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "err.h"
+#include "executor.h"
+#include "future.h"
+#include "future_examples.h"
+#include "mio.h"
+
+#define STAGES 10
+#define UI_PERIOD_MS 10
+#define STAGE_TIMEOUT_MS 10000 // Only reached if the UI future stalls while a stage runs.
+#define N_DETACHED 2000
+
+static atomic_int displays;
+
+/**
+ * One stage of hard work: a blocking call that returns only once the UI future was displayed twice
+ * meanwhile. On the executor's thread (as inline work would be), it would never return in time.
+ */
+static void* blocking_stage(void* arg)
+{
+    int const start = atomic_load(&displays);
+    uint64_t const deadline = mio_now_ms() + STAGE_TIMEOUT_MS;
+    while (atomic_load(&displays) < start + 2) {
+        if (mio_now_ms() > deadline)
+            return (void*)0;
+        usleep(1000);
+    }
+    return (void*)1;
+}
+
+/** Runs STAGES blocking stages in turn, each on the executor's blocking threads. */
+typedef struct StagesFuture {
+    Future base;
+    SpawnBlockingFuture stage;
+    int done;
+    int stalled; // Stages that timed out waiting for displays.
+} StagesFuture;
+
+static FutureState stages_progress(Future* base, Mio* mio, Waker waker)
+{
+    StagesFuture* self = (StagesFuture*)base;
+    while (self->stage.base.progress(&self->stage.base, mio, waker) == FUTURE_COMPLETED) {
+        if (self->stage.base.ok == NULL)
+            self->stalled++;
+        if (++self->done == STAGES)
+            return FUTURE_COMPLETED;
+        self->stage = spawn_blocking_future_create(blocking_stage, NULL);
+    }
+    return FUTURE_PENDING;
+}
+
+/** "Displays" every UI_PERIOD_MS until the stages are done. */
+typedef struct UiFuture {
+    Future base;
+    SleepFuture tick;
+    StagesFuture const* stages;
+} UiFuture;
+
+static FutureState ui_progress(Future* base, Mio* mio, Waker waker)
+{
+    UiFuture* self = (UiFuture*)base;
+    while (self->tick.base.progress(&self->tick.base, mio, waker) == FUTURE_COMPLETED) {
+        atomic_fetch_add(&displays, 1);
+        if (self->stages->done == STAGES)
+            return FUTURE_COMPLETED;
+        self->tick = sleep_future_create(UI_PERIOD_MS);
+    }
+    return FUTURE_PENDING;
+}
+
+/** The UI future keeps being progressed while each blocking stage runs: checked by ordering (each
+ *  stage waits for displays), not by timing, so a loaded machine only makes it slower. */
+static void test_responsive(size_t n_threads)
+{
+    ExecutorConfig config = executor_config_default();
+    config.n_threads = n_threads;
+    Executor* executor = executor_create_with_config(&config);
+    atomic_store(&displays, 0);
+    StagesFuture stages = {
+        .base = future_create(stages_progress),
+        .stage = spawn_blocking_future_create(blocking_stage, NULL),
+    };
+    UiFuture ui = {
+        .base = future_create(ui_progress),
+        .tick = sleep_future_create(0),
+        .stages = &stages,
+    };
+    ASSERT_SYS_OK(executor_spawn(executor, &stages.base));
+    ASSERT_SYS_OK(executor_spawn(executor, &ui.base));
+    executor_run(executor);
+
+    printf("threads=%zu: %d stages, %d displays\n", n_threads, stages.done,
+        atomic_load(&displays));
+    assert(stages.done == STAGES && stages.stalled == 0);
+    executor_destroy(executor);
+}
+
+static void* identity(void* arg)
+{
+    return arg;
+}
+
+static atomic_int detached_done;
+
+static void detached_completed(Future* fut, FutureState state, void* ctx)
+{
+    assert(state == FUTURE_COMPLETED && fut->ok == fut->arg);
+    atomic_fetch_add(&detached_done, 1);
+}
+
+static void detached_free(Future* fut, void* ctx)
+{
+    free(fut);
+}
+
+/** Detached SpawnBlockingFutures freed as soon as they complete: the pool thread's wake must not
+ *  reach one after that (checked by ASAN in Debug builds). */
+static void test_detached_freed(size_t n_threads)
+{
+    ExecutorConfig config = executor_config_default();
+    config.n_threads = n_threads;
+    Executor* executor = executor_create_with_config(&config);
+    atomic_store(&detached_done, 0);
+    for (intptr_t i = 0; i < N_DETACHED; i++) {
+        SpawnBlockingFuture* fut = malloc(sizeof(*fut));
+        assert(fut);
+        *fut = spawn_blocking_future_create(identity, (void*)i);
+        ASSERT_SYS_OK(
+            executor_spawn_detached(executor, &fut->base, detached_completed, detached_free, NULL));
+    }
+    executor_run(executor);
+    assert(atomic_load(&detached_done) == N_DETACHED);
+    executor_destroy(executor);
+}
+
+static void detached_sleep_completed(Future* fut, FutureState state, void* ctx)
+{
+    assert(state == FUTURE_COMPLETED);
+    atomic_fetch_add(&detached_done, 1);
+}
+
+/** The same for detached SleepFutures: the poller's timer wake must not reach one after that. */
+static void test_detached_sleeps_freed(size_t n_threads)
+{
+    ExecutorConfig config = executor_config_default();
+    config.n_threads = n_threads;
+    Executor* executor = executor_create_with_config(&config);
+    atomic_store(&detached_done, 0);
+    for (int i = 0; i < N_DETACHED; i++) {
+        SleepFuture* fut = malloc(sizeof(*fut));
+        assert(fut);
+        *fut = sleep_future_create(i % 3);
+        ASSERT_SYS_OK(executor_spawn_detached(
+            executor, &fut->base, detached_sleep_completed, detached_free, NULL));
+    }
+    executor_run(executor);
+    assert(atomic_load(&detached_done) == N_DETACHED);
+    executor_destroy(executor);
+}
+
+int main()
+{
+    test_responsive(0);
+    test_responsive(2);
+    test_detached_freed(0);
+    test_detached_freed(2);
+    test_detached_sleeps_freed(0);
+    test_detached_sleeps_freed(4);
+    printf("OK\n");
+    return 0;
+}
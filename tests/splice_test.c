@@ -0,0 +1,128 @@
+// Required for `unistd.h` include to contain `pipe2`.
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "err.h"
+#include "executor.h"
+#include "future.h"
+#include "future_examples.h"
+
+#define N_BYTES (1024 * 1024) // Many times the capacity of a pipe.
+
+static uint8_t data[N_BYTES];
+static uint8_t received[N_BYTES];
+static uint8_t received_copy[N_BYTES];
+
+static void fill_data(void)
+{
+    for (size_t i = 0; i < N_BYTES; i++)
+        data[i] = (uint8_t)(i * 7 + i / 1000);
+}
+
+/** Writes `data` to `in`, forwards `in` to `out` with a SpliceFuture, and reads `out` (and the
+ * `tee` copy, if any), all at once on one executor. */
+static void forward(int in_writer, int in, int out, int out_reader, int tee, int tee_reader)
+{
+    memset(received, 0, N_BYTES);
+    memset(received_copy, 0, N_BYTES);
+    Executor* executor = executor_create(0);
+    PipeWriteFuture write = pipe_write_future_create(in_writer, N_BYTES, false);
+    write.base.arg = data;
+    SpliceFuture splice = splice_tee_future_create(in, out, tee, N_BYTES);
+    PipeReadFuture read = pipe_read_future_create(out_reader, received, N_BYTES);
+    PipeReadFuture read_copy = pipe_read_future_create(tee_reader, received_copy, N_BYTES);
+    executor_spawn(executor, (Future*)&write);
+    executor_spawn(executor, (Future*)&splice);
+    executor_spawn(executor, (Future*)&read);
+    if (tee != -1)
+        executor_spawn(executor, (Future*)&read_copy);
+    executor_run(executor);
+
+    assert(splice.base.errcode == FUTURE_SUCCESS && splice.moved == N_BYTES);
+    assert(splice.ring == NULL);
+    assert(read.base.errcode == FUTURE_SUCCESS && memcmp(received, data, N_BYTES) == 0);
+    if (tee != -1)
+        assert(read_copy.base.errcode == FUTURE_SUCCESS
+            && memcmp(received_copy, data, N_BYTES) == 0);
+    executor_destroy(executor);
+}
+
+static void test_splice_pipes(void)
+{
+    int in[2], out[2], copy[2];
+    ASSERT_SYS_OK(pipe2(in, O_NONBLOCK));
+    ASSERT_SYS_OK(pipe2(out, O_NONBLOCK));
+    ASSERT_SYS_OK(pipe2(copy, O_NONBLOCK));
+    forward(in[1], in[0], out[1], out[0], -1, -1);
+    forward(in[1], in[0], out[1], out[0], copy[1], copy[0]);
+    for (int i = 0; i < 2; i++) {
+        ASSERT_SYS_OK(close(in[i]));
+        ASSERT_SYS_OK(close(out[i]));
+        ASSERT_SYS_OK(close(copy[i]));
+    }
+}
+
+static void test_copy_fallback(void)
+{
+    // Neither end of the SpliceFuture is a pipe: splice() fails with EINVAL.
+    int in[2], out[2];
+    ASSERT_SYS_OK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, in));
+    ASSERT_SYS_OK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, out));
+    forward(in[1], in[0], out[1], out[0], -1, -1);
+    for (int i = 0; i < 2; i++) {
+        ASSERT_SYS_OK(close(in[i]));
+        ASSERT_SYS_OK(close(out[i]));
+    }
+}
+
+static void test_eof(bool sockets)
+{
+    int in[2], out[2];
+    if (sockets) {
+        ASSERT_SYS_OK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, in));
+        ASSERT_SYS_OK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, out));
+    } else {
+        ASSERT_SYS_OK(pipe2(in, O_NONBLOCK));
+        ASSERT_SYS_OK(pipe2(out, O_NONBLOCK));
+    }
+    Executor* executor = executor_create(0);
+
+    // Until EOF: completes with whatever came.
+    ASSERT_SYS_OK(write(in[1], "hello", 5));
+    ASSERT_SYS_OK(close(in[1]));
+    SpliceFuture splice = splice_future_create(in[0], out[1], SPLICE_UNTIL_EOF);
+    executor_spawn(executor, (Future*)&splice);
+    executor_run(executor);
+    assert(splice.base.errcode == FUTURE_SUCCESS && splice.moved == 5);
+    char buffer[8];
+    assert(read(out[0], buffer, sizeof(buffer)) == 5 && memcmp(buffer, "hello", 5) == 0);
+
+    // A fixed length, but the source closes first.
+    splice = splice_future_create(in[0], out[1], 10);
+    executor_spawn(executor, (Future*)&splice);
+    executor_run(executor);
+    assert(splice.base.errcode == PIPE_FUTURE_ERR_EOF && splice.moved == 0);
+
+    executor_destroy(executor);
+    ASSERT_SYS_OK(close(in[0]));
+    ASSERT_SYS_OK(close(out[0]));
+    ASSERT_SYS_OK(close(out[1]));
+}
+
+int main()
+{
+    fill_data();
+    test_splice_pipes();
+    test_copy_fallback();
+    test_eof(false);
+    test_eof(true);
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,199 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "err.h"
+#include "executor.h"
+#include "future.h"
+#include "future_combinators.h"
+#include "future_examples.h"
+#include "mio.h"
+#include "timer_wheel.h"
+
+#define N_WHEEL_TIMERS 20000
+#define N_SLEEPS 1000
+#define N_DEADLINES 100
+
+/** Checks the wheel against a brute-force scan: timers expire exactly once their deadline passed. */
+static void test_wheel(void)
+{
+    static MioTimer timers[N_WHEEL_TIMERS];
+    static bool cancelled[N_WHEEL_TIMERS];
+    static bool expired[N_WHEEL_TIMERS];
+    uint64_t const start = 1000;
+    TimerWheel wheel;
+    timer_wheel_init(&wheel, start);
+    srand(42);
+
+    // Deadlines at every scale: within the first slots, across levels, and beyond the last level.
+    for (int i = 0; i < N_WHEEL_TIMERS; i++) {
+        timers[i] = mio_timer_create();
+        uint64_t span = (uint64_t)1 << (rand() % 40);
+        timers[i].deadline = start + 1 + (uint64_t)rand() % span;
+        timer_wheel_insert(&wheel, &timers[i]);
+    }
+    for (int i = 0; i < N_WHEEL_TIMERS; i += 3) {
+        timer_wheel_remove(&wheel, &timers[i]);
+        cancelled[i] = true;
+    }
+
+    uint64_t now = start;
+    size_t remaining = timer_wheel_size(&wheel);
+    while (remaining > 0) {
+        uint64_t next = timer_wheel_next_expiration(&wheel);
+        assert(next != UINT64_MAX && next > now);
+        for (int i = 0; i < N_WHEEL_TIMERS; i++)
+            assert(cancelled[i] || expired[i] || timers[i].deadline >= next);
+
+        // Jump straight to the next expiration, or a bit further.
+        now = next + (rand() % 4 == 0 ? (uint64_t)rand() % 1000 : 0);
+        timer_wheel_advance(&wheel, now);
+        MioTimer* timer;
+        while ((timer = timer_wheel_pop_expired(&wheel)) != NULL) {
+            int i = timer - timers;
+            assert(!cancelled[i] && !expired[i]);
+            assert(timer->deadline <= now);
+            expired[i] = true;
+            remaining--;
+        }
+        assert(timer_wheel_size(&wheel) == remaining);
+        for (int i = 0; i < N_WHEEL_TIMERS; i++)
+            assert(cancelled[i] || expired[i] || timers[i].deadline > now);
+    }
+    assert(timer_wheel_next_expiration(&wheel) == UINT64_MAX);
+}
+
+/** Sleeps of random lengths on an executor: each ends no earlier than its deadline. */
+static void test_sleeps(size_t n_threads)
+{
+    ExecutorConfig config = executor_config_default();
+    config.n_threads = n_threads;
+    Executor* executor = executor_create_with_config(&config);
+
+    static SleepFuture sleeps[N_SLEEPS];
+    uint64_t const start = mio_now_ms();
+    for (int i = 0; i < N_SLEEPS; i++) {
+        sleeps[i] = sleep_future_create(rand() % 200);
+        executor_spawn(executor, (Future*)&sleeps[i]);
+    }
+    executor_run(executor);
+    uint64_t const elapsed = mio_now_ms() - start;
+
+    for (int i = 0; i < N_SLEEPS; i++) {
+        assert(!sleeps[i].base.is_active);
+        assert(!atomic_load(&sleeps[i].timer.pending));
+        assert(sleeps[i].timer.deadline >= start + sleeps[i].duration_ms);
+    }
+    MioStats stats;
+    mio_stats(executor_mio(executor), &stats);
+    printf("%zu thread(s): %d sleeps in %llu ms, %llu polls\n", n_threads, N_SLEEPS,
+        (unsigned long long)elapsed, (unsigned long long)stats.polls);
+    assert(stats.timers_fired == N_SLEEPS);
+    assert(elapsed >= 190 && elapsed < 2000);
+    executor_destroy(executor);
+}
+
+/** Busy for a while, then sleeps briefly, recording when it is done. */
+typedef struct LateSleepFuture {
+    Future base;
+    SleepFuture sleep;
+    bool started;
+    uint64_t done_at;
+} LateSleepFuture;
+
+static FutureState late_sleep_progress(Future* base, Mio* mio, Waker waker)
+{
+    LateSleepFuture* self = (LateSleepFuture*)base;
+    if (!self->started) {
+        self->started = true;
+        struct timespec busy = { .tv_sec = 0, .tv_nsec = 50 * 1000000 };
+        nanosleep(&busy, NULL);
+    }
+    FutureState state = self->sleep.base.progress((Future*)&self->sleep, mio, waker);
+    if (state == FUTURE_COMPLETED)
+        self->done_at = mio_now_ms();
+    return state;
+}
+
+/** A timer armed while another worker waits for a later one must cut that wait short. */
+static void test_earlier_deadline_interrupts_poll(void)
+{
+    Executor* executor = executor_create_multi(2, 0);
+    SleepFuture long_sleep = sleep_future_create(1000);
+    LateSleepFuture late = {
+        .base = future_create(late_sleep_progress),
+        .sleep = sleep_future_create(10),
+    };
+    uint64_t const start = mio_now_ms();
+    executor_spawn(executor, (Future*)&long_sleep);
+    executor_spawn(executor, (Future*)&late);
+    executor_run(executor);
+
+    printf("short sleep done after %llu ms, long one after %llu ms\n",
+        (unsigned long long)(late.done_at - start), (unsigned long long)(mio_now_ms() - start));
+    assert(late.done_at - start < 500);
+    executor_destroy(executor);
+}
+
+/** A short sleep raced against a long deadline, freed once it completes. */
+typedef struct DeadlineFuture {
+    Future base;
+    SelectFuture select;
+    SleepFuture work;
+    SleepFuture deadline;
+} DeadlineFuture;
+
+static FutureState deadline_progress(Future* base, Mio* mio, Waker waker)
+{
+    DeadlineFuture* self = (DeadlineFuture*)base;
+    FutureState state = self->select.base.progress(&self->select.base, mio, waker);
+    if (state != FUTURE_PENDING)
+        sleep_future_cancel(mio, &self->deadline); // The loser: unlink it before being freed.
+    return state;
+}
+
+static void deadline_free(Future* fut, void* ctx)
+{
+    free(fut);
+}
+
+/** Cancelled deadlines leave the wheel: the executor does not wait for them, nor wake them. */
+static void test_cancelled_deadlines(size_t n_threads)
+{
+    ExecutorConfig config = executor_config_default();
+    config.n_threads = n_threads;
+    Executor* executor = executor_create_with_config(&config);
+    uint64_t const start = mio_now_ms();
+    for (int i = 0; i < N_DEADLINES; i++) {
+        DeadlineFuture* fut = malloc(sizeof(*fut));
+        assert(fut);
+        fut->base = future_create(deadline_progress);
+        fut->work = sleep_future_create(i % 10);
+        fut->deadline = sleep_future_create(10000);
+        fut->select = future_select(&fut->work.base, &fut->deadline.base);
+        ASSERT_SYS_OK(executor_spawn_detached(executor, &fut->base, NULL, deadline_free, NULL));
+    }
+    executor_run(executor);
+    uint64_t const elapsed = mio_now_ms() - start;
+
+    MioStats stats;
+    mio_stats(executor_mio(executor), &stats);
+    printf("%zu thread(s): %d deadlines cancelled in %llu ms\n", n_threads, N_DEADLINES,
+        (unsigned long long)elapsed);
+    assert(stats.timers_fired == N_DEADLINES);
+    assert(elapsed < 5000);
+    executor_destroy(executor);
+}
+
+int main()
+{
+    test_wheel();
+    test_sleeps(0);
+    test_sleeps(4);
+    test_earlier_deadline_interrupts_poll();
+    test_cancelled_deadlines(0);
+    test_cancelled_deadlines(4);
+    printf("OK\n");
+    return 0;
+}
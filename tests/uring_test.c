@@ -0,0 +1,177 @@
+// Required for `unistd.h` include to contain `pipe2`.
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "err.h"
+#include "executor.h"
+#include "future.h"
+#include "future_combinators.h"
+#include "future_examples.h"
+#include "mio.h"
+#include "utils.h"
+
+static const char* backend_name(MioBackend backend)
+{
+    switch (backend) {
+    case MIO_BACKEND_EPOLL:
+        return "epoll";
+    case MIO_BACKEND_IO_URING:
+        return "io_uring";
+    case MIO_BACKEND_IO_URING_SQPOLL:
+        return "io_uring+sqpoll";
+    }
+    return "?";
+}
+
+/** Reads two slow pipes and round-trips a message through a third, on the given configuration. */
+static void run_pipes(MioBackend backend, size_t n_threads)
+{
+    ExecutorConfig config = executor_config_default();
+    config.n_threads = n_threads;
+    config.mio.backend = backend;
+    Executor* executor = executor_create_with_config(&config);
+    MioBackend actual = mio_backend(executor_mio(executor));
+    printf("%s on %zu thread(s): using %s\n", backend_name(backend), n_threads,
+        backend_name(actual));
+    assert(actual == backend || actual == MIO_BACKEND_EPOLL);
+    assert(mio_supports_submission(executor_mio(executor)) == (actual != MIO_BACKEND_EPOLL));
+
+    const char* message = "AAABBBCCCD";
+    int read_fd1 = create_example_read_pipe_end(message, 3, 0, 0);
+    int read_fd2 = create_example_read_pipe_end(message, 4, 0, 0);
+    uint8_t buffer1[strlen(message) + 1];
+    uint8_t buffer2[strlen(message) + 1];
+    PipeReadFuture r1 = pipe_read_future_create(read_fd1, buffer1, sizeof(buffer1));
+    PipeReadFuture r2 = pipe_read_future_create(read_fd2, buffer2, sizeof(buffer2));
+    JoinFuture join = future_join((Future*)&r1, (Future*)&r2);
+    executor_spawn(executor, (Future*)&join);
+
+    // A message larger than the pipe buffer, so both ends have to wait for each other.
+    static char big[1 << 17];
+    static uint8_t big_copy[sizeof(big)];
+    for (size_t i = 0; i < sizeof(big); ++i)
+        big[i] = 'a' + i % 26;
+    int fds[2];
+    ASSERT_SYS_OK(pipe2(fds, O_NONBLOCK | O_CLOEXEC));
+    PipeWriteFuture w = pipe_write_future_create(fds[1], sizeof(big), false);
+    w.base.arg = big;
+    PipeReadFuture r3 = pipe_read_future_create(fds[0], big_copy, sizeof(big_copy));
+    executor_spawn(executor, (Future*)&w);
+    executor_spawn(executor, (Future*)&r3);
+
+    executor_run(executor);
+
+    assert(join.base.errcode == FUTURE_SUCCESS);
+    assert(memcmp(buffer1, message, sizeof(buffer1)) == 0);
+    assert(memcmp(buffer2, message, sizeof(buffer2)) == 0);
+    assert(w.base.errcode == FUTURE_SUCCESS && r3.base.errcode == FUTURE_SUCCESS);
+    assert(memcmp(big_copy, big, sizeof(big)) == 0);
+
+    MioStats stats;
+    mio_stats(executor_mio(executor), &stats);
+    printf("  polls: %zu, submissions: %zu, syscalls: %zu\n", stats.polls, stats.submissions,
+        stats.ctl_syscalls);
+    if (actual != MIO_BACKEND_EPOLL)
+        assert(stats.submissions > 0);
+
+    executor_destroy(executor);
+    ASSERT_SYS_OK(close(read_fd1));
+    ASSERT_SYS_OK(close(read_fd2));
+    ASSERT_SYS_OK(close(fds[0]));
+    ASSERT_SYS_OK(close(fds[1]));
+}
+
+/** Waits (through readiness polls only) until a byte can be read from, or written to, its fd. */
+typedef struct ReadyFuture {
+    Future base;
+    int fd;
+    uint32_t events; // EPOLLIN or EPOLLOUT.
+} ReadyFuture;
+
+static FutureState ready_progress(Future* base, Mio* mio, Waker waker)
+{
+    ReadyFuture* self = (ReadyFuture*)base;
+    uint8_t byte = 0;
+    ssize_t const ret
+        = self->events == EPOLLIN ? read(self->fd, &byte, 1) : write(self->fd, &byte, 1);
+    if (ret == -1 && errno == EAGAIN) {
+        ASSERT_SYS_OK(mio_register(mio, self->fd, self->events, waker));
+        return FUTURE_PENDING;
+    }
+    assert(ret == 1);
+    ASSERT_SYS_OK(mio_unregister_events(mio, self->fd, self->events));
+    return FUTURE_COMPLETED;
+}
+
+/** Once the reader and writer wait, makes their fd readable then, a while later, writable. */
+typedef struct PeerFuture {
+    Future base;
+    int fd;
+    int step;
+} PeerFuture;
+
+static FutureState peer_progress(Future* base, Mio* mio, Waker waker)
+{
+    PeerFuture* self = (PeerFuture*)base;
+    static uint8_t drain[1 << 16];
+    switch (self->step++) {
+    case 0:
+        ASSERT_SYS_OK(write(self->fd, "x", 1));
+        waker_wake(&waker);
+        return FUTURE_PENDING;
+    case 1:
+        usleep(10000); // Let the reader's wake come through alone.
+        while (read(self->fd, drain, sizeof(drain)) > 0) { }
+        return FUTURE_COMPLETED;
+    }
+    return FUTURE_FAILURE;
+}
+
+/** A reader and a writer wait on the same socket at once: each is woken by its own direction. */
+static void run_duplex(MioBackend backend)
+{
+    ExecutorConfig config = executor_config_default();
+    config.mio.backend = backend;
+    Executor* executor = executor_create_with_config(&config);
+    int fds[2];
+    ASSERT_SYS_OK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds));
+    static uint8_t fill[1 << 16];
+    while (write(fds[0], fill, sizeof(fill)) > 0) { } // Nothing to read, no room to write.
+
+    ReadyFuture reader = { .base = future_create(ready_progress), .fd = fds[0], .events = EPOLLIN };
+    ReadyFuture writer = { .base = future_create(ready_progress), .fd = fds[0], .events = EPOLLOUT };
+    PeerFuture peer = { .base = future_create(peer_progress), .fd = fds[1] };
+    executor_spawn(executor, (Future*)&reader);
+    executor_spawn(executor, (Future*)&writer);
+    executor_spawn(executor, (Future*)&peer);
+    executor_run(executor);
+    assert(!reader.base.is_active && !writer.base.is_active && !peer.base.is_active);
+    printf("%s: reader and writer shared one fd\n",
+        backend_name(mio_backend(executor_mio(executor))));
+
+    executor_destroy(executor);
+    ASSERT_SYS_OK(close(fds[0]));
+    ASSERT_SYS_OK(close(fds[1]));
+}
+
+int main()
+{
+    // The same pipe futures must behave identically on every backend, with one or more threads.
+    MioBackend const backends[]
+        = { MIO_BACKEND_EPOLL, MIO_BACKEND_IO_URING, MIO_BACKEND_IO_URING_SQPOLL };
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); ++i) {
+        run_pipes(backends[i], 0);
+        run_pipes(backends[i], 4);
+        run_duplex(backends[i]);
+    }
+    printf("OK\n");
+    return 0;
+}